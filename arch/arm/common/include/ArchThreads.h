@@ -19,16 +19,17 @@ struct ArchThreadRegisters
   uint32 pc;
   uint32 ttbr0;
   uint32 sp0;
+
+  /**
+   * allocated from a KmemCache, see ArchThreads.cpp
+   */
+  static void* operator new(size_t size);
+  static void operator delete(void* address);
 };
 
 class Thread;
 class ArchMemory;
-/**
- * this is where the thread info for task switching is stored
- *
- */
-extern ArchThreadRegisters *currentThreadRegisters;
-extern Thread *currentThread;
+#include "ArchMulticore.h"
 
 /**
  * Collection of architecture dependant code concerning Task Switching
@@ -72,6 +73,15 @@ public:
  */
   static void createUserRegisters(ArchThreadRegisters *&info, void* start_function, void* user_stack, void* kernel_stack);
 
+/**
+ * creates the ArchThreadRegisters of a forked user thread: a copy of the registers the
+ * parent had when it entered the fork syscall, except that fork returns 0 in the child
+ * @param info where the ArchThreadRegisters is saved
+ * @param parent_info the user registers of the forking thread
+ * @param kernel_stack pointer to the kernel stack of the new thread
+ */
+  static void createForkedUserRegisters(ArchThreadRegisters *&info, ArchThreadRegisters* parent_info, void* kernel_stack);
+
 /**
  *
  * on x86: invokes int65, whose handler facilitates a task switch
@@ -7,8 +7,11 @@
 #include "FrameBufferConsole.h"
 #include "backtrace.h"
 #include "Stabs2DebugInfo.h"
+#include "ArchInterrupts.h"
+#include "Scheduler.h"
 
 #define PHYSICAL_MEMORY_AVAILABLE 8*1024*1024
+#define NOMINAL_TIMER_TICK_NS 10000000ULL
 
 extern void* kernel_end_address;
 
@@ -112,7 +115,14 @@ extern "C" void halt()
 void ArchCommon::idle()
 {
   ArchBoardSpecific::onIdle();
-  halt();
+  halt(); // wfi also wakes up on masked interrupts, they are taken right after enabling them
+  ArchInterrupts::enableInterrupts();
+}
+
+uint64 ArchCommon::getMonotonicTimeNs()
+{
+  // the boards do not tell us their timer frequency, this is only a rough estimate
+  return (uint64)Scheduler::instance()->getTicks() * NOMINAL_TIMER_TICK_NS;
 }
 
 
@@ -6,6 +6,7 @@
 #include "ArchThreads.h"
 #include "ArchBoardSpecific.h"
 #include "Thread.h"
+#include "assert.h"
 
 extern uint8 boot_stack[];
 
@@ -122,6 +123,16 @@ void ArchInterrupts::disableTimer()
   ArchBoardSpecific::disableTimer();
 }
 
+bool ArchInterrupts::enableOneShotTimer()
+{
+  return false; // the board timers keep running periodically
+}
+
+void ArchInterrupts::setOneShotTimer(uint64 ns __attribute__((unused)))
+{
+  assert(false && "there is no one-shot timer on this platform");
+}
+
 void ArchInterrupts::enableKBD()
 {
   ArchBoardSpecific::enableKBD();
@@ -55,6 +55,87 @@ ArchMemory::ArchMemory()
     new_page_directory[p].pt.size = PDE_SIZE_NONE;
 }
 
+ArchMemory::ArchMemory(ArchMemory& parent) : ArchMemory()
+{
+  PageDirEntry *parent_page_directory = (PageDirEntry *) getIdentAddressOfPPN(parent.page_dir_page_);
+  for (uint32 pde_vpn = 8; pde_vpn < PAGE_DIR_ENTRIES / 2; ++pde_vpn)
+  {
+    assert(parent_page_directory[pde_vpn].pt.size != PDE_SIZE_PAGE && "How the hell did a large page get into a page dir?");
+    if (parent_page_directory[pde_vpn].pt.size != PDE_SIZE_PT)
+      continue;
+    PageTableEntry *parent_pte_base = getIdentAddressOfPT(parent_page_directory, pde_vpn);
+    for (uint32 pte_vpn = 0; pte_vpn < PAGE_TABLE_ENTRIES; ++pte_vpn)
+    {
+      if (parent_pte_base[pte_vpn].size != PTE_SIZE_SMALL)
+        continue;
+      uint32 ppn = PageManager::instance()->allocPPN(PAGE_SIZE, PageManager::ALLOC_NO_ZERO);
+      memcpy((void*) getIdentAddressOfPPN(ppn),
+             (void*) getIdentAddressOfPPN(parent_pte_base[pte_vpn].page_ppn - PHYS_OFFSET_4K), PAGE_SIZE);
+      bool page_mapped = mapPage(pde_vpn * PAGE_TABLE_ENTRIES + pte_vpn, ppn,
+                                 parent_pte_base[pte_vpn].permissions == PAGE_PERMISSION_WRITE);
+      assert(page_mapped);
+    }
+  }
+}
+
+bool ArchMemory::copyOnWrite(uint32)
+{
+  return false;
+}
+
+bool ArchMemory::mapSharedPage(uint32 virtual_page, uint32 physical_page)
+{
+  uint32 ppn = PageManager::instance()->allocPPN(PAGE_SIZE, PageManager::ALLOC_NO_ZERO);
+  memcpy((void*) getIdentAddressOfPPN(ppn), (void*) getIdentAddressOfPPN(physical_page), PAGE_SIZE);
+  if (!mapPage(virtual_page, ppn, 1))
+  {
+    PageManager::instance()->freePPN(ppn);
+    return false;
+  }
+  PageManager::instance()->freePPN(physical_page);
+  return true;
+}
+
+bool ArchMemory::mapHugePage(uint32, uint32)
+{
+  return false;
+}
+
+size_t ArchMemory::mapRange(uint32 first_virtual_page, uint32 num_pages, const uint32* physical_pages, uint32 user_access)
+{
+  size_t mapped = 0;
+  for (uint32 i = 0; i < num_pages; ++i)
+  {
+    if (mapPage(first_virtual_page + i, physical_pages[i], user_access))
+      ++mapped;
+    else
+      PageManager::instance()->freePPN(physical_pages[i]);
+  }
+  return mapped;
+}
+
+size_t ArchMemory::mapSharedRange(uint32 first_virtual_page, uint32 num_pages, const uint32* physical_pages)
+{
+  size_t mapped = 0;
+  for (uint32 i = 0; i < num_pages; ++i)
+  {
+    if (mapSharedPage(first_virtual_page + i, physical_pages[i]))
+      ++mapped;
+    else
+      PageManager::instance()->freePPN(physical_pages[i]);
+  }
+  return mapped;
+}
+
+void ArchMemory::unmapRange(uint32 first_virtual_page, uint32 num_pages)
+{
+  for (uint32 virtual_page = first_virtual_page; virtual_page < first_virtual_page + num_pages; ++virtual_page)
+  {
+    if (checkAddressValid(virtual_page * PAGE_SIZE))
+      unmapPage(virtual_page);
+  }
+}
+
 void ArchMemory::checkAndRemovePT(uint32 pde_vpn)
 {
   PageDirEntry *page_directory = (PageDirEntry *) getIdentAddressOfPPN(page_dir_page_);
@@ -102,6 +183,8 @@ void ArchMemory::unmapPage(uint32 virtual_page)
   assert(pte_base[pte_vpn].size == PTE_SIZE_SMALL);
 
   pte_base[pte_vpn].size = PTE_SIZE_NONE;
+  // the whole TLB is flushed on every context switch, so only the loaded address space can have this entry
+  asm volatile ("mcr p15, 0, %[mva], c8, c7, 1\n" : : [mva]"r"(virtual_page * PAGE_SIZE) : "memory");
   PageManager::instance()->freePPN(pte_base[pte_vpn].page_ppn - PHYS_OFFSET_4K);
   ((uint32*)pte_base)[pte_vpn] = 0; // for easier debugging
 
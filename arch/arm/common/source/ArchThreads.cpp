@@ -4,6 +4,7 @@
 #include "paging-definitions.h"
 #include "offsets.h"
 #include "Thread.h"
+#include "KmemCache.h"
 #include "Scheduler.h"
 #include "SpinLock.h"
 
@@ -11,10 +12,22 @@ SpinLock global_atomic_add_lock("");
 
 extern PageDirEntry kernel_page_directory[];
 
+static KmemCache arch_thread_registers_cache("ArchThreadRegisters", sizeof(ArchThreadRegisters));
+
+void* ArchThreadRegisters::operator new(size_t size)
+{
+  return arch_thread_registers_cache.allocate(size);
+}
+
+void ArchThreadRegisters::operator delete(void* address)
+{
+  arch_thread_registers_cache.free(address);
+}
+
 void ArchThreads::initialise()
 {
   new (&global_atomic_add_lock) SpinLock("global_atomic_add_lock");
-  currentThreadRegisters = (ArchThreadRegisters*) new uint8[sizeof(ArchThreadRegisters)];
+  ArchMulticore::setCurrentThreadRegisters(new ArchThreadRegisters{});
   pointer pageDirectory = VIRTUAL_TO_PHYSICAL_BOOT(((pointer)kernel_page_directory));
   currentThreadRegisters->ttbr0 = pageDirectory;
 }
@@ -30,7 +43,7 @@ void ArchThreads::setAddressSpace(Thread *thread, ArchMemory& arch_memory)
 
 void ArchThreads::createKernelRegisters(ArchThreadRegisters *&info, void* start_function, void* stack)
 {
-  info = (ArchThreadRegisters*)new uint8[sizeof(ArchThreadRegisters)];
+  info = new ArchThreadRegisters;
   memset((void*)info, 0, sizeof(ArchThreadRegisters));
   pointer pageDirectory = VIRTUAL_TO_PHYSICAL_BOOT(((pointer)kernel_page_directory));
   assert((pageDirectory) != 0);
@@ -54,7 +67,7 @@ void ArchThreads::changeInstructionPointer(ArchThreadRegisters *info, void* func
 
 void ArchThreads::createUserRegisters(ArchThreadRegisters *&info, void* start_function, void* user_stack, void* kernel_stack)
 {
-  info = (ArchThreadRegisters*)new uint8[sizeof(ArchThreadRegisters)];
+  info = new ArchThreadRegisters;
   memset((void*)info, 0, sizeof(ArchThreadRegisters));
   pointer pageDirectory = VIRTUAL_TO_PHYSICAL_BOOT(((pointer)kernel_page_directory));
   assert((pageDirectory) != 0);
@@ -71,6 +84,13 @@ void ArchThreads::createUserRegisters(ArchThreadRegisters *&info, void* start_fu
   assert(((pageDirectory) & 0x3FFF) == 0);
 }
 
+void ArchThreads::createForkedUserRegisters(ArchThreadRegisters *&info, ArchThreadRegisters* parent_info, void* kernel_stack)
+{
+  info = new ArchThreadRegisters(*parent_info);
+  info->r[0] = 0;
+  info->sp0 = (pointer)kernel_stack & ~0xF;
+}
+
 void ArchThreads::yield()
 {
   asm("swi #0xffff");
@@ -28,9 +28,6 @@
 extern uint32* currentStack;
 extern Console* main_console;
 
-extern ArchThreadRegisters *currentThreadRegisters;
-extern Thread *currentThread;
-
 uint32 last_address;
 uint32 count;
 
@@ -116,7 +113,7 @@ void arch_swi_irq_handler()
   else if (swi == 0x0) // syscall
   {
     currentThread->switch_to_userspace_ = 0;
-    currentThreadRegisters = currentThread->kernel_registers_;
+    ArchMulticore::setCurrentThreadRegisters(currentThread->kernel_registers_);
     ArchInterrupts::enableInterrupts();
     currentThread->user_registers_->r[0] = Syscall::syscallException(currentThread->user_registers_->r[0],
                                                                           currentThread->user_registers_->r[1],
@@ -126,7 +123,7 @@ void arch_swi_irq_handler()
                                                                           currentThread->user_registers_->r[5]);
     ArchInterrupts::disableInterrupts();
     currentThread->switch_to_userspace_ = 1;
-    currentThreadRegisters =  currentThread->user_registers_;
+    ArchMulticore::setCurrentThreadRegisters(currentThread->user_registers_);
   }
   else
   {
@@ -164,7 +161,7 @@ extern "C" void exceptionHandler(uint32 type)
     kprintfd("\nCPU Fault type = %x\n",type);
     ArchThreads::printThreadRegisters(currentThread,false);
     currentThread->switch_to_userspace_ = 0;
-    currentThreadRegisters = currentThread->kernel_registers_;
+    ArchMulticore::setCurrentThreadRegisters(currentThread->kernel_registers_);
     ArchInterrupts::enableInterrupts();
     currentThread->kill();
     for(;;);
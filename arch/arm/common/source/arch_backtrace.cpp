@@ -15,8 +15,6 @@ struct StackFrame
   StackFrame *prev_fp;
 };
 
-extern Thread* currentThread;
-
 int backtrace(pointer *call_stack, int size, Thread *thread, bool use_stored_registers)
 {
   if (!call_stack ||
@@ -5,8 +5,6 @@
 #include "Thread.h"
 #include "ArchInterrupts.h"
 
-extern Thread* currentThread;
-
 extern "C" void halt();
 
 __attribute__((noreturn)) void sweb_assert(const char *condition, uint32 line, const char* file)
@@ -116,7 +116,7 @@ void KeyboardManager::serviceIRQ(void)
   setLEDs(); // setting the leds
   if (main_console)
   {
-    keyboard_buffer_.put(scancode); // put it inside the buffer
+    putScancode(scancode); // put it inside the buffer
   }
 
 }
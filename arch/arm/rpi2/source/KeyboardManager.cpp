@@ -88,7 +88,7 @@ void KeyboardManager::serviceIRQ( void )
   {
     if(main_console)
     {
-      keyboard_buffer_.put( key ); // put it inside the buffer
+      putScancode( key ); // put it inside the buffer
     }
   }
 
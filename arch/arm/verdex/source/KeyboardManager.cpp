@@ -36,7 +36,7 @@ void KeyboardManager::serviceIRQ( void )
   {
     if(main_console)
     {
-      keyboard_buffer_.put(*(volatile unsigned long*)SERIAL_BASE); // put it inside the buffer
+      putScancode(*(volatile unsigned long*)SERIAL_BASE); // put it inside the buffer
     }
   }
 }
@@ -50,6 +50,33 @@ public:
  */
   ArchMemory();
 
+/**
+ * creates the address space of a forked process. The page tables do not have a bit to
+ * mark copy-on-write pages yet, so all pages of the parent are copied right away.
+ *
+ * @param parent the address space to copy
+ */
+  ArchMemory(ArchMemory& parent);
+
+/**
+ * there are no copy-on-write pages on this architecture, see the fork constructor
+ *
+ * @param virtual_page the page a write fault occurred on
+ * @return always false
+ */
+  bool copyOnWrite(size_t virtual_page);
+
+/**
+ * maps a page which other address spaces use as well. There is no copy-on-write on this
+ * architecture, so the address space gets a private copy and drops its user of the page
+ * (see PageManager::shareFrame).
+ *
+ * @param virtual_page
+ * @param physical_page
+ * @return false if the virtual page is mapped already, the user of the page is kept then
+ */
+  bool mapSharedPage(size_t virtual_page, size_t physical_page);
+
 /** 
  *
  * maps a virtual page to a physical page (pde and pte need to be set up first)
@@ -61,6 +88,12 @@ public:
  */
   bool mapPage(size_t virtual_page, size_t physical_page, size_t user_access);
 
+/**
+ * huge user pages are not supported here, see HUGE_PAGE_SIZE
+ * @return always false, the caller maps single pages
+ */
+  bool mapHugePage(size_t virtual_page, size_t user_access);
+
 /**
  * removes the mapping to a virtual_page by marking its PTE Entry as non valid
  *
@@ -68,6 +101,25 @@ public:
  */
   bool unmapPage(size_t virtual_page);
 
+/**
+ * maps consecutive virtual pages to the given frames, one page after the other
+ *
+ * @param physical_pages one frame per page, the frames of pages which are mapped already
+ * are freed
+ * @return the number of pages which have been mapped
+ */
+  size_t mapRange(size_t first_virtual_page, size_t num_pages, const size_t* physical_pages, size_t user_access);
+
+/**
+ * like mapRange for pages which other address spaces use as well, see mapSharedPage
+ */
+  size_t mapSharedRange(size_t first_virtual_page, size_t num_pages, const size_t* physical_pages);
+
+/**
+ * removes all mappings in a range of virtual pages, pages which are not mapped are skipped
+ */
+  void unmapRange(size_t first_virtual_page, size_t num_pages);
+
 /**
  * Destructor. Recursively deletes the page directory and all page tables
  *
@@ -143,6 +195,8 @@ public:
   static const size_t RESERVED_START = 0xFFFFFFC000000ULL;
   static const size_t RESERVED_END =   0xFFFFFFC000400ULL;
 
+  static const size_t HUGE_PAGE_SIZE = 0; // no huge user pages
+
 private:
 
   /**
@@ -165,7 +219,6 @@ private:
   void checkAndRemovePT(size_t pde_vpn);
 
 
-  ArchMemory(ArchMemory const &src); // not yet implemented
   ArchMemory &operator=(ArchMemory const &src); // should never be implemented
 
 };
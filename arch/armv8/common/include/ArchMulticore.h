@@ -0,0 +1,51 @@
+#pragma once
+
+#include "types.h"
+
+class Thread;
+struct ArchThreadRegisters;
+
+/**
+ * this is where the thread info for task switching is stored
+ *
+ */
+extern ArchThreadRegisters *currentThreadRegisters;
+extern Thread *currentThread;
+
+/**
+ * Only the boot cpu is used on this platform, so the cpu local variables
+ * currentThread and currentThreadRegisters are plain globals.
+ */
+class ArchMulticore
+{
+  public:
+    static const size_t MAX_CPUS = 1;
+
+    static void initialise()
+    {
+    }
+
+    static void startOtherCpus()
+    {
+    }
+
+    static size_t numCpus()
+    {
+      return 1;
+    }
+
+    static size_t cpuId()
+    {
+      return 0;
+    }
+
+    static void setCurrentThread(Thread* thread)
+    {
+      currentThread = thread;
+    }
+
+    static void setCurrentThreadRegisters(ArchThreadRegisters* registers)
+    {
+      currentThreadRegisters = registers;
+    }
+};
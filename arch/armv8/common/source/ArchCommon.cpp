@@ -7,6 +7,7 @@
 #include "FrameBufferConsole.h"
 #include "backtrace.h"
 #include "SWEBDebugInfo.h"
+#include "ArchInterrupts.h"
 
 #define PHYSICAL_MEMORY_AVAILABLE 8*1024*1024
 
@@ -132,6 +133,15 @@ extern "C" void halt()
 void ArchCommon::idle()
 {
   ArchBoardSpecific::onIdle();
-  halt();
+  halt(); // wfi also wakes up on masked interrupts, they are taken right after enabling them
+  ArchInterrupts::enableInterrupts();
+}
+
+uint64 ArchCommon::getMonotonicTimeNs()
+{
+  uint64 count, frequency;
+  asm volatile("MRS %[c], CNTVCT_EL0" : [c]"=r" (count));
+  asm volatile("MRS %[f], CNTFRQ_EL0" : [f]"=r" (frequency));
+  return (count / frequency) * 1000000000ULL + (count % frequency) * 1000000000ULL / frequency;
 }
 
@@ -6,6 +6,7 @@
 #include "ArchThreads.h"
 #include "ArchBoardSpecific.h"
 #include "Thread.h"
+#include "assert.h"
 
 extern "C" void exceptionHandler(size_t int_id, size_t curr_el, size_t exc_syndrome, size_t fault_address, size_t return_addr);
 extern "C" const size_t kernel_sp_struct_offset = (size_t)&((ArchThreadRegisters *)NULL)->SP_SM;
@@ -62,6 +63,16 @@ void ArchInterrupts::disableTimer()
   ArchBoardSpecific::disableTimer();
 }
 
+bool ArchInterrupts::enableOneShotTimer()
+{
+  return false; // the board timers keep running periodically
+}
+
+void ArchInterrupts::setOneShotTimer(uint64 ns __attribute__((unused)))
+{
+  assert(false && "there is no one-shot timer on this platform");
+}
+
 void ArchInterrupts::enableKBD()
 {
   ArchBoardSpecific::enableKBD();
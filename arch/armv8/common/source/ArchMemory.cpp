@@ -21,6 +21,91 @@ ArchMemory::ArchMemory()
   debug(A_MEMORY, "ArchMemory::ArchMemory(): Got new Page no. %zx\n", paging_root_page_);
 }
 
+ArchMemory::ArchMemory(ArchMemory& parent) : ArchMemory()
+{
+    Level1Entry * level1_entry = (Level1Entry *)getIdentAddressOfPPN(parent.paging_root_page_);
+
+    for(size_t level1_index = 0; level1_index < LEVEL1_ENTRIES; level1_index++)
+    {
+        if(level1_entry[level1_index].entry_descriptor_type != ENTRY_DESCRIPTOR_TABLE)
+            continue;
+        Level2Entry * level2_entry = (Level2Entry *)getIdentAddressOfPPN(level1_entry[level1_index].table_address);
+        for(size_t level2_index = 0; level2_index < LEVEL2_ENTRIES; level2_index++)
+        {
+            if(level2_entry[level2_index].table.entry_descriptor_type != ENTRY_DESCRIPTOR_TABLE)
+                continue;
+            Level3Entry * level3_entry = (Level3Entry *)getIdentAddressOfPPN(level2_entry[level2_index].table.table_address);
+            for(size_t level3_index = 0; level3_index < LEVEL3_ENTRIES; level3_index++)
+            {
+                if(level3_entry[level3_index].entry_descriptor_type != ENTRY_DESCRIPTOR_PAGE)
+                    continue;
+                size_t ppn = PageManager::instance()->allocPPN(PAGE_SIZE, PageManager::ALLOC_NO_ZERO);
+                memcpy((void*)getIdentAddressOfPPN(ppn), (void*)getIdentAddressOfPPN(level3_entry[level3_index].page_address), PAGE_SIZE);
+                size_t virtual_page = (level1_index * LEVEL2_ENTRIES + level2_index) * LEVEL3_ENTRIES + level3_index;
+                mapPage(virtual_page, ppn, level3_entry[level3_index].access_permissions);
+            }
+        }
+    }
+}
+
+bool ArchMemory::copyOnWrite(size_t)
+{
+    return false;
+}
+
+bool ArchMemory::mapSharedPage(size_t virtual_page, size_t physical_page)
+{
+    size_t ppn = PageManager::instance()->allocPPN(PAGE_SIZE, PageManager::ALLOC_NO_ZERO);
+    memcpy((void*)getIdentAddressOfPPN(ppn), (void*)getIdentAddressOfPPN(physical_page), PAGE_SIZE);
+    if(!mapPage(virtual_page, ppn, 1))
+    {
+        PageManager::instance()->freePPN(ppn);
+        return false;
+    }
+    PageManager::instance()->freePPN(physical_page);
+    return true;
+}
+
+bool ArchMemory::mapHugePage(size_t, size_t)
+{
+    return false;
+}
+
+size_t ArchMemory::mapRange(size_t first_virtual_page, size_t num_pages, const size_t* physical_pages, size_t user_access)
+{
+    size_t mapped = 0;
+    for (size_t i = 0; i < num_pages; ++i)
+    {
+        if (mapPage(first_virtual_page + i, physical_pages[i], user_access))
+            ++mapped;
+        else
+            PageManager::instance()->freePPN(physical_pages[i]);
+    }
+    return mapped;
+}
+
+size_t ArchMemory::mapSharedRange(size_t first_virtual_page, size_t num_pages, const size_t* physical_pages)
+{
+    size_t mapped = 0;
+    for (size_t i = 0; i < num_pages; ++i)
+    {
+        if (mapSharedPage(first_virtual_page + i, physical_pages[i]))
+            ++mapped;
+        else
+            PageManager::instance()->freePPN(physical_pages[i]);
+    }
+    return mapped;
+}
+
+void ArchMemory::unmapRange(size_t first_virtual_page, size_t num_pages)
+{
+    for (size_t virtual_page = first_virtual_page; virtual_page < first_virtual_page + num_pages; ++virtual_page)
+    {
+        if (checkAddressValid(virtual_page * PAGE_SIZE))
+            unmapPage(virtual_page);
+    }
+}
+
 bool ArchMemory::unmapPage(size_t virtual_page)
 {
     ArchMemoryMapping m = resolveMapping(virtual_page);
@@ -28,6 +113,12 @@ bool ArchMemory::unmapPage(size_t virtual_page)
     assert(m.page_ppn != 0 && m.page_size == PAGE_SIZE && m.level3_entry[m.level3_index].entry_descriptor_type == ENTRY_DESCRIPTOR_PAGE);
 
     m.level3_entry[m.level3_index].entry_descriptor_type = 0;
+    // the entries are tagged with the asid, invalidate only the one of this address space
+    size_t tlbi_operand = (virtual_page & ((1ULL << 44) - 1)) | (((size_t)address_space_id) << 48);
+    asm volatile ("dsb ishst\n"
+                  "tlbi vae1is, %0\n"
+                  "dsb ish\n"
+                  "isb\n" : : "r"(tlbi_operand) : "memory");
     PageManager::instance()->freePPN(m.page_ppn);
     ((size_t*)m.level3_entry)[m.level3_index] = 0;
 
@@ -5,15 +5,28 @@
 #include "paging-definitions.h"
 #include "offsets.h"
 #include "Thread.h"
+#include "KmemCache.h"
 #include "Scheduler.h"
 #include "SpinLock.h"
 
 SpinLock global_atomic_add_lock("");
 
+static KmemCache arch_thread_registers_cache("ArchThreadRegisters", sizeof(ArchThreadRegisters));
+
+void* ArchThreadRegisters::operator new(size_t size)
+{
+  return arch_thread_registers_cache.allocate(size);
+}
+
+void ArchThreadRegisters::operator delete(void* address)
+{
+  arch_thread_registers_cache.free(address);
+}
+
 void ArchThreads::initialise()
 {
   new (&global_atomic_add_lock) SpinLock("global_atomic_add_lock");
-  currentThreadRegisters = (ArchThreadRegisters*) new uint8[sizeof(ArchThreadRegisters)];
+  ArchMulticore::setCurrentThreadRegisters(new ArchThreadRegisters{});
   pointer paging_root = VIRTUAL_TO_PHYSICAL_BOOT(((pointer)kernel_paging_level1));
   currentThreadRegisters->TTBR0 = paging_root;
 }
@@ -32,7 +45,7 @@ void ArchThreads::setAddressSpace(Thread *thread, ArchMemory& arch_memory)
 
 void ArchThreads::createKernelRegisters(ArchThreadRegisters *&info, void* start_function, void* stack)
 {
-  info = (ArchThreadRegisters*)new uint8[sizeof(ArchThreadRegisters)];
+  info = new ArchThreadRegisters;
   memset((void*)info, 0, sizeof(ArchThreadRegisters));
   assert(!((pointer)start_function & 0x3));
   info->ELR = (pointer)start_function;
@@ -50,7 +63,7 @@ void ArchThreads::changeInstructionPointer(ArchThreadRegisters *info, void* func
 
 void ArchThreads::createUserRegisters(ArchThreadRegisters *&info, void* start_function, void* user_stack, void* kernel_stack)
 {
-  info = (ArchThreadRegisters*)new uint8[sizeof(ArchThreadRegisters)];
+  info = new ArchThreadRegisters;
   memset((void*)info, 0, sizeof(ArchThreadRegisters));
   assert(!((pointer)start_function & 0x3));
 
@@ -63,6 +76,13 @@ void ArchThreads::createUserRegisters(ArchThreadRegisters *&info, void* start_fu
   info->TTBR0 = 0;
 }
 
+void ArchThreads::createForkedUserRegisters(ArchThreadRegisters *&info, ArchThreadRegisters* parent_info, void* kernel_stack)
+{
+  info = new ArchThreadRegisters(*parent_info);
+  info->X[0] = 0;
+  info->SP_SM = (pointer) kernel_stack & ~0xF;
+}
+
 void ArchThreads::yield()
 {
   asm("SVC #0xffff");
@@ -28,9 +28,6 @@
 
 extern Console* main_console;
 
-extern ArchThreadRegisters *currentThreadRegisters;
-extern Thread *currentThread;
-
 void pageFaultHandler(size_t address, uint32 type NU, size_t exc_syndrome NU)
 {
   bool writing = exc_syndrome & (1 << 6);
@@ -74,7 +71,7 @@ void arch_swi_irq_handler(size_t swi)
   else if (swi == 0x0) // syscall
   {
     currentThread->switch_to_userspace_ = 0;
-    currentThreadRegisters = currentThread->kernel_registers_;
+    ArchMulticore::setCurrentThreadRegisters(currentThread->kernel_registers_);
     ArchInterrupts::enableInterrupts();
     currentThread->user_registers_->X[0] = Syscall::syscallException(currentThread->user_registers_->X[0],
                                                                           currentThread->user_registers_->X[1],
@@ -84,7 +81,7 @@ void arch_swi_irq_handler(size_t swi)
                                                                           currentThread->user_registers_->X[5]);
     ArchInterrupts::disableInterrupts();
     currentThread->switch_to_userspace_ = 1;
-    currentThreadRegisters =  currentThread->user_registers_;
+    ArchMulticore::setCurrentThreadRegisters(currentThread->user_registers_);
   }
   else
   {
@@ -127,7 +124,7 @@ extern "C" void exceptionHandler(size_t int_id , size_t curr_el NU, size_t exc_s
     kprintfd("\nCPU Fault type = %zx\n",type);
     ArchThreads::printThreadRegisters(currentThread,false);
     currentThread->switch_to_userspace_ = 0;
-    currentThreadRegisters = currentThread->kernel_registers_;
+    ArchMulticore::setCurrentThreadRegisters(currentThread->kernel_registers_);
     ArchInterrupts::enableInterrupts();
     currentThread->kill();
     for(;;);
@@ -76,7 +76,7 @@ void KeyboardManager::serviceIRQ( void )
             if (data == 127)
                 data = '\b';
 
-            keyboard_buffer_.put(data);
+            putScancode(data);
         }
     }
 }
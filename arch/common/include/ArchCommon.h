@@ -82,10 +82,17 @@ class ArchCommon
     static void initDebug();
 
     /**
-     * let the CPU idle, f.e. with the halt statement
+     * let the CPU idle until the next interrupt arrives, f.e. with the halt statement
+     * has to be called with interrupts disabled, they get enabled in a way
+     * that no interrupt can slip through between enabling and halting
      */
     static void idle();
 
+    /**
+     * @return nanoseconds since boot, never goes backwards
+     */
+    static uint64 getMonotonicTimeNs();
+
     /**
      * draw a heartbeat character
      */
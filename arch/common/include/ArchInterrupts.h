@@ -14,6 +14,22 @@ public:
   static void setTimerFrequency(uint32 freq);
   static void disableTimer();
 
+  /**
+   * Switches the timer interrupt from a fixed frequency to one-shot mode,
+   * afterwards it only fires if it has been armed with setOneShotTimer.
+   * Has to be called after enableTimer with interrupts disabled.
+   *
+   * @return false if there is no one-shot timer on this platform, the periodic timer keeps running then
+   */
+  static bool enableOneShotTimer();
+
+  /**
+   * arms the one-shot timer, only valid once enableOneShotTimer succeeded
+   *
+   * @param ns nanoseconds until the timer interrupt should fire, 0 disarms the timer
+   */
+  static void setOneShotTimer(uint64 ns);
+
   static void enableKBD();
   static void disableKBD();
 
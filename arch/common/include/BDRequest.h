@@ -1,11 +1,11 @@
 #pragma once
 
 #include "types.h"
+#include "ArchMulticore.h"
+#include "WaitQueue.h"
 
 class Thread;
 
-extern Thread * currentThread;
-
 class BDRequest
 {
   protected:
@@ -97,5 +97,10 @@ class BDRequest
     void *buffer_;
     Thread *requesting_thread_;
     BDRequest *next_request_;
+
+    /**
+     * the requesting thread waits in here until the driver is done with the request
+     */
+    WaitQueue done_;
 };
 
@@ -87,6 +87,11 @@ class Elf
     static const Elf64_Word PT_HIPROC    = 8;
     static const Elf64_Word PT_GNU_STACK = 9;
 
+// PHDR SEGMENT FLAGS
+    static const Elf64_Word PF_X         = 1;
+    static const Elf64_Word PF_W         = 2;
+    static const Elf64_Word PF_R         = 4;
+
     struct sELF64_Ehdr
     {
         uint8 e_ident[EI_NIDENT];
@@ -11,6 +11,7 @@ extern "C"
 #endif
 
 #include "RingBuffer.h"
+#include "WaitQueue.h"
 #include "atkbd.h"
 
 #define STANDARD_KEYMAP_DEF { 0, 0x1B, '1', '2', '3', '4', '5' , '6', \
@@ -138,6 +139,18 @@ class KeyboardManager
         return false;
     }
 
+    /**
+     * blocks until there is at least one key to get
+     */
+    void waitForKeys()
+    {
+      key_available_.prepareToWait();
+      if (keyboard_buffer_.isEmpty())
+        key_available_.sleep();
+      else
+        key_available_.finishWait();
+    }
+
     void serviceIRQ(void);
 
     bool isShift()
@@ -191,7 +204,18 @@ class KeyboardManager
      */
     void send_cmd(uint8 cmd, uint8 port = 0);
 
+    /**
+     * puts a scancode into the buffer and wakes up whoever waits for keys,
+     * safe to call from an interrupt handler
+     */
+    void putScancode(uint8 sc)
+    {
+      keyboard_buffer_.put(sc);
+      key_available_.wakeAll();
+    }
+
     RingBuffer<uint8> keyboard_buffer_;
+    WaitQueue key_available_;
 
     static uint32 const STANDARD_KEYMAP[];
     static uint32 const E0_KEYS[];
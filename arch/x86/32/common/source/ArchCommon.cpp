@@ -10,6 +10,7 @@
 #include "Stabs2DebugInfo.h"
 #include "ports.h"
 #include "PageManager.h"
+#include "TimeStampCounter.h"
 
 extern void* kernel_end_address;
 
@@ -217,7 +218,13 @@ void ArchCommon::initDebug()
 
 void ArchCommon::idle()
 {
-  asm volatile("hlt");
+  asm volatile("sti\n"
+               "hlt"); // sti only takes effect after hlt, no interrupt can get lost in between
+}
+
+uint64 ArchCommon::getMonotonicTimeNs()
+{
+  return TimeStampCounter::nsSinceBoot();
 }
 
 #define STATS_OFFSET 22
@@ -6,6 +6,7 @@
 #include "ArchThreads.h"
 #include "assert.h"
 #include "Thread.h"
+#include "TimeStampCounter.h"
 
 void ArchInterrupts::initialise()
 {
@@ -15,6 +16,7 @@ void ArchInterrupts::initialise()
   InterruptUtils::initialise();
   for (i=0;i<16;++i)
     disableIRQ(i);
+  TimeStampCounter::calibrate();
 }
 
 void ArchInterrupts::enableTimer()
@@ -40,6 +42,16 @@ void ArchInterrupts::disableTimer()
   disableIRQ(0);
 }
 
+bool ArchInterrupts::enableOneShotTimer()
+{
+  return false; // the local APIC is not mapped on x86/32, keep the periodic PIT
+}
+
+void ArchInterrupts::setOneShotTimer(uint64 ns __attribute__((unused)))
+{
+  assert(false && "there is no one-shot timer on x86/32");
+}
+
 void ArchInterrupts::enableKBD()
 {
   enableIRQ(1);
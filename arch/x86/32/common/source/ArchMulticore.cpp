@@ -0,0 +1,6 @@
+#include "ArchMulticore.h"
+
+ArchThreadRegisters *currentThreadRegisters;
+Thread *currentThread;
+
+const size_t ArchMulticore::MAX_CPUS;
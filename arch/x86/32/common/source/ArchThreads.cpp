@@ -5,13 +5,26 @@
 #include "paging-definitions.h"
 #include "offsets.h"
 #include "Thread.h"
+#include "KmemCache.h"
 #include "kstring.h"
 
 
 
+static KmemCache arch_thread_registers_cache("ArchThreadRegisters", sizeof(ArchThreadRegisters));
+
+void* ArchThreadRegisters::operator new(size_t size)
+{
+  return arch_thread_registers_cache.allocate(size);
+}
+
+void ArchThreadRegisters::operator delete(void* address)
+{
+  arch_thread_registers_cache.free(address);
+}
+
 void ArchThreads::initialise()
 {
-  currentThreadRegisters = new ArchThreadRegisters{};
+  ArchMulticore::setCurrentThreadRegisters(new ArchThreadRegisters{});
 }
 
 void ArchThreads::setAddressSpace(Thread *thread, ArchMemory& arch_memory)
@@ -69,6 +82,13 @@ void ArchThreads::createUserRegisters(ArchThreadRegisters *&info, void* start_fu
   info->esp0    = (size_t)kernel_stack;
 }
 
+void ArchThreads::createForkedUserRegisters(ArchThreadRegisters *&info, ArchThreadRegisters* parent_info, void* kernel_stack)
+{
+  info = new ArchThreadRegisters(*parent_info);
+  info->eax     = 0;
+  info->esp0    = (size_t)kernel_stack;
+}
+
 void ArchThreads::changeInstructionPointer(ArchThreadRegisters *info, void* function)
 {
   info->eip = (size_t)function;
@@ -144,10 +144,9 @@ extern "C" void pageFaultHandler(uint32 address, uint32 error)
                                    error & FLAG_PF_PRESENT,
                                    error & FLAG_PF_RDWR,
                                    error & FLAG_PF_INSTR_FETCH);
+  // the page fault handler invalidated the entries it changed, not present entries are never cached
   if (currentThread->switch_to_userspace_)
     arch_contextSwitch();
-  else
-    asm volatile ("movl %%cr3, %%eax; movl %%eax, %%cr3;" ::: "%eax");
 }
 
 extern "C" void arch_irqHandler_1();
@@ -225,7 +224,7 @@ extern "C" void arch_syscallHandler();
 extern "C" void syscallHandler()
 {
   currentThread->switch_to_userspace_ = 0;
-  currentThreadRegisters = currentThread->kernel_registers_;
+  ArchMulticore::setCurrentThreadRegisters(currentThread->kernel_registers_);
   ArchInterrupts::enableInterrupts();
 
   currentThread->user_registers_->eax = Syscall::syscallException(currentThread->user_registers_->eax,
@@ -237,7 +236,7 @@ extern "C" void syscallHandler()
 
   ArchInterrupts::disableInterrupts();
   currentThread->switch_to_userspace_ = 1;
-  currentThreadRegisters = currentThread->user_registers_;
+  ArchMulticore::setCurrentThreadRegisters(currentThread->user_registers_);
   //ArchThreads::printThreadRegisters(currentThread,false);
   arch_contextSwitch();
 }
@@ -291,7 +290,7 @@ extern "C" void errorHandler(size_t num, size_t rip, size_t cs, size_t spurious)
   else
   {
     currentThread->switch_to_userspace_ = false;
-    currentThreadRegisters = currentThread->kernel_registers_;
+    ArchMulticore::setCurrentThreadRegisters(currentThread->kernel_registers_);
     ArchInterrupts::enableInterrupts();
     debug(CPU_ERROR, "Terminating process...\n");
     currentThread->kill();
@@ -18,6 +18,34 @@ class ArchMemory
 public:
   ArchMemory();
 
+/**
+ * creates the address space of a forked process: the page tables of the parent are
+ * copied, the pages themselves are shared. Writeable pages become read only copy-on-write
+ * pages in both address spaces, the parent has to reload its address space afterwards.
+ *
+ * @param parent the address space to copy
+ */
+  ArchMemory(ArchMemory& parent);
+
+/**
+ * gives a copy-on-write page its own frame (unless it is the last user of the shared one)
+ * and makes it writeable again
+ *
+ * @param virtual_page the page a write fault occurred on
+ * @return false if the page is not a copy-on-write page, the fault is a real error then
+ */
+  bool copyOnWrite(uint32 virtual_page);
+
+/**
+ * maps a page which other address spaces use as well, it is read only and copied on the
+ * first write. The mapping is one user of the page, see PageManager::shareFrame.
+ *
+ * @param virtual_page
+ * @param physical_page
+ * @return false if the virtual page is mapped already
+ */
+  __attribute__((warn_unused_result)) bool mapSharedPage(uint32 virtual_page, uint32 physical_page);
+
 /** 
  *
  * maps a virtual page to a physical page (pde and pte need to be set up first)
@@ -30,6 +58,12 @@ public:
  */
   __attribute__((warn_unused_result)) bool mapPage(uint32 virtual_page, uint32 physical_page, uint32 user_access);
 
+/**
+ * huge user pages are not supported here, see HUGE_PAGE_SIZE
+ * @return always false, the caller maps single pages
+ */
+  __attribute__((warn_unused_result)) bool mapHugePage(uint32 virtual_page, uint32 user_access);
+
 /**
  * removes the mapping to a virtual_page by marking its PTE Entry as non valid
  *
@@ -38,6 +72,25 @@ public:
  */
   void unmapPage(uint32 virtual_page);
 
+/**
+ * maps consecutive virtual pages to the given frames, one page after the other
+ *
+ * @param physical_pages one frame per page, the frames of pages which are mapped already
+ * are freed
+ * @return the number of pages which have been mapped
+ */
+  size_t mapRange(uint32 first_virtual_page, uint32 num_pages, const uint32* physical_pages, uint32 user_access);
+
+/**
+ * like mapRange for pages which other address spaces use as well, see mapSharedPage
+ */
+  size_t mapSharedRange(uint32 first_virtual_page, uint32 num_pages, const uint32* physical_pages);
+
+/**
+ * removes all mappings in a range of virtual pages, pages which are not mapped are skipped
+ */
+  void unmapRange(uint32 first_virtual_page, uint32 num_pages);
+
   ~ArchMemory();
 
 /**
@@ -106,7 +159,14 @@ public:
   static const size_t RESERVED_START = 0x80000ULL;
   static const size_t RESERVED_END = 0xC0000ULL;
 
+  static const size_t HUGE_PAGE_SIZE = 0; // no huge user pages
+
 private:
+/**
+ * common part of mapPage and mapSharedPage
+ */
+  bool insertPage(uint32 virtual_page, uint32 physical_page, uint32 user_access, bool copy_on_write);
+
 
   void insertPD(uint32 pdpt_vpn, uint32 physical_page_directory_page);
 /** 
@@ -139,7 +199,6 @@ private:
   // gets not-aligned in memory -- DG
 
 
-  ArchMemory(ArchMemory const &src); // not yet implemented
   ArchMemory &operator=(ArchMemory const &src); // should never be implemented
 
 };
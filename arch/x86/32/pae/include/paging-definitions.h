@@ -91,7 +91,7 @@ typedef struct
   size_t dirty                     :1;
   size_t pat                       :1;
   size_t global_page               :1;
-  size_t ignored_3                 :1;
+  size_t cow                       :1; // read only until the first write, see ArchMemory::copyOnWrite
   size_t ignored_2                 :1;
   size_t ignored_1                 :1;
   size_t page_ppn                  :24; // MAXPHYADDR (36) - 12
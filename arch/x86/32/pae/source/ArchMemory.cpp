@@ -15,6 +15,43 @@ ArchMemory::ArchMemory() : page_dir_pointer_table_((PageDirPointerTableEntry*) (
   memset(page_dir_pointer_table_, 0, sizeof(PageDirPointerTableEntry) * PAGE_DIRECTORY_POINTER_TABLE_ENTRIES/2); // should be zero, this is just for safety
 }
 
+ArchMemory::ArchMemory(ArchMemory& parent) : ArchMemory()
+{
+  for (uint32 pdpte_vpn = 0; pdpte_vpn < PAGE_DIRECTORY_POINTER_TABLE_ENTRIES / 2; ++pdpte_vpn) // 0-2 GiB
+  {
+    if (!parent.page_dir_pointer_table_[pdpte_vpn].present)
+      continue;
+    uint32 pd_ppn = PageManager::instance()->allocPPN();
+    insertPD(pdpte_vpn, pd_ppn);
+    PageDirEntry *page_directory = (PageDirEntry *) getIdentAddressOfPPN(pd_ppn);
+    PageDirEntry *parent_page_directory = (PageDirEntry *) getIdentAddressOfPPN(parent.page_dir_pointer_table_[pdpte_vpn].page_directory_ppn);
+    for (uint32 pde_vpn = 0; pde_vpn < PAGE_DIRECTORY_ENTRIES; ++pde_vpn)
+    {
+      if (!parent_page_directory[pde_vpn].pt.present)
+        continue;
+      assert(!parent_page_directory[pde_vpn].page.size); // only 4 KiB pages allowed
+      uint32 pt_ppn = PageManager::instance()->allocPPN(PAGE_SIZE, PageManager::ALLOC_NO_ZERO);
+      insertPT(page_directory, pde_vpn, pt_ppn);
+      PageTableEntry *parent_pte_base = (PageTableEntry *) getIdentAddressOfPPN(parent_page_directory[pde_vpn].pt.page_table_ppn);
+      for (uint32 pte_vpn = 0; pte_vpn < PAGE_TABLE_ENTRIES; ++pte_vpn)
+      {
+        if (!parent_pte_base[pte_vpn].present)
+          continue;
+        if (parent_pte_base[pte_vpn].writeable)
+        {
+          parent_pte_base[pte_vpn].writeable = 0;
+          parent_pte_base[pte_vpn].cow = 1;
+        }
+        PageManager::instance()->shareFrame(parent_pte_base[pte_vpn].page_ppn);
+      }
+      // the entries of both page tables are the same now
+      memcpy((void*) getIdentAddressOfPPN(pt_ppn), parent_pte_base, PAGE_SIZE);
+    }
+  }
+  // the writeable pages of the parent are read only now, it is the loaded address space
+  asm volatile ("movl %%cr3, %%eax; movl %%eax, %%cr3;" ::: "%eax");
+}
+
 void ArchMemory::checkAndRemovePT(uint32 physical_page_directory_page, uint32 pde_vpn)
 {
   PageDirEntry *page_directory = (PageDirEntry *) getIdentAddressOfPPN(physical_page_directory_page);
@@ -44,12 +81,34 @@ void ArchMemory::unmapPage(uint32 virtual_page)
   assert(pte_base[pte_vpn].present);
 
   pte_base[pte_vpn].present = 0;
+  // without PCIDs only the loaded address space can have entries in the TLB
+  uint32 cr3;
+  asm volatile ("movl %%cr3, %0" : "=r"(cr3));
+  if (cr3 == getValueForCR3())
+    asm volatile ("invlpg (%0)" : : "r"(virtual_page * PAGE_SIZE) : "memory");
   PageManager::instance()->freePPN(pte_base[pte_vpn].page_ppn);
   ((uint64*)pte_base)[pte_vpn] = 0; // for easier debugging
 
   checkAndRemovePT(page_dir_pointer_table_[pdpte_vpn].page_directory_ppn, pde_vpn);
 }
 
+bool ArchMemory::copyOnWrite(uint32 virtual_page)
+{
+  RESOLVEMAPPING(page_dir_pointer_table_, virtual_page);
+  if (!page_dir_pointer_table_[pdpte_vpn].present || !page_directory[pde_vpn].pt.present ||
+      page_directory[pde_vpn].page.size)
+    return false;
+  PageTableEntry *pte_base = (PageTableEntry *) getIdentAddressOfPPN(page_directory[pde_vpn].pt.page_table_ppn);
+  if (!pte_base[pte_vpn].present || !pte_base[pte_vpn].cow)
+    return false;
+
+  pte_base[pte_vpn].page_ppn = PageManager::instance()->copySharedFrame(pte_base[pte_vpn].page_ppn);
+  pte_base[pte_vpn].cow = 0;
+  pte_base[pte_vpn].writeable = 1;
+  asm volatile ("invlpg (%0)" : : "r"(virtual_page * PAGE_SIZE) : "memory");
+  return true;
+}
+
 void ArchMemory::insertPD(uint32 pdpt_vpn, uint32 physical_page_directory_page)
 {
   kprintfd("insertPD: pdpt %p pdpt_vpn %x physical_page_table_page %x\n",page_dir_pointer_table_,pdpt_vpn,physical_page_directory_page);
@@ -72,6 +131,56 @@ void ArchMemory::insertPT(PageDirEntry* page_directory, uint32 pde_vpn, uint32 p
 }
 
 bool ArchMemory::mapPage(uint32 virtual_page, uint32 physical_page, uint32 user_access)
+{
+  return insertPage(virtual_page, physical_page, user_access, false);
+}
+
+bool ArchMemory::mapSharedPage(uint32 virtual_page, uint32 physical_page)
+{
+  return insertPage(virtual_page, physical_page, 1, true);
+}
+
+bool ArchMemory::mapHugePage(uint32, uint32)
+{
+  return false;
+}
+
+size_t ArchMemory::mapRange(uint32 first_virtual_page, uint32 num_pages, const uint32* physical_pages, uint32 user_access)
+{
+  size_t mapped = 0;
+  for (uint32 i = 0; i < num_pages; ++i)
+  {
+    if (mapPage(first_virtual_page + i, physical_pages[i], user_access))
+      ++mapped;
+    else
+      PageManager::instance()->freePPN(physical_pages[i]);
+  }
+  return mapped;
+}
+
+size_t ArchMemory::mapSharedRange(uint32 first_virtual_page, uint32 num_pages, const uint32* physical_pages)
+{
+  size_t mapped = 0;
+  for (uint32 i = 0; i < num_pages; ++i)
+  {
+    if (mapSharedPage(first_virtual_page + i, physical_pages[i]))
+      ++mapped;
+    else
+      PageManager::instance()->freePPN(physical_pages[i]);
+  }
+  return mapped;
+}
+
+void ArchMemory::unmapRange(uint32 first_virtual_page, uint32 num_pages)
+{
+  for (uint32 virtual_page = first_virtual_page; virtual_page < first_virtual_page + num_pages; ++virtual_page)
+  {
+    if (checkAddressValid(virtual_page * PAGE_SIZE))
+      unmapPage(virtual_page);
+  }
+}
+
+bool ArchMemory::insertPage(uint32 virtual_page, uint32 physical_page, uint32 user_access, bool copy_on_write)
 {
   RESOLVEMAPPING(page_dir_pointer_table_,virtual_page);
 
@@ -91,7 +200,8 @@ bool ArchMemory::mapPage(uint32 virtual_page, uint32 physical_page, uint32 user_
   PageTableEntry *pte_base = (PageTableEntry *) getIdentAddressOfPPN(page_directory[pde_vpn].pt.page_table_ppn);
   if(pte_base[pte_vpn].present == 0)
   {
-    pte_base[pte_vpn].writeable = 1;
+    pte_base[pte_vpn].writeable = !copy_on_write;
+    pte_base[pte_vpn].cow = copy_on_write;
     pte_base[pte_vpn].user_access = user_access;
     pte_base[pte_vpn].page_ppn = physical_page;
     pte_base[pte_vpn].present = 1;
@@ -202,7 +312,7 @@ void ArchMemory::mapKernelPage(uint32 virtual_page, uint32 physical_page)
   pte_base[pte_vpn].writeable = 1;
   pte_base[pte_vpn].page_ppn = physical_page;
   pte_base[pte_vpn].present = 1;
-  asm volatile ("movl %%cr3, %%eax; movl %%eax, %%cr3;" ::: "%eax");
+  asm volatile ("invlpg (%0)" : : "r"(virtual_page * PAGE_SIZE) : "memory");
 }
 
 void ArchMemory::unmapKernelPage(uint32 virtual_page)
@@ -215,8 +325,8 @@ void ArchMemory::unmapKernelPage(uint32 virtual_page)
   assert(pte_base[pte_vpn].present);
   pte_base[pte_vpn].present = 0;
   pte_base[pte_vpn].writeable = 0;
+  asm volatile ("invlpg (%0)" : : "r"(virtual_page * PAGE_SIZE) : "memory");
   PageManager::instance()->freePPN(pte_base[pte_vpn].page_ppn);
-  asm volatile ("movl %%cr3, %%eax; movl %%eax, %%cr3;" ::: "%eax");
 }
 
 PageDirPointerTableEntry* ArchMemory::getRootOfPagingStructure()
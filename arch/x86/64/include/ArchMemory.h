@@ -27,11 +27,43 @@ class ArchMemoryMapping
     uint64 pti;
 };
 
+class TlbShootdown;
+
 class ArchMemory
 {
+  friend class TlbShootdown;
+
 public:
     ArchMemory();
 
+/**
+ * creates the address space of a forked process: the page tables of the parent are
+ * copied, the pages themselves are shared. Writeable pages become read only copy-on-write
+ * pages in both address spaces, huge pages of the parent are split to be shared as well.
+ *
+ * @param parent the address space to copy
+ */
+    ArchMemory(ArchMemory& parent);
+
+/**
+ * gives a copy-on-write page its own frame (unless it is the last user of the shared one)
+ * and makes it writeable again
+ *
+ * @param virtual_page the page a write fault occurred on
+ * @return false if the page is not a copy-on-write page, the fault is a real error then
+ */
+  bool copyOnWrite(uint64 virtual_page);
+
+/**
+ * maps a page which other address spaces use as well, it is read only and copied on the
+ * first write. The mapping is one user of the page, see PageManager::shareFrame.
+ *
+ * @param virtual_page
+ * @param physical_page
+ * @return false if the virtual page is mapped already
+ */
+  __attribute__((warn_unused_result)) bool mapSharedPage(uint64 virtual_page, uint64 physical_page);
+
 /** 
  *
  * maps a virtual page to a physical page (pde and pte need to be set up first)
@@ -45,13 +77,54 @@ public:
   __attribute__((warn_unused_result)) bool mapPage(uint64 virtual_page, uint64 physical_page, uint64 user_access);
 
 /**
- * removes the mapping to a virtual_page by marking its PTE Entry as non valid
+ * maps a zeroed, writeable huge page of HUGE_PAGE_SIZE bytes with a single page directory
+ * entry, backed by a contiguous block of frames. Unmapping a part of it splits it into
+ * 4 KiB pages again, so do fork and copy-on-write.
+ *
+ * @param virtual_page the first page, aligned to HUGE_PAGE_SIZE
+ * @param user_access PTE User/Supervisor Flag
+ * @return false if any page in the range is mapped already or there is no free block
+ * large enough, the caller maps 4 KiB pages then
+ */
+  __attribute__((warn_unused_result)) bool mapHugePage(uint64 virtual_page, uint64 user_access);
+
+/**
+ * removes the mapping to a virtual_page by marking its PTE Entry as non valid,
+ * a huge page containing it is split first
  *
  * @param physical_page_directory_page Real Page where the PDE to work on resides
  * @param virtual_page which will be invalidated
  */
   bool unmapPage(uint64 virtual_page);
 
+/**
+ * maps consecutive virtual pages to the given frames, the paging structures are walked
+ * once per page table instead of once per page
+ *
+ * @param first_virtual_page
+ * @param num_pages
+ * @param physical_pages one frame per page, the frames of pages which are mapped already
+ * are freed
+ * @param user_access PTE User/Supervisor Flag
+ * @return the number of pages which have been mapped
+ */
+  size_t mapRange(uint64 first_virtual_page, uint64 num_pages, const uint64* physical_pages, uint64 user_access);
+
+/**
+ * like mapRange for pages which other address spaces use as well, see mapSharedPage
+ */
+  size_t mapSharedRange(uint64 first_virtual_page, uint64 num_pages, const uint64* physical_pages);
+
+/**
+ * removes all mappings in a range of virtual pages, pages which are not mapped are skipped,
+ * huge pages which are only partly inside are split. The TLB entries of each page table
+ * are invalidated at once, tables which become empty are freed.
+ *
+ * @param first_virtual_page
+ * @param num_pages
+ */
+  void unmapRange(uint64 first_virtual_page, uint64 num_pages);
+
   ~ArchMemory();
 
 /**
@@ -115,14 +188,114 @@ public:
 
   uint64 page_map_level_4_;
 
+/**
+ * the process context identifier tagging the TLB entries of this address space, 0 if the
+ * cpu does not support them
+ */
+  uint16 pcid_;
+
+/**
+ * @return the value for cr3 which loads this address space: its pml4 and its pcid
+ */
+  uint64 getValueForCR3();
+
+/**
+ * Marks the kernel mappings global, so switching the address space keeps their TLB
+ * entries. If the cpu supports process context identifiers, they are enabled as well,
+ * so every address space keeps its own TLB entries while others run.
+ */
+  static void enableTlbTagging();
+
+/**
+ * loads an address space, its TLB entries are only flushed if they might be stale
+ * because the address space changed or its pcid was reused since this cpu last ran it
+ *
+ * @param cr3 the value for cr3, see getValueForCR3
+ */
+  static void loadAddressSpace(uint64 cr3);
+
+/**
+ * flushes the TLB entries of all address spaces including the global ones
+ */
+  static void flushAllTranslations();
+
+/**
+ * Invalidate the TLB entries of pages whose entries changed. A page which was not present
+ * before needs nothing, the TLB never holds entries for such pages. See TlbShootdown to
+ * invalidate several pages at once.
+ *
+ * @param virtual_page the page to invalidate
+ */
+  void flushPage(uint64 virtual_page);
+
+/**
+ * @param first_virtual_page the first page to invalidate
+ * @param num_pages number of pages to invalidate, the whole address space is flushed if
+ * there are more than TlbShootdown::MAX_PAGES
+ */
+  void flushRange(uint64 first_virtual_page, uint64 num_pages);
+
+/**
+ * invalidates all TLB entries of this address space, the global kernel entries stay
+ */
+  void flushAll();
+
   uint64 getRootOfPagingStructure();
   static PageMapLevel4Entry* getRootOfKernelPagingStructure();
 
   static const size_t RESERVED_START = 0xFFFFFFFF80000ULL;
   static const size_t RESERVED_END = 0xFFFFFFFFC0000ULL;
 
+  static const size_t HUGE_PAGE_SIZE = PAGE_SIZE * PAGE_TABLE_ENTRIES;
+
 private:
 
+/**
+ * the TLB entries of this address space might be stale on any cpu now, every cpu flushes
+ * them the next time it loads the address space
+ */
+  void invalidateAddressSpace();
+
+/**
+ * invalidates the pages collected by a shootdown on this cpu and makes sure the other
+ * cpus which might hold entries of this address space do not use them anymore
+ */
+  void invalidateTranslations(const TlbShootdown& shootdown);
+
+/**
+ * common part of mapPage and mapSharedPage
+ */
+  bool insertPage(uint64 virtual_page, uint64 physical_page, uint64 user_access, bool copy_on_write);
+
+/**
+ * common part of mapRange and mapSharedRange
+ */
+  size_t insertRange(uint64 first_virtual_page, uint64 num_pages, const uint64* physical_pages, uint64 user_access,
+                     bool copy_on_write);
+
+/**
+ * frees the page table of a mapping if no page is left in it, and the tables above it
+ * which become empty then. A mapping without a page table starts at its page directory.
+ *
+ * @param m the mapping of a page which has just been unmapped
+ * @param page_table_empty the caller knows the page table is empty, it is not scanned
+ */
+  void removeEmptyTables(const ArchMemoryMapping& m, bool page_table_empty = false);
+
+/**
+ * allocates the page directory pointer table and the page directory of a mapping
+ * unless they are present already
+ */
+  void insertPageDirectory(ArchMemoryMapping& m);
+
+/**
+ * replaces a huge page by a page table mapping the same frames with 4 KiB pages, the
+ * frames can be unmapped and freed one by one afterwards
+ *
+ * @param virtual_page any page inside the huge page
+ */
+  void splitHugePage(uint64 virtual_page);
+
 /** 
  * Adds a page directory entry to the given page directory.
  * (In other words, adds the reference to a new page table to a given
@@ -144,8 +317,45 @@ private:
  */
   template<typename T> static bool checkAndRemove(pointer map_ptr, uint64 index);
 
-  ArchMemory(ArchMemory const &src);
   ArchMemory &operator=(ArchMemory const &src);
 
 };
 
+/**
+ * Collects the pages of an address space whose entries changed, so their TLB entries are
+ * invalidated at once when the shootdown is flushed or destroyed. Once more than MAX_PAGES
+ * pages are collected, the whole address space is flushed instead.
+ *
+ * The cpu flushing the shootdown invalidates the pages itself. The other cpus which loaded
+ * the address space since its last invalidation flush all its entries the next time they
+ * load it, so a shootdown only costs them something if they actually ran the address space.
+ * That is the part interrupts to the other cpus will take over, once they run threads.
+ */
+class TlbShootdown
+{
+  public:
+    static const size_t MAX_PAGES = 32;
+
+    TlbShootdown(ArchMemory& arch_memory);
+    ~TlbShootdown();
+
+    void addPage(uint64 virtual_page);
+    void addRange(uint64 first_virtual_page, uint64 num_pages);
+    void addAll();
+
+    /**
+     * invalidates the collected pages, the shootdown is empty afterwards
+     */
+    void flush();
+
+  private:
+    friend class ArchMemory;
+
+    ArchMemory& arch_memory_;
+    uint64 pages_[MAX_PAGES];
+    size_t num_pages_;
+    bool all_;
+
+    TlbShootdown(TlbShootdown const&);
+    TlbShootdown &operator=(TlbShootdown const&);
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "types.h"
+
+class Thread;
+struct ArchThreadRegisters;
+
+/**
+ * Physical address the application processors start at, it has to be page aligned
+ * and below 1 MiB. The page is never handed out by the PageManager.
+ */
+#define AP_TRAMPOLINE_PHYSICAL 0x8000ULL
+
+/**
+ * 64 bit task state segment, every cpu needs its own one since rsp0 is per cpu
+ */
+struct TaskStateSegment
+{
+  uint32 reserved_0;
+  uint64 rsp0;
+  uint64 rsp1;
+  uint64 rsp2;
+  uint64 reserved_1;
+  uint64 ist[7];
+  uint64 reserved_2;
+  uint16 reserved_3;
+  uint16 iomap_base;
+}__attribute__((__packed__));
+
+/**
+ * Everything which exists once per cpu. The GS segment base of every cpu points to
+ * its CpuLocalStorage while it executes kernel code, so the fields can be read with a
+ * single gs relative instruction. The user gs base is kept in the KERNEL_GS_BASE msr,
+ * the interrupt entry and exit code swaps both with swapgs whenever it comes from or
+ * returns to userspace.
+ */
+struct CpuLocalStorage
+{
+  CpuLocalStorage* self;
+  Thread* current_thread;
+  ArchThreadRegisters* current_thread_registers;
+  size_t cpu_id;
+  uint32 apic_id;
+  TaskStateSegment tss;
+  SegmentDescriptor gdt[7];
+};
+
+class ArchMulticore
+{
+  public:
+    static const size_t MAX_CPUS = 8;
+
+    /**
+     * sets up the cpu local storage of the boot cpu, has to be the first thing
+     * done in startup() since currentThread is not accessible before
+     */
+    static void initialise();
+
+    /**
+     * Wakes up the application processors via INIT-SIPI-SIPI. They switch to long mode
+     * in the trampoline, set up their own GDT, TSS and cpu local storage and wait in a
+     * halt loop afterwards. Needs the local APIC, the TSC and the kernel heap.
+     */
+    static void startOtherCpus();
+
+    /**
+     * @return number of cpus which are up and running
+     */
+    static size_t numCpus();
+
+    static size_t cpuId()
+    {
+      size_t id;
+      asm volatile("movq %%gs:%c1, %0" : "=r"(id) : "i"(__builtin_offsetof(CpuLocalStorage, cpu_id)));
+      return id;
+    }
+
+    static Thread* getCurrentThread()
+    {
+      Thread* thread;
+      asm volatile("movq %%gs:%c1, %0" : "=r"(thread) : "i"(__builtin_offsetof(CpuLocalStorage, current_thread)));
+      return thread;
+    }
+
+    static void setCurrentThread(Thread* thread)
+    {
+      asm volatile("movq %0, %%gs:%c1" : : "r"(thread), "i"(__builtin_offsetof(CpuLocalStorage, current_thread)) : "memory");
+    }
+
+    static ArchThreadRegisters* getCurrentThreadRegisters()
+    {
+      ArchThreadRegisters* registers;
+      asm volatile("movq %%gs:%c1, %0" : "=r"(registers) :
+                   "i"(__builtin_offsetof(CpuLocalStorage, current_thread_registers)));
+      return registers;
+    }
+
+    static void setCurrentThreadRegisters(ArchThreadRegisters* registers)
+    {
+      asm volatile("movq %0, %%gs:%c1" : : "r"(registers),
+                   "i"(__builtin_offsetof(CpuLocalStorage, current_thread_registers)) : "memory");
+    }
+
+    /**
+     * sets the stack the cpu switches to on an interrupt from userspace
+     */
+    static void setKernelStack(size_t rsp0)
+    {
+      asm volatile("movq %0, %%gs:%c1" : : "r"(rsp0),
+                   "i"(__builtin_offsetof(CpuLocalStorage, tss) + __builtin_offsetof(TaskStateSegment, rsp0)) : "memory");
+    }
+
+    /**
+     * called by ap_entry once an application processor reached long mode
+     */
+    static void initialiseApplicationProcessor(size_t cpu_id);
+
+  private:
+    /**
+     * loads a private copy of the kernel GDT with the TSS descriptor pointing to the
+     * TSS of this cpu and points the gs base to the cpu local storage
+     * @param kernel_stack initial rsp0 of the TSS
+     */
+    static void initialiseCpuLocalStorage(size_t cpu_id, size_t kernel_stack);
+
+    static CpuLocalStorage cpus_[MAX_CPUS];
+    static size_t num_cpus_;
+};
+
+#define currentThread (ArchMulticore::getCurrentThread())
+#define currentThreadRegisters (ArchMulticore::getCurrentThreadRegisters())
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * Physical address of the local APIC registers, the boot time page tables map them
+ * uncached to LOCAL_APIC_VIRTUAL_BASE (page directory entry 503 of the kernel mapping).
+ */
+#define LOCAL_APIC_PHYSICAL_BASE 0xFEE00000ULL
+#define LOCAL_APIC_VIRTUAL_BASE 0xFFFFFFFFBEE00000ULL
+
+/**
+ * The local APIC of the calling cpu, every cpu accesses its own one at the same address.
+ * On the boot cpu the timer is used in one-shot mode, it replaces the periodic PIT
+ * interrupt. The timer uses the vector of IRQ 0, so the usual irqHandler_0 handles it
+ * and the PIT has to be masked at the PIC. Besides that it sends the IPIs which start
+ * the application processors.
+ */
+class LocalAPIC
+{
+  public:
+    static const uint32 TIMER_VECTOR = 32;
+    static const uint32 SPURIOUS_VECTOR = 127;
+
+    /**
+     * checks whether there is a local APIC at the expected address, enables it and
+     * calibrates its timer against the TSC
+     * @return false if no usable local APIC has been found
+     */
+    static bool initialise();
+
+    static bool isEnabled();
+
+    /**
+     * lets the timer fire once after the given time
+     * @param ns nanoseconds from now, 0 stops the timer
+     */
+    static void setOneShotTimer(uint64 ns);
+
+    static void sendEOI();
+
+    /**
+     * @return the id of the local APIC of the calling cpu
+     */
+    static uint32 id();
+
+    /**
+     * software enables the local APIC of an application processor, its timer stays masked
+     */
+    static void initialiseApplicationProcessor();
+
+    /**
+     * Sends INIT followed by two STARTUP IPIs to every other cpu, as described in the
+     * Intel MultiProcessor Specification. They start in real mode at vector_page * PAGE_SIZE.
+     * Takes a bit more than 10 ms.
+     * @param vector_page physical page number of the start address, has to be below 1 MiB
+     */
+    static void startOtherCpus(uint8 vector_page);
+
+  private:
+    static uint32 readRegister(uint32 offset);
+    static void writeRegister(uint32 offset, uint32 value);
+    static void sendIPI(uint32 command);
+
+    static bool enabled_;
+    static uint64 timer_ticks_per_ms_;
+};
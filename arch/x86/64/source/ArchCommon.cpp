@@ -10,6 +10,8 @@
 #include "ports.h"
 #include "SWEBDebugInfo.h"
 #include "PageManager.h"
+#include "TimeStampCounter.h"
+#include "ArchMulticore.h"
 
 extern void* kernel_end_address;
 
@@ -185,6 +187,10 @@ size_t ArchCommon::getUsableMemoryRegion(size_t region, pointer &start_address,
   end_address = mbr.memory_maps[region].end_address;
   type = mbr.memory_maps[region].type;
 
+  // keep the real mode area up to the trampoline of the application processors for ourselves
+  if (type == 1 && start_address <= AP_TRAMPOLINE_PHYSICAL && end_address > AP_TRAMPOLINE_PHYSICAL)
+    start_address = Min(end_address, AP_TRAMPOLINE_PHYSICAL + PAGE_SIZE);
+
   return 0;
 }
 
@@ -262,7 +268,13 @@ void ArchCommon::initDebug()
 
 void ArchCommon::idle()
 {
-  asm volatile("hlt");
+  asm volatile("sti\n"
+               "hlt"); // sti only takes effect after hlt, no interrupt can get lost in between
+}
+
+uint64 ArchCommon::getMonotonicTimeNs()
+{
+  return TimeStampCounter::nsSinceBoot();
 }
 
 #define STATS_OFFSET 22
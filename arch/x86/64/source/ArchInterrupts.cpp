@@ -3,8 +3,11 @@
 #include "ports.h"
 #include "InterruptUtils.h"
 #include "ArchThreads.h"
+#include "ArchMemory.h"
 #include "assert.h"
 #include "Thread.h"
+#include "TimeStampCounter.h"
+#include "LocalAPIC.h"
 
 void ArchInterrupts::initialise()
 {
@@ -14,6 +17,7 @@ void ArchInterrupts::initialise()
   InterruptUtils::initialise();
   for (i=0;i<16;++i)
     disableIRQ(i);
+  TimeStampCounter::calibrate();
 }
 
 void ArchInterrupts::enableTimer()
@@ -38,6 +42,20 @@ void ArchInterrupts::disableTimer()
   disableIRQ(0);
 }
 
+bool ArchInterrupts::enableOneShotTimer()
+{
+  if (!LocalAPIC::initialise())
+    return false;
+  // the local APIC timer uses the vector of IRQ 0, the PIT must not deliver anything there anymore
+  disableIRQ(0);
+  return true;
+}
+
+void ArchInterrupts::setOneShotTimer(uint64 ns)
+{
+  LocalAPIC::setOneShotTimer(ns);
+}
+
 void ArchInterrupts::enableKBD()
 {
   enableIRQ(1);
@@ -51,7 +69,13 @@ void ArchInterrupts::disableKBD()
 
 void ArchInterrupts::EndOfInterrupt(uint16 number) 
 {
-  sendEOI(number);
+  if (number == 0 && LocalAPIC::isEnabled())
+  {
+    --outstanding_EOIs;
+    LocalAPIC::sendEOI();
+  }
+  else
+    sendEOI(number);
 }
 
 void ArchInterrupts::enableInterrupts()
@@ -159,13 +183,6 @@ extern "C" void arch_saveThreadRegisters(uint64* base, uint64 error)
   assert(!currentThread || currentThread->isStackCanaryOK());
 }
 
-typedef struct {
-    uint32 padding;
-    uint64 rsp0; // actually the TSS has more fields, but we don't need them
-} __attribute__((__packed__))TSS;
-
-extern TSS g_tss;
-
 extern "C" void arch_contextSwitch()
 {
   if(outstanding_EOIs)
@@ -180,9 +197,11 @@ extern "C" void arch_contextSwitch()
   }
   assert(currentThread->isStackCanaryOK() && "Kernel stack corruption detected.");
   ArchThreadRegisters info = *currentThreadRegisters; // optimization: local copy produces more efficient code in this case
-  g_tss.rsp0 = info.rsp0;
+  ArchMulticore::setKernelStack(info.rsp0);
   asm("frstor %[fpu]\n" : : [fpu]"m"(info.fpu));
-  asm("mov %[cr3], %%cr3\n" : : [cr3]"r"(info.cr3));
+  ArchMemory::loadAddressSpace(info.cr3);
+  if (info.cs & 3)
+    asm("swapgs"); // the user gs base, no cpu local storage accessible from here on
   asm("push %[ss]" : : [ss]"m"(info.ss));
   asm("push %[rsp]" : : [rsp]"m"(info.rsp));
   asm("push %[rflags]\n" : : [rflags]"m"(info.rflags));
@@ -4,19 +4,298 @@
 #include "assert.h"
 #include "PageManager.h"
 #include "kstring.h"
+#include "ArchMulticore.h"
+
+#define CPUID_FEATURE_ECX_PCID (1 << 17)
+#define CPUID_EXTENDED_FEATURE_EBX_INVPCID (1 << 10)
+#define CR4_PGE (1ULL << 7)
+#define CR4_PCIDE (1ULL << 17)
+#define CR3_PCID_MASK 0xFFFULL
+#define CR3_NO_FLUSH (1ULL << 63)
+#define INVPCID_ADDRESS 0
+#define INVPCID_SINGLE_CONTEXT 1
+#define INVPCID_ALL_CONTEXTS_AND_GLOBAL 2
 
 PageMapLevel4Entry kernel_page_map_level_4[PAGE_MAP_LEVEL_4_ENTRIES] __attribute__((aligned(0x1000)));
 PageDirPointerTableEntry kernel_page_directory_pointer_table[2 * PAGE_DIR_POINTER_TABLE_ENTRIES] __attribute__((aligned(0x1000)));
 PageDirEntry kernel_page_directory[2 * PAGE_DIR_ENTRIES] __attribute__((aligned(0x1000)));
 PageTableEntry kernel_page_table[8 * PAGE_TABLE_ENTRIES] __attribute__((aligned(0x1000)));
 
+/**
+ * pcid 0 tags the kernel threads, whose address space has no user part to go stale.
+ * Address spaces which find all other pcids taken share SHARED_PCID, which is flushed
+ * on every load. Every change of an address space and every new owner of a pcid gets a
+ * new generation, a cpu keeps the TLB entries of a pcid while the generation it last
+ * loaded is still the current one. pcid_cpus are the cpus which loaded the current
+ * generation of a pcid, only they can hold its entries.
+ */
+#define NUM_PCIDS 256
+#define SHARED_PCID 1
+
+static bool pcid_enabled = false;
+static bool invpcid_supported = false;
+static uint64 used_pcids[NUM_PCIDS / 64] = { (1ULL << 0) | (1ULL << SHARED_PCID) };
+static uint64 next_tlb_generation = 0;
+static uint64 pcid_generations[NUM_PCIDS];
+static uint64 pcid_cpus[NUM_PCIDS];
+static uint64 loaded_pcid_generations[ArchMulticore::MAX_CPUS][NUM_PCIDS];
 
-ArchMemory::ArchMemory()
+static uint16 allocatePcid()
+{
+  for (size_t word = 0; word < NUM_PCIDS / 64; ++word)
+  {
+    uint64 used = __atomic_load_n(&used_pcids[word], __ATOMIC_RELAXED);
+    while (~used)
+    {
+      uint64 bit = __builtin_ctzll(~used);
+      if (__atomic_compare_exchange_n(&used_pcids[word], &used, used | (1ULL << bit), true, __ATOMIC_ACQ_REL,
+                                      __ATOMIC_RELAXED))
+        return word * 64 + bit;
+    }
+  }
+  return SHARED_PCID;
+}
+
+static void freePcid(uint16 pcid)
+{
+  __atomic_and_fetch(&used_pcids[pcid / 64], ~(1ULL << (pcid % 64)), __ATOMIC_RELEASE);
+}
+
+static inline void invpcid(uint64 type, uint64 pcid, uint64 address)
+{
+  struct
+  {
+    uint64 pcid;
+    uint64 address;
+  } descriptor = { pcid, address };
+  asm volatile("invpcid %0, %1" : : "m"(descriptor), "r"(type) : "memory");
+}
+
+ArchMemory::ArchMemory() : pcid_(0)
 {
   page_map_level_4_ = PageManager::instance()->allocPPN();
   PageMapLevel4Entry* new_pml4 = (PageMapLevel4Entry*) getIdentAddressOfPPN(page_map_level_4_);
   memcpy((void*) new_pml4, (void*) kernel_page_map_level_4, PAGE_SIZE);
   memset(new_pml4, 0, PAGE_SIZE / 2); // should be zero, this is just for safety
+  if (pcid_enabled)
+  {
+    pcid_ = allocatePcid();
+    // the previous owner of the pcid may have left entries in the TLBs
+    invalidateAddressSpace();
+  }
+}
+
+ArchMemory::ArchMemory(ArchMemory& parent) : ArchMemory()
+{
+  PageMapLevel4Entry* pml4 = (PageMapLevel4Entry*) getIdentAddressOfPPN(page_map_level_4_);
+  PageMapLevel4Entry* parent_pml4 = (PageMapLevel4Entry*) getIdentAddressOfPPN(parent.page_map_level_4_);
+  for (uint64 pml4i = 0; pml4i < PAGE_MAP_LEVEL_4_ENTRIES / 2; pml4i++) // copy only lower half
+  {
+    if (!parent_pml4[pml4i].present)
+      continue;
+    uint64 pdpt_ppn = PageManager::instance()->allocPPN();
+    insert<PageMapLevel4Entry>((pointer) pml4, pml4i, pdpt_ppn, 0, 0, 1, 1);
+    PageDirPointerTableEntry* parent_pdpt = (PageDirPointerTableEntry*) getIdentAddressOfPPN(parent_pml4[pml4i].page_ppn);
+    for (uint64 pdpti = 0; pdpti < PAGE_DIR_POINTER_TABLE_ENTRIES; pdpti++)
+    {
+      if (!parent_pdpt[pdpti].pd.present)
+        continue;
+      assert(parent_pdpt[pdpti].pd.size == 0);
+      uint64 pd_ppn = PageManager::instance()->allocPPN();
+      insert<PageDirPointerTablePageDirEntry>(getIdentAddressOfPPN(pdpt_ppn), pdpti, pd_ppn, 0, 0, 1, 1);
+      PageDirEntry* parent_pd = (PageDirEntry*) getIdentAddressOfPPN(parent_pdpt[pdpti].pd.page_ppn);
+      for (uint64 pdi = 0; pdi < PAGE_DIR_ENTRIES; pdi++)
+      {
+        if (!parent_pd[pdi].pt.present)
+          continue;
+        if (parent_pd[pdi].page.size)
+          parent.splitHugePage(((pml4i * PAGE_DIR_POINTER_TABLE_ENTRIES + pdpti) * PAGE_DIR_ENTRIES + pdi) *
+                               PAGE_TABLE_ENTRIES);
+        uint64 pt_ppn = PageManager::instance()->allocPPN(PAGE_SIZE, PageManager::ALLOC_NO_ZERO);
+        insert<PageDirPageTableEntry>(getIdentAddressOfPPN(pd_ppn), pdi, pt_ppn, 0, 0, 1, 1);
+        PageTableEntry* parent_pt = (PageTableEntry*) getIdentAddressOfPPN(parent_pd[pdi].pt.page_ppn);
+        for (uint64 pti = 0; pti < PAGE_TABLE_ENTRIES; pti++)
+        {
+          if (!parent_pt[pti].present)
+            continue;
+          if (parent_pt[pti].writeable)
+          {
+            parent_pt[pti].writeable = 0;
+            parent_pt[pti].cow = 1;
+          }
+          PageManager::instance()->shareFrame(parent_pt[pti].page_ppn);
+        }
+        // the entries of both page tables are the same now
+        memcpy((void*) getIdentAddressOfPPN(pt_ppn), (void*) parent_pt, PAGE_SIZE);
+      }
+    }
+  }
+  // the writeable pages of the parent are read only now
+  parent.flushAll();
+}
+
+void ArchMemory::invalidateAddressSpace()
+{
+  if (pcid_ <= SHARED_PCID)
+    return;
+  __atomic_store_n(&pcid_generations[pcid_], __atomic_add_fetch(&next_tlb_generation, 1, __ATOMIC_RELAXED),
+                   __ATOMIC_RELEASE);
+  __atomic_store_n(&pcid_cpus[pcid_], 0, __ATOMIC_RELEASE);
+}
+
+void ArchMemory::invalidateTranslations(const TlbShootdown& shootdown)
+{
+  if (!shootdown.all_ && !shootdown.num_pages_)
+    return;
+
+  uint64 cr3;
+  asm volatile("mov %%cr3, %0" : "=r"(cr3));
+  bool loaded = (cr3 & ~CR3_PCID_MASK) == page_map_level_4_ * PAGE_SIZE;
+
+  // only address spaces with a pcid of their own keep TLB entries while they are not loaded
+  if (pcid_enabled && pcid_ > SHARED_PCID)
+  {
+    uint64 this_cpu = 1ULL << ArchMulticore::cpuId();
+    uint64 cpus = __atomic_load_n(&pcid_cpus[pcid_], __ATOMIC_ACQUIRE);
+    if (cpus & ~this_cpu)
+      invalidateAddressSpace();
+    else if (!loaded && (cpus & this_cpu))
+    {
+      if (!invpcid_supported)
+        invalidateAddressSpace();
+      else if (shootdown.all_)
+        invpcid(INVPCID_SINGLE_CONTEXT, pcid_, 0);
+      else
+      {
+        for (size_t i = 0; i < shootdown.num_pages_; ++i)
+          invpcid(INVPCID_ADDRESS, pcid_, shootdown.pages_[i] * PAGE_SIZE);
+      }
+    }
+  }
+
+  if (!loaded)
+    return;
+  if (shootdown.all_)
+  {
+    // without the no flush bit, loading cr3 flushes the entries of its pcid
+    asm volatile("mov %0, %%cr3" : : "r"(cr3 & ~CR3_NO_FLUSH) : "memory");
+    return;
+  }
+  for (size_t i = 0; i < shootdown.num_pages_; ++i)
+    asm volatile ("invlpg (%0)" : : "r"(shootdown.pages_[i] * PAGE_SIZE) : "memory");
+}
+
+void ArchMemory::flushPage(uint64 virtual_page)
+{
+  TlbShootdown shootdown(*this);
+  shootdown.addPage(virtual_page);
+}
+
+void ArchMemory::flushRange(uint64 first_virtual_page, uint64 num_pages)
+{
+  TlbShootdown shootdown(*this);
+  shootdown.addRange(first_virtual_page, num_pages);
+}
+
+void ArchMemory::flushAll()
+{
+  TlbShootdown shootdown(*this);
+  shootdown.addAll();
+}
+
+const size_t TlbShootdown::MAX_PAGES;
+
+TlbShootdown::TlbShootdown(ArchMemory& arch_memory) : arch_memory_(arch_memory), num_pages_(0), all_(false)
+{
+}
+
+TlbShootdown::~TlbShootdown()
+{
+  flush();
+}
+
+void TlbShootdown::addPage(uint64 virtual_page)
+{
+  if (num_pages_ == MAX_PAGES)
+    all_ = true;
+  if (!all_)
+    pages_[num_pages_++] = virtual_page;
+}
+
+void TlbShootdown::addRange(uint64 first_virtual_page, uint64 num_pages)
+{
+  if (num_pages > MAX_PAGES - num_pages_)
+    all_ = true;
+  for (uint64 page = first_virtual_page; !all_ && page < first_virtual_page + num_pages; ++page)
+    pages_[num_pages_++] = page;
+}
+
+void TlbShootdown::addAll()
+{
+  all_ = true;
+}
+
+void TlbShootdown::flush()
+{
+  arch_memory_.invalidateTranslations(*this);
+  num_pages_ = 0;
+  all_ = false;
+}
+
+uint64 ArchMemory::getValueForCR3()
+{
+  return page_map_level_4_ * PAGE_SIZE | pcid_;
+}
+
+void ArchMemory::enableTlbTagging()
+{
+  uint32 eax = 1, ebx, ecx, edx;
+  asm volatile("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+  pcid_enabled = ecx & CPUID_FEATURE_ECX_PCID;
+  eax = 7;
+  ecx = 0;
+  asm volatile("cpuid" : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+  invpcid_supported = pcid_enabled && (ebx & CPUID_EXTENDED_FEATURE_EBX_INVPCID);
+
+  uint64 cr4;
+  asm volatile("mov %%cr4, %0" : "=r"(cr4));
+  // only the kernel pml4 without a pcid is loaded at this point, as pcide requires
+  if (pcid_enabled)
+    cr4 |= CR4_PCIDE;
+  // enabling pge flushes the whole TLB, including what is left of the boot time ident mapping
+  asm volatile("mov %0, %%cr4" : : "r"(cr4 & ~CR4_PGE) : "memory");
+  asm volatile("mov %0, %%cr4" : : "r"(cr4 | CR4_PGE) : "memory");
+  debug(A_MEMORY, "enableTlbTagging: global kernel pages, pcids %s, invpcid %s\n", pcid_enabled ? "on" : "off",
+        invpcid_supported ? "on" : "off");
+}
+
+void ArchMemory::loadAddressSpace(uint64 cr3)
+{
+  if (pcid_enabled)
+  {
+    uint64 pcid = cr3 & CR3_PCID_MASK;
+    uint64 generation = __atomic_load_n(&pcid_generations[pcid], __ATOMIC_ACQUIRE);
+    size_t cpu = ArchMulticore::cpuId();
+    uint64& loaded_generation = loaded_pcid_generations[cpu][pcid];
+    if (pcid != SHARED_PCID && loaded_generation == generation)
+      cr3 |= CR3_NO_FLUSH;
+    loaded_generation = generation;
+    __atomic_or_fetch(&pcid_cpus[pcid], 1ULL << cpu, __ATOMIC_RELEASE);
+  }
+  asm volatile("mov %0, %%cr3" : : "r"(cr3) : "memory");
+}
+
+void ArchMemory::flushAllTranslations()
+{
+  if (invpcid_supported)
+  {
+    invpcid(INVPCID_ALL_CONTEXTS_AND_GLOBAL, 0, 0);
+    return;
+  }
+  uint64 cr4;
+  asm volatile("mov %%cr4, %0" : "=r"(cr4));
+  asm volatile("mov %0, %%cr4" : : "r"(cr4 & ~CR4_PGE) : "memory");
+  asm volatile("mov %0, %%cr4" : : "r"(cr4) : "memory");
 }
 
 template<typename T>
@@ -36,27 +315,118 @@ bool ArchMemory::checkAndRemove(pointer map_ptr, uint64 index)
 bool ArchMemory::unmapPage(uint64 virtual_page)
 {
   ArchMemoryMapping m = resolveMapping(virtual_page);
+  if (m.page_size == HUGE_PAGE_SIZE)
+  {
+    splitHugePage(virtual_page);
+    m = resolveMapping(virtual_page);
+  }
 
   assert(m.page_ppn != 0 && m.page_size == PAGE_SIZE && m.pt[m.pti].present);
   m.pt[m.pti].present = 0;
+  // nobody may access the page through a stale entry once it is free
+  flushPage(virtual_page);
   PageManager::instance()->freePPN(m.page_ppn);
   ((uint64*)m.pt)[m.pti] = 0; // for easier debugging
-  bool empty = checkAndRemove<PageTableEntry>(getIdentAddressOfPPN(m.pt_ppn), m.pti);
-  if (empty)
-  {
-    PageManager::instance()->freePPN(m.pt_ppn);
-    empty = checkAndRemove<PageDirPageTableEntry>(getIdentAddressOfPPN(m.pd_ppn), m.pdi);
-  }
-  if (empty)
+  removeEmptyTables(m);
+  return true;
+}
+
+void ArchMemory::unmapRange(uint64 first_virtual_page, uint64 num_pages)
+{
+  const uint64 end = first_virtual_page + num_pages;
+  const uint64 pd_pages = PAGE_TABLE_ENTRIES * PAGE_DIR_ENTRIES;
+  const uint64 pdpt_pages = pd_pages * PAGE_DIR_POINTER_TABLE_ENTRIES;
+  TlbShootdown shootdown(*this);
+
+  uint64 virtual_page = first_virtual_page;
+  while (virtual_page < end)
   {
-    PageManager::instance()->freePPN(m.pd_ppn);
-    empty = checkAndRemove<PageDirPointerTablePageDirEntry>(getIdentAddressOfPPN(m.pdpt_ppn), m.pdpti);
+    ArchMemoryMapping m = resolveMapping(virtual_page);
+    // skip the tables which are not there at once
+    if (!m.pdpt)
+    {
+      virtual_page = (virtual_page / pdpt_pages + 1) * pdpt_pages;
+      continue;
+    }
+    if (!m.pd)
+    {
+      virtual_page = (virtual_page / pd_pages + 1) * pd_pages;
+      continue;
+    }
+
+    const uint64 table_end = Min(end, (virtual_page / PAGE_TABLE_ENTRIES + 1) * PAGE_TABLE_ENTRIES);
+    const bool whole_table = table_end - virtual_page == PAGE_TABLE_ENTRIES;
+    if (m.page_size == HUGE_PAGE_SIZE && whole_table)
+    {
+      m.pd[m.pdi].page.present = 0;
+      shootdown.addPage(virtual_page);
+      shootdown.flush();
+      PageManager::instance()->freePPN(m.page_ppn * PAGE_TABLE_ENTRIES, HUGE_PAGE_SIZE);
+      removeEmptyTables(m);
+      virtual_page = table_end;
+      continue;
+    }
+    if (m.page_size == HUGE_PAGE_SIZE)
+    {
+      splitHugePage(virtual_page);
+      m = resolveMapping(virtual_page);
+    }
+    if (!m.pt)
+    {
+      virtual_page = table_end;
+      continue;
+    }
+
+    const uint64 last_pti = m.pti + (table_end - virtual_page);
+    for (uint64 pti = m.pti; pti < last_pti; pti++)
+    {
+      if (!m.pt[pti].present)
+        continue;
+      m.pt[pti].present = 0;
+      shootdown.addPage(virtual_page + pti - m.pti);
+    }
+    // nobody may access the pages through stale entries once they are free
+    shootdown.flush();
+    for (uint64 pti = m.pti; pti < last_pti; pti++)
+    {
+      if (m.pt[pti].page_ppn)
+        PageManager::instance()->freePPN(m.pt[pti].page_ppn);
+      ((uint64*)m.pt)[pti] = 0;
+    }
+    removeEmptyTables(m, whole_table);
+    virtual_page = table_end;
   }
-  if (empty)
+}
+
+void ArchMemory::removeEmptyTables(const ArchMemoryMapping& m, bool page_table_empty)
+{
+  if (m.pt_ppn)
   {
-    PageManager::instance()->freePPN(m.pdpt_ppn);
-    empty = checkAndRemove<PageMapLevel4Entry>(getIdentAddressOfPPN(m.pml4_ppn), m.pml4i);
+    if (!page_table_empty && !checkAndRemove<PageTableEntry>(getIdentAddressOfPPN(m.pt_ppn), m.pti))
+      return;
+    PageManager::instance()->freePPN(m.pt_ppn);
   }
+  if (!checkAndRemove<PageDirPageTableEntry>(getIdentAddressOfPPN(m.pd_ppn), m.pdi))
+    return;
+  PageManager::instance()->freePPN(m.pd_ppn);
+  if (!checkAndRemove<PageDirPointerTablePageDirEntry>(getIdentAddressOfPPN(m.pdpt_ppn), m.pdpti))
+    return;
+  PageManager::instance()->freePPN(m.pdpt_ppn);
+  checkAndRemove<PageMapLevel4Entry>(getIdentAddressOfPPN(m.pml4_ppn), m.pml4i);
+}
+
+bool ArchMemory::copyOnWrite(uint64 virtual_page)
+{
+  ArchMemoryMapping m = resolveMapping(virtual_page);
+  if (m.page_size != PAGE_SIZE || !m.pt[m.pti].cow)
+    return false;
+
+  m.pt[m.pti].page_ppn = PageManager::instance()->copySharedFrame(m.page_ppn);
+  m.pt[m.pti].cow = 0;
+  m.pt[m.pti].writeable = 1;
+  flushPage(virtual_page);
+  debug(A_MEMORY, "copyOnWrite: page %zx now uses ppn %zx instead of %zx\n", virtual_page,
+        (size_t)m.pt[m.pti].page_ppn, m.page_ppn);
   return true;
 }
 
@@ -82,11 +452,98 @@ bool ArchMemory::insert(pointer map_ptr, uint64 index, uint64 ppn, uint64 bzero,
 }
 
 bool ArchMemory::mapPage(uint64 virtual_page, uint64 physical_page, uint64 user_access)
+{
+  return insertPage(virtual_page, physical_page, user_access, false);
+}
+
+bool ArchMemory::mapSharedPage(uint64 virtual_page, uint64 physical_page)
+{
+  return insertPage(virtual_page, physical_page, 1, true);
+}
+
+size_t ArchMemory::mapRange(uint64 first_virtual_page, uint64 num_pages, const uint64* physical_pages,
+                            uint64 user_access)
+{
+  return insertRange(first_virtual_page, num_pages, physical_pages, user_access, false);
+}
+
+size_t ArchMemory::mapSharedRange(uint64 first_virtual_page, uint64 num_pages, const uint64* physical_pages)
+{
+  return insertRange(first_virtual_page, num_pages, physical_pages, 1, true);
+}
+
+size_t ArchMemory::insertRange(uint64 first_virtual_page, uint64 num_pages, const uint64* physical_pages,
+                               uint64 user_access, bool copy_on_write)
+{
+  debug(A_MEMORY, "%zx %zx - %zx %zx\n", page_map_level_4_, first_virtual_page, first_virtual_page + num_pages,
+        user_access);
+  size_t mapped = 0;
+  uint64 i = 0;
+  while (i < num_pages)
+  {
+    ArchMemoryMapping m = resolveMapping(page_map_level_4_, first_virtual_page + i);
+    const uint64 last_pti = Min(m.pti + (num_pages - i), (uint64)PAGE_TABLE_ENTRIES);
+    if (m.page_size == HUGE_PAGE_SIZE)
+    {
+      // a huge page maps them already
+      for (; m.pti < last_pti; m.pti++, i++)
+        PageManager::instance()->freePPN(physical_pages[i]);
+      continue;
+    }
+
+    insertPageDirectory(m);
+    if (m.pt_ppn == 0)
+    {
+      m.pt_ppn = PageManager::instance()->allocPPN();
+      insert<PageDirPageTableEntry>(getIdentAddressOfPPN(m.pd_ppn), m.pdi, m.pt_ppn, 1, 0, 1, 1);
+    }
+
+    PageTableEntry* pt = (PageTableEntry*) getIdentAddressOfPPN(m.pt_ppn);
+    for (; m.pti < last_pti; m.pti++, i++)
+    {
+      if (pt[m.pti].present)
+      {
+        PageManager::instance()->freePPN(physical_pages[i]);
+        continue;
+      }
+      pt[m.pti].cow = copy_on_write;
+      insert<PageTableEntry>((pointer) pt, m.pti, physical_pages[i], 0, 0, user_access, !copy_on_write);
+      ++mapped;
+    }
+  }
+  return mapped;
+}
+
+bool ArchMemory::insertPage(uint64 virtual_page, uint64 physical_page, uint64 user_access, bool copy_on_write)
 {
   debug(A_MEMORY, "%zx %zx %zx %zx\n", page_map_level_4_, virtual_page, physical_page, user_access);
   ArchMemoryMapping m = resolveMapping(page_map_level_4_, virtual_page);
+  if (m.page_size == HUGE_PAGE_SIZE)
+    return false; // a huge page maps it already
   assert((m.page_size == 0) || (m.page_size == PAGE_SIZE));
 
+  insertPageDirectory(m);
+
+  if (m.pt_ppn == 0)
+  {
+    m.pt_ppn = PageManager::instance()->allocPPN();
+    insert<PageDirPageTableEntry>(getIdentAddressOfPPN(m.pd_ppn), m.pdi, m.pt_ppn, 1, 0, 1, 1);
+  }
+
+  if (m.page_ppn == 0)
+  {
+    // the entry is not present yet, so the marker can be set before insert makes it present,
+    // and there is no TLB entry for the page which would have to be invalidated
+    ((PageTableEntry*) getIdentAddressOfPPN(m.pt_ppn))[m.pti].cow = copy_on_write;
+    return insert<PageTableEntry>(getIdentAddressOfPPN(m.pt_ppn), m.pti, physical_page, 0, 0, user_access,
+                                  !copy_on_write);
+  }
+
+  return false;
+}
+
+void ArchMemory::insertPageDirectory(ArchMemoryMapping& m)
+{
   if (m.pdpt_ppn == 0)
   {
     m.pdpt_ppn = PageManager::instance()->allocPPN();
@@ -98,62 +555,59 @@ bool ArchMemory::mapPage(uint64 virtual_page, uint64 physical_page, uint64 user_
     m.pd_ppn = PageManager::instance()->allocPPN();
     insert<PageDirPointerTablePageDirEntry>(getIdentAddressOfPPN(m.pdpt_ppn), m.pdpti, m.pd_ppn, 1, 0, 1, 1);
   }
+}
 
-  if (m.pt_ppn == 0)
-  {
-    m.pt_ppn = PageManager::instance()->allocPPN();
-    insert<PageDirPageTableEntry>(getIdentAddressOfPPN(m.pd_ppn), m.pdi, m.pt_ppn, 1, 0, 1, 1);
-  }
+bool ArchMemory::mapHugePage(uint64 virtual_page, uint64 user_access)
+{
+  assert(virtual_page % PAGE_TABLE_ENTRIES == 0);
+  ArchMemoryMapping m = resolveMapping(virtual_page);
+  // a present page table maps at least one page of the range, empty ones are freed
+  if (m.pd && m.pd[m.pdi].pt.present)
+    return false;
 
-  if (m.page_ppn == 0)
+  uint64 ppn = PageManager::instance()->allocPPN(HUGE_PAGE_SIZE, PageManager::ALLOC_MAY_FAIL);
+  if (!ppn)
+    return false;
+  insertPageDirectory(m);
+  debug(A_MEMORY, "mapHugePage: page %zx now uses ppn %zx - %zx\n", virtual_page, ppn, ppn + PAGE_TABLE_ENTRIES - 1);
+  return insert<PageDirPageEntry>(getIdentAddressOfPPN(m.pd_ppn), m.pdi, ppn / PAGE_TABLE_ENTRIES, 0, 1, user_access, 1);
+}
+
+void ArchMemory::splitHugePage(uint64 virtual_page)
+{
+  ArchMemoryMapping m = resolveMapping(virtual_page);
+  assert(m.page_size == HUGE_PAGE_SIZE);
+  PageDirPageEntry huge_page = m.pd[m.pdi].page;
+
+  uint64 pt_ppn = PageManager::instance()->allocPPN();
+  PageTableEntry* pt = (PageTableEntry*) getIdentAddressOfPPN(pt_ppn);
+  for (uint64 pti = 0; pti < PAGE_TABLE_ENTRIES; pti++)
   {
-    return insert<PageTableEntry>(getIdentAddressOfPPN(m.pt_ppn), m.pti, physical_page, 0, 0, user_access, 1);
+    pt[pti].writeable = huge_page.writeable;
+    pt[pti].user_access = huge_page.user_access;
+    pt[pti].page_ppn = huge_page.page_ppn * PAGE_TABLE_ENTRIES + pti;
+    pt[pti].present = 1;
   }
 
-  return false;
+  // the entry has to change at once, other threads of the process keep using the frames
+  PageDirEntry entry;
+  *(uint64*) &entry = 0;
+  entry.pt.present = 1;
+  entry.pt.writeable = 1;
+  entry.pt.user_access = 1;
+  entry.pt.page_ppn = pt_ppn;
+  __atomic_store_n((uint64*) &m.pd[m.pdi], *(uint64*) &entry, __ATOMIC_RELEASE);
+  // any address inside the huge page invalidates its TLB entry
+  flushPage(virtual_page);
+  debug(A_MEMORY, "splitHugePage: split the huge page around %zx\n", virtual_page);
 }
 
 ArchMemory::~ArchMemory()
 {
-  PageMapLevel4Entry* pml4 = (PageMapLevel4Entry*) getIdentAddressOfPPN(page_map_level_4_);
-  for (uint64 pml4i = 0; pml4i < PAGE_MAP_LEVEL_4_ENTRIES / 2; pml4i++) // free only lower half
-  {
-    if (pml4[pml4i].present)
-    {
-      PageDirPointerTableEntry* pdpt = (PageDirPointerTableEntry*) getIdentAddressOfPPN(pml4[pml4i].page_ppn);
-      for (uint64 pdpti = 0; pdpti < PAGE_DIR_POINTER_TABLE_ENTRIES; pdpti++)
-      {
-        if (pdpt[pdpti].pd.present)
-        {
-          assert(pdpt[pdpti].pd.size == 0);
-          PageDirEntry* pd = (PageDirEntry*) getIdentAddressOfPPN(pdpt[pdpti].pd.page_ppn);
-          for (uint64 pdi = 0; pdi < PAGE_DIR_ENTRIES; pdi++)
-          {
-            if (pd[pdi].pt.present)
-            {
-              assert(pd[pdi].pt.size == 0);
-              PageTableEntry* pt = (PageTableEntry*) getIdentAddressOfPPN(pd[pdi].pt.page_ppn);
-              for (uint64 pti = 0; pti < PAGE_TABLE_ENTRIES; pti++)
-              {
-                if (pt[pti].present)
-                {
-                  pt[pti].present = 0;
-                  PageManager::instance()->freePPN(pt[pti].page_ppn);
-                }
-              }
-              pd[pdi].pt.present = 0;
-              PageManager::instance()->freePPN(pd[pdi].pt.page_ppn);
-            }
-          }
-          pdpt[pdpti].pd.present = 0;
-          PageManager::instance()->freePPN(pdpt[pdpti].pd.page_ppn);
-        }
-      }
-      pml4[pml4i].present = 0;
-      PageManager::instance()->freePPN(pml4[pml4i].page_ppn);
-    }
-  }
+  unmapRange(0, USER_BREAK / PAGE_SIZE); // free only lower half
   PageManager::instance()->freePPN(page_map_level_4_);
+  if (pcid_ > SHARED_PCID)
+    freePcid(pcid_);
 }
 
 pointer ArchMemory::checkAddressValid(uint64 vaddress_to_check)
@@ -232,7 +686,7 @@ const ArchMemoryMapping ArchMemory::resolveMapping(uint64 pml4, uint64 vpage)
       {
         m.page_size = PAGE_SIZE * PAGE_TABLE_ENTRIES;
         m.page_ppn = m.pd[m.pdi].page.page_ppn;
-        m.page = getIdentAddressOfPPN(m.pd[m.pdi].page.page_ppn);
+        m.page = getIdentAddressOfPPN(m.pd[m.pdi].page.page_ppn, m.page_size);
       }
     }
     else if (m.pdpt[m.pdpti].page.present)
@@ -240,7 +694,7 @@ const ArchMemoryMapping ArchMemory::resolveMapping(uint64 pml4, uint64 vpage)
       m.page_size = PAGE_SIZE * PAGE_TABLE_ENTRIES * PAGE_DIR_ENTRIES;
       m.page_ppn = m.pdpt[m.pdpti].page.page_ppn;
       assert(m.page_ppn < PageManager::instance()->getTotalNumPages());
-      m.page = getIdentAddressOfPPN(m.pdpt[m.pdpti].page.page_ppn);
+      m.page = getIdentAddressOfPPN(m.pdpt[m.pdpti].page.page_ppn, m.page_size);
     }
   }
   return m;
@@ -271,9 +725,10 @@ void ArchMemory::mapKernelPage(size_t virtual_page, size_t physical_page)
   PageTableEntry *pt = (PageTableEntry*) getIdentAddressOfPPN(pd[mapping.pdi].pt.page_ppn);
   assert(!pt[mapping.pti].present);
   pt[mapping.pti].writeable = 1;
+  pt[mapping.pti].global = 1;
   pt[mapping.pti].page_ppn = physical_page;
   pt[mapping.pti].present = 1;
-  asm volatile ("movq %%cr3, %%rax; movq %%rax, %%cr3;" ::: "%rax");
+  asm volatile ("invlpg (%0)" : : "r"(virtual_page * PAGE_SIZE) : "memory");
 }
 
 void ArchMemory::unmapKernelPage(size_t virtual_page)
@@ -290,8 +745,10 @@ void ArchMemory::unmapKernelPage(size_t virtual_page)
   assert(pt[mapping.pti].present);
   pt[mapping.pti].present = 0;
   pt[mapping.pti].writeable = 0;
+  pt[mapping.pti].global = 0;
   PageManager::instance()->freePPN(pt[mapping.pti].page_ppn);
-  asm volatile ("movq %%cr3, %%rax; movq %%rax, %%cr3;" ::: "%rax");
+  // reloading cr3 would keep the global entry
+  asm volatile ("invlpg (%0)" : : "r"(virtual_page * PAGE_SIZE) : "memory");
 }
 
 uint64 ArchMemory::getRootOfPagingStructure()
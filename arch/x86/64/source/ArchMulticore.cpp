@@ -0,0 +1,187 @@
+#include "ArchMulticore.h"
+#include "ArchMemory.h"
+#include "InterruptUtils.h"
+#include "LocalAPIC.h"
+#include "TimeStampCounter.h"
+#include "offsets.h"
+#include "kstring.h"
+#include "assert.h"
+#include "debug.h"
+
+#define IA32_GS_BASE_MSR 0xC0000101
+#define IA32_KERNEL_GS_BASE_MSR 0xC0000102
+
+#define TSS_TYPE_AVAILABLE 0x89 // present, available 64 bit TSS
+
+#define AP_STACK_SIZE 0x4000
+#define AP_STARTUP_TIMEOUT_NS 100000000ULL
+
+extern SegmentDescriptor gdt[7];
+extern PageMapLevel4Entry kernel_page_map_level_4[];
+extern uint8 boot_stack[0x4000];
+
+extern "C" char ap_trampoline_start[];
+extern "C" char ap_trampoline_data[];
+extern "C" char ap_trampoline_end[];
+
+/**
+ * the variables at the end of the trampoline, see ap_trampoline.S
+ */
+struct ApTrampolineData
+{
+  uint64 cr3;
+  uint64 cr4;
+  uint64 next_ticket;
+  uint64 stacks[ArchMulticore::MAX_CPUS - 1];
+};
+
+struct GDTR
+{
+  uint16 limit;
+  uint64 base;
+}__attribute__((__packed__));
+
+const size_t ArchMulticore::MAX_CPUS;
+
+CpuLocalStorage ArchMulticore::cpus_[MAX_CPUS];
+size_t ArchMulticore::num_cpus_ = 0;
+
+static IDTR ap_idtr;
+
+static inline void wrmsr(uint32 msr, uint64 value)
+{
+  asm volatile("wrmsr" : : "c"(msr), "a"((uint32)value), "d"((uint32)(value >> 32)));
+}
+
+void ArchMulticore::initialise()
+{
+  initialiseCpuLocalStorage(0, (size_t)boot_stack + sizeof(boot_stack));
+  num_cpus_ = 1;
+}
+
+void ArchMulticore::initialiseCpuLocalStorage(size_t cpu_id, size_t kernel_stack)
+{
+  assert(cpu_id < MAX_CPUS);
+  CpuLocalStorage* cls = &cpus_[cpu_id];
+  cls->self = cls;
+  cls->cpu_id = cpu_id;
+  cls->current_thread = 0;
+  cls->current_thread_registers = 0;
+
+  memset(&cls->tss, 0, sizeof(cls->tss));
+  cls->tss.rsp0 = kernel_stack;
+  cls->tss.iomap_base = sizeof(cls->tss); // no io permission bitmap
+
+  memcpy(cls->gdt, gdt, sizeof(cls->gdt));
+  SegmentDescriptor& tss_descriptor = cls->gdt[KERNEL_TSS / sizeof(SegmentDescriptor)];
+  pointer base = (pointer)&cls->tss;
+  tss_descriptor.baseLL = (uint16)(base & 0xFFFF);
+  tss_descriptor.baseLM = (uint8)((base >> 16) & 0xFF);
+  tss_descriptor.baseLH = (uint8)((base >> 24) & 0xFF);
+  tss_descriptor.baseH = (uint32)(base >> 32);
+  tss_descriptor.limitL = sizeof(cls->tss) - 1;
+  tss_descriptor.limitH = 0;
+  tss_descriptor.typeL = TSS_TYPE_AVAILABLE; // ltr marked the descriptor of the boot GDT as busy
+
+  GDTR gdtr;
+  gdtr.limit = sizeof(cls->gdt) - 1;
+  gdtr.base = (uint64)cls->gdt;
+  asm volatile("lgdt %[gdtr]\n"
+               "pushq %[cs]\n"
+               "leaq 1f(%%rip), %%rax\n"
+               "pushq %%rax\n"
+               "lretq\n"
+               "1:\n"
+               "mov %w[ds], %%ds\n"
+               "mov %w[ds], %%es\n"
+               "mov %w[ds], %%ss\n"
+               "ltr %w[tss]\n"
+               : : [gdtr]"m"(gdtr), [cs]"i"(KERNEL_CS), [ds]"r"(KERNEL_DS), [tss]"r"(KERNEL_TSS) : "rax", "memory");
+
+  // never load a selector into gs from now on, it would reset the base
+  wrmsr(IA32_GS_BASE_MSR, (uint64)cls);
+  wrmsr(IA32_KERNEL_GS_BASE_MSR, 0);
+}
+
+void ArchMulticore::startOtherCpus()
+{
+  if (!LocalAPIC::isEnabled())
+  {
+    debug(A_MULTICORE, "startOtherCpus: no local APIC, only using the boot cpu\n");
+    return;
+  }
+  cpus_[0].apic_id = LocalAPIC::id();
+
+  size_t trampoline_size = ap_trampoline_end - ap_trampoline_start;
+  assert(trampoline_size <= PAGE_SIZE);
+  char* trampoline = (char*)ArchMemory::getIdentAddress(AP_TRAMPOLINE_PHYSICAL);
+  memcpy(trampoline, ap_trampoline_start, trampoline_size);
+
+  ApTrampolineData* data = (ApTrampolineData*)(trampoline + (ap_trampoline_data - ap_trampoline_start));
+  data->cr3 = (uint64)VIRTUAL_TO_PHYSICAL_BOOT(ArchMemory::getRootOfKernelPagingStructure());
+  asm volatile("mov %%cr4, %0" : "=r"(data->cr4));
+  data->cr4 &= ~(1ULL << 17); // pcide can only be set in long mode
+  data->next_ticket = 0;
+  uint8* stacks[MAX_CPUS - 1];
+  for (size_t i = 0; i < MAX_CPUS - 1; ++i)
+  {
+    stacks[i] = new uint8[AP_STACK_SIZE];
+    data->stacks[i] = ((pointer)stacks[i] + AP_STACK_SIZE) & ~0xFULL;
+  }
+  asm volatile("sidt %0" : "=m"(ap_idtr));
+
+  // the trampoline keeps running at its physical address for a moment after enabling paging
+  kernel_page_map_level_4[0] = kernel_page_map_level_4[480];
+
+  LocalAPIC::startOtherCpus(AP_TRAMPOLINE_PHYSICAL / PAGE_SIZE);
+
+  // every cpu which drew a valid ticket checks in once it left the trampoline
+  size_t tickets = 0;
+  uint64 timeout = TimeStampCounter::nsSinceBoot() + AP_STARTUP_TIMEOUT_NS;
+  do
+  {
+    tickets = Min(__atomic_load_n(&data->next_ticket, __ATOMIC_SEQ_CST), MAX_CPUS - 1);
+  } while (__atomic_load_n(&num_cpus_, __ATOMIC_SEQ_CST) < tickets + 1 && TimeStampCounter::nsSinceBoot() < timeout);
+
+  memset(&kernel_page_map_level_4[0], 0, sizeof(kernel_page_map_level_4[0]));
+  // the kernel pages are global, reloading cr3 would keep them
+  ArchMemory::flushAllTranslations();
+
+  for (size_t i = tickets; i < MAX_CPUS - 1; ++i)
+    delete[] stacks[i];
+
+  if (data->next_ticket > MAX_CPUS - 1)
+    debug(A_MULTICORE, "startOtherCpus: %zu cpus found, only %zu are supported\n",
+          (size_t)data->next_ticket + 1, MAX_CPUS);
+  if (num_cpus_ != tickets + 1)
+    debug(A_MULTICORE, "startOtherCpus: only %zu of %zu cpus checked in\n", num_cpus_, tickets + 1);
+  for (size_t i = 0; i < num_cpus_; ++i)
+    debug(A_MULTICORE, "startOtherCpus: cpu %zu has local APIC id %u\n", i, cpus_[i].apic_id);
+}
+
+void ArchMulticore::initialiseApplicationProcessor(size_t cpu_id)
+{
+  size_t rsp;
+  asm volatile("mov %%rsp, %0" : "=r"(rsp));
+  initialiseCpuLocalStorage(cpu_id, rsp);
+  InterruptUtils::lidt(&ap_idtr);
+  LocalAPIC::initialiseApplicationProcessor();
+  cpus_[cpu_id].apic_id = LocalAPIC::id();
+  __atomic_add_fetch(&num_cpus_, 1, __ATOMIC_SEQ_CST);
+
+  // nothing in the kernel except the scheduler internals is ready for a second cpu yet,
+  // so this one just stays halted with interrupts disabled
+  while (true)
+    asm volatile("cli\n"
+                 "hlt\n");
+}
+
+size_t ArchMulticore::numCpus()
+{
+  return __atomic_load_n(&num_cpus_, __ATOMIC_SEQ_CST);
+}
+
+extern "C" void ap_entry(size_t cpu_id)
+{
+  ArchMulticore::initialiseApplicationProcessor(cpu_id);
+}
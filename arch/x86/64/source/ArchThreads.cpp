@@ -5,13 +5,26 @@
 #include "offsets.h"
 #include "assert.h"
 #include "Thread.h"
+#include "KmemCache.h"
 #include "kstring.h"
 
 extern PageMapLevel4Entry kernel_page_map_level_4[];
 
+static KmemCache arch_thread_registers_cache("ArchThreadRegisters", sizeof(ArchThreadRegisters));
+
+void* ArchThreadRegisters::operator new(size_t size)
+{
+  return arch_thread_registers_cache.allocate(size);
+}
+
+void ArchThreadRegisters::operator delete(void* address)
+{
+  arch_thread_registers_cache.free(address);
+}
+
 void ArchThreads::initialise()
 {
-  currentThreadRegisters = new ArchThreadRegisters{};
+  ArchMulticore::setCurrentThreadRegisters(new ArchThreadRegisters{});
 
   /** Enable SSE for floating point instructions in long mode **/
   asm volatile ("movq %%cr0, %%rax\n"
@@ -21,19 +34,18 @@ void ArchThreads::initialise()
           "movq %%cr4, %%rax\n"
           "orq $0x200, %%rax\n"
           "movq %%rax, %%cr4\n" : : : "rax");
+
+  ArchMemory::enableTlbTagging();
 }
 void ArchThreads::setAddressSpace(Thread *thread, ArchMemory& arch_memory)
 {
   assert(arch_memory.page_map_level_4_);
-  thread->kernel_registers_->cr3 = arch_memory.page_map_level_4_ * PAGE_SIZE;
+  thread->kernel_registers_->cr3 = arch_memory.getValueForCR3();
   if (thread->user_registers_)
-    thread->user_registers_->cr3 = arch_memory.page_map_level_4_ * PAGE_SIZE;
+    thread->user_registers_->cr3 = arch_memory.getValueForCR3();
 
   if(thread == currentThread)
-  {
-          asm volatile("movq %[new_cr3], %%cr3\n"
-                       ::[new_cr3]"r"(arch_memory.page_map_level_4_ * PAGE_SIZE));
-  }
+    ArchMemory::loadAddressSpace(arch_memory.getValueForCR3());
 }
 
 void ArchThreads::createBaseThreadRegisters(ArchThreadRegisters *&info, void* start_function, void* stack)
@@ -80,6 +92,13 @@ void ArchThreads::createUserRegisters(ArchThreadRegisters *&info, void* start_fu
   assert(info->cr3);
 }
 
+void ArchThreads::createForkedUserRegisters(ArchThreadRegisters *&info, ArchThreadRegisters* parent_info, void* kernel_stack)
+{
+  info = new ArchThreadRegisters(*parent_info);
+  info->rax     = 0;
+  info->rsp0    = (size_t)kernel_stack;
+}
+
 void ArchThreads::changeInstructionPointer(ArchThreadRegisters *info, void* function)
 {
   info->rip = (size_t)function;
@@ -157,9 +157,6 @@ extern SWEBDebugInfo const *kernel_debug_info;
 
 extern "C" void arch_contextSwitch();
 
-extern ArchThreadRegisters *currentThreadRegisters;
-extern Thread *currentThread;
-
 extern "C" void arch_irqHandler_0();
 extern "C" void irqHandler_0()
 {
@@ -189,10 +186,9 @@ extern "C" void pageFaultHandler(uint64 address, uint64 error)
                                    error & FLAG_PF_PRESENT,
                                    error & FLAG_PF_RDWR,
                                    error & FLAG_PF_INSTR_FETCH);
+  // the page fault handler invalidated the entries it changed, not present entries are never cached
   if (currentThread->switch_to_userspace_)
     arch_contextSwitch();
-  else
-    asm volatile ("movq %%cr3, %%rax; movq %%rax, %%cr3;" ::: "%rax");
 }
 
 extern "C" void arch_irqHandler_1();
@@ -270,7 +266,7 @@ extern "C" void arch_syscallHandler();
 extern "C" void syscallHandler()
 {
   currentThread->switch_to_userspace_ = 0;
-  currentThreadRegisters = currentThread->kernel_registers_;
+  ArchMulticore::setCurrentThreadRegisters(currentThread->kernel_registers_);
   ArchInterrupts::enableInterrupts();
 
   currentThread->user_registers_->rax =
@@ -283,7 +279,7 @@ extern "C" void syscallHandler()
 
   ArchInterrupts::disableInterrupts();
   currentThread->switch_to_userspace_ = 1;
-  currentThreadRegisters =  currentThread->user_registers_;
+  ArchMulticore::setCurrentThreadRegisters(currentThread->user_registers_);
   arch_contextSwitch();
 }
 
@@ -337,7 +333,7 @@ extern "C" void errorHandler(size_t num, size_t eip, size_t cs, size_t spurious)
   else
   {
     currentThread->switch_to_userspace_ = false;
-    currentThreadRegisters = currentThread->kernel_registers_;
+    ArchMulticore::setCurrentThreadRegisters(currentThread->kernel_registers_);
     ArchInterrupts::enableInterrupts();
     debug(CPU_ERROR, "Terminating process...\n");
     currentThread->kill();
@@ -0,0 +1,162 @@
+#include "LocalAPIC.h"
+#include "TimeStampCounter.h"
+#include "assert.h"
+#include "debug.h"
+
+#define IA32_APIC_BASE_MSR 0x1B
+#define IA32_APIC_BASE_ENABLE (1 << 11)
+#define IA32_APIC_BASE_ADDRESS_MASK 0xFFFFFF000ULL
+
+#define CPUID_FEATURE_EDX_APIC (1 << 9)
+
+#define APIC_ID 0x20
+#define APIC_TASK_PRIORITY 0x80
+#define APIC_EOI 0xB0
+#define APIC_SPURIOUS_VECTOR 0xF0
+#define APIC_SOFTWARE_ENABLE (1 << 8)
+#define APIC_ICR_LOW 0x300
+#define APIC_ICR_HIGH 0x310
+#define APIC_ICR_DELIVERY_PENDING (1 << 12)
+#define APIC_ICR_ALL_EXCLUDING_SELF (3 << 18)
+#define APIC_ICR_LEVEL_ASSERT (1 << 14)
+#define APIC_ICR_INIT (5 << 8)
+#define APIC_ICR_STARTUP (6 << 8)
+#define APIC_LVT_TIMER 0x320
+#define APIC_LVT_MASKED (1 << 16)
+#define APIC_TIMER_INITIAL_COUNT 0x380
+#define APIC_TIMER_CURRENT_COUNT 0x390
+#define APIC_TIMER_DIVIDE 0x3E0
+#define APIC_TIMER_DIVIDE_BY_16 0x3
+
+#define CALIBRATION_NS 10000000ULL
+#define INIT_DELAY_NS 10000000ULL
+#define STARTUP_DELAY_NS 200000ULL
+
+const uint32 LocalAPIC::TIMER_VECTOR;
+const uint32 LocalAPIC::SPURIOUS_VECTOR;
+
+bool LocalAPIC::enabled_ = false;
+uint64 LocalAPIC::timer_ticks_per_ms_ = 0;
+
+static inline uint64 rdmsr(uint32 msr)
+{
+  uint32 low, high;
+  asm volatile("rdmsr" : "=a"(low), "=d"(high) : "c"(msr));
+  return ((uint64)high << 32) | low;
+}
+
+static inline void wrmsr(uint32 msr, uint64 value)
+{
+  asm volatile("wrmsr" : : "c"(msr), "a"((uint32)value), "d"((uint32)(value >> 32)));
+}
+
+bool LocalAPIC::initialise()
+{
+  assert(TimeStampCounter::cyclesPerMs() && "the TSC has to be calibrated first");
+
+  uint32 eax = 1, ebx, ecx, edx;
+  asm volatile("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+  if (!(edx & CPUID_FEATURE_EDX_APIC))
+  {
+    debug(A_INTERRUPTS, "LocalAPIC::initialise: cpu has no local APIC\n");
+    return false;
+  }
+
+  uint64 apic_base = rdmsr(IA32_APIC_BASE_MSR);
+  if ((apic_base & IA32_APIC_BASE_ADDRESS_MASK) != LOCAL_APIC_PHYSICAL_BASE)
+  {
+    debug(A_INTERRUPTS, "LocalAPIC::initialise: local APIC has been relocated to %zx, not using it\n",
+          (size_t)(apic_base & IA32_APIC_BASE_ADDRESS_MASK));
+    return false;
+  }
+  wrmsr(IA32_APIC_BASE_MSR, apic_base | IA32_APIC_BASE_ENABLE);
+
+  writeRegister(APIC_TASK_PRIORITY, 0);
+  writeRegister(APIC_SPURIOUS_VECTOR, APIC_SOFTWARE_ENABLE | SPURIOUS_VECTOR);
+
+  // count down from the maximum for a while, the timer stays masked meanwhile
+  writeRegister(APIC_TIMER_DIVIDE, APIC_TIMER_DIVIDE_BY_16);
+  writeRegister(APIC_LVT_TIMER, APIC_LVT_MASKED | TIMER_VECTOR);
+  writeRegister(APIC_TIMER_INITIAL_COUNT, 0xFFFFFFFF);
+  TimeStampCounter::delayNs(CALIBRATION_NS);
+  uint32 elapsed = 0xFFFFFFFF - readRegister(APIC_TIMER_CURRENT_COUNT);
+  writeRegister(APIC_TIMER_INITIAL_COUNT, 0);
+
+  timer_ticks_per_ms_ = elapsed / (CALIBRATION_NS / 1000000ULL);
+  if (!timer_ticks_per_ms_)
+  {
+    debug(A_INTERRUPTS, "LocalAPIC::initialise: timer does not count, not using it\n");
+    return false;
+  }
+  debug(A_INTERRUPTS, "LocalAPIC::initialise: timer runs at %zu kHz\n", (size_t)timer_ticks_per_ms_);
+
+  writeRegister(APIC_LVT_TIMER, TIMER_VECTOR); // one-shot mode, unmasked
+  enabled_ = true;
+  return true;
+}
+
+bool LocalAPIC::isEnabled()
+{
+  return enabled_;
+}
+
+void LocalAPIC::setOneShotTimer(uint64 ns)
+{
+  assert(enabled_);
+  uint64 count = ns / 1000000ULL * timer_ticks_per_ms_ + (ns % 1000000ULL) * timer_ticks_per_ms_ / 1000000ULL;
+  if (ns && !count)
+    count = 1;
+  if (count > 0xFFFFFFFF)
+    count = 0xFFFFFFFF; // the handler just reprograms it once it fires too early
+  writeRegister(APIC_TIMER_INITIAL_COUNT, (uint32)count);
+}
+
+void LocalAPIC::sendEOI()
+{
+  writeRegister(APIC_EOI, 0);
+}
+
+uint32 LocalAPIC::id()
+{
+  return readRegister(APIC_ID) >> 24;
+}
+
+void LocalAPIC::initialiseApplicationProcessor()
+{
+  assert(enabled_ && "the boot cpu uses the local APIC, so does everyone else");
+  wrmsr(IA32_APIC_BASE_MSR, rdmsr(IA32_APIC_BASE_MSR) | IA32_APIC_BASE_ENABLE);
+  writeRegister(APIC_TASK_PRIORITY, 0);
+  writeRegister(APIC_SPURIOUS_VECTOR, APIC_SOFTWARE_ENABLE | SPURIOUS_VECTOR);
+  writeRegister(APIC_LVT_TIMER, APIC_LVT_MASKED | TIMER_VECTOR);
+}
+
+void LocalAPIC::startOtherCpus(uint8 vector_page)
+{
+  assert(enabled_);
+  sendIPI(APIC_ICR_ALL_EXCLUDING_SELF | APIC_ICR_LEVEL_ASSERT | APIC_ICR_INIT);
+  TimeStampCounter::delayNs(INIT_DELAY_NS);
+  // the second STARTUP IPI is ignored by the cpus which already started with the first one
+  for (size_t i = 0; i < 2; ++i)
+  {
+    sendIPI(APIC_ICR_ALL_EXCLUDING_SELF | APIC_ICR_LEVEL_ASSERT | APIC_ICR_STARTUP | vector_page);
+    TimeStampCounter::delayNs(STARTUP_DELAY_NS);
+  }
+}
+
+void LocalAPIC::sendIPI(uint32 command)
+{
+  writeRegister(APIC_ICR_HIGH, 0); // no destination needed, the shorthand selects the cpus
+  writeRegister(APIC_ICR_LOW, command);
+  while (readRegister(APIC_ICR_LOW) & APIC_ICR_DELIVERY_PENDING)
+    ;
+}
+
+uint32 LocalAPIC::readRegister(uint32 offset)
+{
+  return *(volatile uint32*)(LOCAL_APIC_VIRTUAL_BASE + offset);
+}
+
+void LocalAPIC::writeRegister(uint32 offset, uint32 value)
+{
+  *(volatile uint32*)(LOCAL_APIC_VIRTUAL_BASE + offset) = value;
+}
@@ -8,8 +8,6 @@
 #include "umap.h"
 #include "ArchCommon.h"
 
-extern Thread* currentThread;
-
 struct StackFrame
 {
    StackFrame *previous_frame;
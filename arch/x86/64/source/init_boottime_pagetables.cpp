@@ -4,6 +4,7 @@
 #include "multiboot.h"
 #include "ArchCommon.h"
 #include "kprintf.h"
+#include "LocalAPIC.h"
 
 extern void* kernel_end_address;
 
@@ -45,6 +46,7 @@ extern "C" void initialisePaging()
   // ident mapping 0x* 0000 C000 0000 <-> 0x0 --> pml4i = 0, pdpti = 3
   // ident mapping 0x* F000 0000 0000 <-> 0x0 --> pml4i = 480, pdpti = 0
   // ident mapping 0x* FFFF 8000 0000 <-> 0x0 --> pml4i = 511, pdpti = 510
+  // all kernel pages are global, pge is only enabled once the boot time ident mapping is gone
 
   pdpt1[0].pd.page_ppn = (uint64) pd1 / PAGE_SIZE;
   pdpt1[0].pd.writeable = 1;
@@ -60,6 +62,7 @@ extern "C" void initialisePaging()
     pd1[i].page.page_ppn = i;
     pd1[i].page.size = 1;
     pd1[i].page.writeable = 1;
+    pd1[i].page.global = 1;
     pd1[i].page.present = 1;
   }
   // Map 8 page directories (8*512*4kb = max 16mb)
@@ -80,15 +83,26 @@ extern "C" void initialisePaging()
   {
     pt[i].present = 1;
     pt[i].writeable = 0;
+    pt[i].global = 1;
     pt[i].page_ppn = i;
   }
   for (; i < kernel_last_page; ++i)
   {
     pt[i].present = 1;
     pt[i].writeable = 1;
+    pt[i].global = 1;
     pt[i].page_ppn = i;
   }
 
+  // map the local APIC registers (2 MiB page right below the framebuffer), uncached
+  pd2[503].page.present = 1;
+  pd2[503].page.writeable = 1;
+  pd2[503].page.size = 1;
+  pd2[503].page.cache_disabled = 1;
+  pd2[503].page.write_through = 1;
+  pd2[503].page.global = 1;
+  pd2[503].page.page_ppn = LOCAL_APIC_PHYSICAL_BASE / (PAGE_SIZE * PAGE_TABLE_ENTRIES);
+
   if (ArchCommon::haveVESAConsole(0))
   {
     for (i = 0; i < 8; ++i) // map the 16 MiB (8 pages) framebuffer
@@ -98,6 +112,7 @@ extern "C" void initialisePaging()
       pd2[504+i].page.size = 1;
       pd2[504+i].page.cache_disabled = 1;
       pd2[504+i].page.write_through = 1;
+      pd2[504+i].page.global = 1;
       pd2[504+i].page.page_ppn = (ArchCommon::getVESAConsoleLFBPtr(0) / (PAGE_SIZE * PAGE_TABLE_ENTRIES))+i;
     }
   }
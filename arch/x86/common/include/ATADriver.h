@@ -82,6 +82,13 @@ class ATADriver : public BDDriver
 
     int32 selectSector(uint32 start_sector, uint32 num_sectors);
 
+    /**
+     * sleeps until the IRQ handler is done with the request. Every IRQ_TIMEOUT_NS without an
+     * interrupt the controller status is polled, in case the interrupt got lost.
+     * Enables the interrupts, the caller has to restore its own state afterwards.
+     */
+    void waitForRequest(BDRequest* br);
+
     uint32 numsec;
 
     uint16 port;
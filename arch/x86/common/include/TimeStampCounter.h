@@ -0,0 +1,46 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * The time stamp counter of the cpu, used as the monotonic clock of the kernel.
+ * We assume an invariant TSC (constant rate, no stops in halt), which holds for all
+ * cpus of the last decade and for qemu/bochs.
+ */
+class TimeStampCounter
+{
+  public:
+    /**
+     * measures the TSC frequency against channel 2 of the PIT,
+     * has to be called once with interrupts disabled before the PIT is used for anything else
+     */
+    static void calibrate();
+
+    static inline uint64 read()
+    {
+      uint32 low, high;
+      asm volatile("rdtsc" : "=a"(low), "=d"(high));
+      return ((uint64)high << 32) | low;
+    }
+
+    /**
+     * @return nanoseconds since calibrate() was called, 0 before that
+     */
+    static uint64 nsSinceBoot();
+
+    /**
+     * converts a number of TSC cycles to nanoseconds without overflowing for large values
+     */
+    static uint64 cyclesToNs(uint64 cycles);
+
+    static uint64 cyclesPerMs();
+
+    /**
+     * busy waits for the given time, only meant for calibrating other timers
+     */
+    static void delayNs(uint64 ns);
+
+  private:
+    static uint64 cycles_per_ms_;
+    static uint64 boot_cycles_;
+};
@@ -3,6 +3,7 @@
 #include "BDManager.h"
 #include "BDRequest.h"
 #include "ArchInterrupts.h"
+#include "ArchCommon.h"
 #include "8259.h"
 
 #include "Scheduler.h"
@@ -20,6 +21,8 @@
                                          BODY;\
                                        }
 
+#define IRQ_TIMEOUT_NS 100000000ULL // 100 ms
+
 ATADriver::ATADriver( uint16 baseport, uint16 getdrive, uint16 irqnum ) : lock_("ATADriver::lock_")
 {
   debug(ATA_DRIVER, "ctor: Entered with irgnum %d and baseport %d!!\n", irqnum, baseport);
@@ -254,27 +257,39 @@ uint32 ATADriver::addRequest( BDRequest *br )
   }
 
   if (currentThread)
+    waitForRequest(br);
+
+  if (interrupt_context)
+    ArchInterrupts::enableInterrupts();
+  else
+    ArchInterrupts::disableInterrupts();
+  return 0;
+}
+
+void ATADriver::waitForRequest(BDRequest* br)
+{
+  // we need the interrupts to get notified about the completion
+  ArchInterrupts::enableInterrupts();
+  while (br->getStatus() == BDRequest::BD_QUEUED)
   {
-    if(interrupt_context)
-      ArchInterrupts::enableInterrupts();
-    jiffies = 0;
-    while (br->getStatus() == BDRequest::BD_QUEUED && jiffies++ < IO_TIMEOUT*10);
-    if (jiffies >= IO_TIMEOUT*10)
-      TIMEOUT_WARNING();
-    if (br->getStatus() == BDRequest::BD_QUEUED)
+    br->done_.prepareToWait();
+    // the IRQ might have been faster than us
+    if (br->getStatus() != BDRequest::BD_QUEUED)
     {
-      ArchInterrupts::disableInterrupts();
-      if (br->getStatus() == BDRequest::BD_QUEUED)
-      {
-        currentThread->setState(Sleeping);
-        ArchInterrupts::enableInterrupts();
-        Scheduler::instance()->yield(); // this is necessary! setting state to sleep and continuing to run is a BAD idea
-      }
-      ArchInterrupts::enableInterrupts();
+      br->done_.finishWait();
+      break;
     }
-  }
+    br->done_.sleepUntil(ArchCommon::getMonotonicTimeNs() + IRQ_TIMEOUT_NS);
 
-  return 0;
+    ArchInterrupts::disableInterrupts();
+    if (br->getStatus() == BDRequest::BD_QUEUED && request_list_ == br && !(inportbp(port + 7) & 0x80))
+    {
+      // the drive is not busy anymore, but we did not get an interrupt
+      TIMEOUT_WARNING();
+      serviceIRQ();
+    }
+    ArchInterrupts::enableInterrupts();
+  }
 }
 
 bool ATADriver::waitForController( bool resetIfFailed = true )
@@ -299,9 +314,8 @@ bool ATADriver::waitForController( bool resetIfFailed = true )
 
 void ATADriver::nextRequest(BDRequest* br)
 {
-  if(br->getThread())
-    br->getThread()->setState(Running);
   request_list_ = br->getNextRequest();
+  br->done_.wakeOne();
 }
 
 void ATADriver::serviceIRQ()
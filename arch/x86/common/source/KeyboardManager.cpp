@@ -97,7 +97,7 @@ void KeyboardManager::serviceIRQ(void)
 
   if (main_console)
   {
-    keyboard_buffer_.put(scancode); // put it inside the buffer
+    putScancode(scancode); // put it inside the buffer
   }
 
   send_cmd(0xAE); // enable the keyboard
@@ -0,0 +1,68 @@
+#include "TimeStampCounter.h"
+#include "ports.h"
+#include "assert.h"
+#include "debug.h"
+
+#define PIT_FREQUENCY 1193182
+#define PIT_CHANNEL2_DATA_PORT 0x42
+#define PIT_COMMAND_PORT 0x43
+#define PIT_CHANNEL2_GATE_PORT 0x61
+#define PIT_CHANNEL2_GATE 0x01
+#define PIT_SPEAKER_ENABLE 0x02
+#define PIT_CHANNEL2_OUT 0x20
+
+#define CALIBRATION_MS 10
+
+uint64 TimeStampCounter::cycles_per_ms_ = 0;
+uint64 TimeStampCounter::boot_cycles_ = 0;
+
+void TimeStampCounter::calibrate()
+{
+  // let channel 2 count down once in mode 0 (interrupt on terminal count), its output
+  // is readable at port 0x61 and the speaker stays silent
+  uint8 gate = inportb(PIT_CHANNEL2_GATE_PORT);
+  outportb(PIT_CHANNEL2_GATE_PORT, (gate & ~PIT_SPEAKER_ENABLE) | PIT_CHANNEL2_GATE);
+
+  uint16 count = PIT_FREQUENCY / 1000 * CALIBRATION_MS;
+  outportb(PIT_COMMAND_PORT, 0xB0); // channel 2, lobyte/hibyte, mode 0, binary
+  outportb(PIT_CHANNEL2_DATA_PORT, count & 0xFF);
+  outportb(PIT_CHANNEL2_DATA_PORT, count >> 8);
+
+  uint64 start = read();
+  while (!(inportb(PIT_CHANNEL2_GATE_PORT) & PIT_CHANNEL2_OUT))
+    ;
+  uint64 end = read();
+
+  outportb(PIT_CHANNEL2_GATE_PORT, gate);
+
+  cycles_per_ms_ = (end - start) / CALIBRATION_MS;
+  assert(cycles_per_ms_ && "TSC does not seem to count");
+  boot_cycles_ = end;
+  debug(A_INTERRUPTS, "TimeStampCounter::calibrate: %llu kHz\n", (unsigned long long)cycles_per_ms_);
+}
+
+uint64 TimeStampCounter::nsSinceBoot()
+{
+  if (!cycles_per_ms_)
+    return 0;
+  return cyclesToNs(read() - boot_cycles_);
+}
+
+uint64 TimeStampCounter::cyclesToNs(uint64 cycles)
+{
+  // split up, cycles * 1000000 would overflow after a few hours
+  return (cycles / cycles_per_ms_) * 1000000ULL + (cycles % cycles_per_ms_) * 1000000ULL / cycles_per_ms_;
+}
+
+uint64 TimeStampCounter::cyclesPerMs()
+{
+  return cycles_per_ms_;
+}
+
+void TimeStampCounter::delayNs(uint64 ns)
+{
+  assert(cycles_per_ms_);
+  uint64 end = read() + ns / 1000000ULL * cycles_per_ms_ + (ns % 1000000ULL) * cycles_per_ms_ / 1000000ULL;
+  while (read() < end)
+    ;
+}
@@ -5,8 +5,6 @@
 #include "Thread.h"
 #include "ArchInterrupts.h"
 
-extern Thread* currentThread;
-
 __attribute__((noreturn)) void pre_new_sweb_assert(const char* condition, uint32 line, const char* file)
 {
   system_state = KPANIC;
@@ -53,6 +53,7 @@ const size_t USERPROCESS        = Ansi_Cyan    | OUTPUT_ENABLED;
 const size_t PROCESS_REG        = Ansi_Yellow  | OUTPUT_ENABLED;
 const size_t BACKTRACE          = Ansi_Cyan    | OUTPUT_ENABLED;
 const size_t USERTRACE          = Ansi_Red     | OUTPUT_ENABLED;
+const size_t BENCHMARK          = Ansi_Green   | OUTPUT_ENABLED;
 
 //group memory management
 const size_t PM                 = Ansi_Green | OUTPUT_ENABLED;
@@ -73,6 +74,7 @@ const size_t A_MEMORY           = Ansi_Yellow;
 const size_t A_SERIALPORT       = Ansi_Yellow;
 const size_t A_KB_MANAGER       = Ansi_Yellow;
 const size_t A_INTERRUPTS       = Ansi_Yellow;
+const size_t A_MULTICORE        = Ansi_Yellow | OUTPUT_ENABLED;
 
 //group file system
 const size_t FS                 = Ansi_Yellow;
@@ -27,3 +27,9 @@ void kprintfd(const char *fmt, ...) __attribute__ ((format (printf, 1, 2)));
  */
 void kprintf_init();
 
+/**
+ * Wakes up the flushing thread if kprintf has put characters into the nosleep buffer since
+ * the last call. kprintf can not do that itself, it may run with the run queue lock held.
+ * Called by the scheduler without any of its locks held.
+ */
+void kprintf_wake_flush_thread();
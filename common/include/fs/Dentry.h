@@ -19,6 +19,7 @@ class Dentry
   protected:
     friend class MinixFSInode;
     friend class VfsSyscall;
+    friend class DentryCache;
     /**
      * The pointer to the inode related to this name.
      */
@@ -32,9 +33,41 @@ class Dentry
     Dentry *d_parent_;
 
     /**
-     * This list_head is used to link together all the children of the dentry.
+     * The children of the dentry in the order they were inserted, linked through
+     * d_next_sibling_ and d_prev_sibling_, so removing one does not have to search for it.
      */
-    ustl::list<Dentry*> d_child_;
+    Dentry *d_first_child_;
+    Dentry *d_last_child_;
+    uint32 d_num_children_;
+
+    /**
+     * The neighbours of this dentry in the child list of its parent.
+     */
+    Dentry *d_prev_sibling_;
+    Dentry *d_next_sibling_;
+
+    /**
+     * The children hashed by their names, so checkName does not have to compare
+     * the name of every child. The buckets are allocated with the first child and
+     * grow with the number of children.
+     */
+    Dentry **d_child_hash_;
+    size_t d_child_hash_size_;
+
+    /**
+     * The next dentry in the hash bucket of the parent.
+     */
+    Dentry *d_hash_next_;
+
+    /**
+     * The hash of d_name_, see hashName.
+     */
+    size_t d_name_hash_;
+
+    /**
+     * The number of DentryCache entries looked up in this dentry.
+     */
+    size_t d_cache_entries_;
 
     /**
      * For a directory that has had a file-system mounted on it, this points to
@@ -137,29 +170,70 @@ class Dentry
     const char* getName();
 
     /**
-     * This should compare the name with the all names of the d_child_ list.
+     * This should compare the name with the all names of the children.
      * It should return the Dentry if it exists the same name in the list,
      * @return the dentry found, 0 if doesn't exist.
      */
     virtual Dentry* checkName(const char* name);
 
     /**
-     * remove a child_dentry from the d_child_ list.
+     * remove a child_dentry from the children.
      * @param child_dentry the child dentry of the curent dentry.
      * @return 0 on success
      */
     virtual int32 childRemove(Dentry *child_dentry);
 
     /**
-     * insert a child dentry to the d_child_ list.
+     * insert a child dentry to the children.
      * @param child_dentry the child dentry of the current dentry.
      */
     virtual void childInsert(Dentry *child_dentry);
 
+    /**
+     * the hash of a name, checkName finds the children by it
+     * @param name the name, it does not have to be terminated
+     * @param length the length of the name
+     * @return the hash of the name
+     */
+    static size_t hashName(const char* name, size_t length);
+
   public:
     Dentry(const char* name);
-    Dentry(Dentry *parent);
+
+    /**
+     * creates a dentry and inserts it as child of parent, the name must not change
+     * afterwards because the parent finds its children by the hash of their names
+     * @param parent the parent dentry
+     * @param name the name of the new dentry
+     */
+    Dentry(Dentry *parent, const char* name);
     virtual ~Dentry();
+
+#ifndef EXE2MINIXFS
+    /**
+     * dentries are allocated from a KmemCache
+     */
+    static void* operator new(size_t size);
+    static void operator delete(void* address);
+#endif
+
     ustl::string d_name_;
+
+  private:
+    /**
+     * the bucket of the hash index which holds the children with the name hash
+     */
+    Dentry*& hashBucket(size_t name_hash);
+
+    /**
+     * adds a child to the hash index, the index grows if there are more children than buckets
+     */
+    void hashInsert(Dentry *child_dentry);
+
+    /**
+     * removes a child from the hash index
+     * @return false if the child is not in the index
+     */
+    bool hashRemove(Dentry *child_dentry);
 };
 
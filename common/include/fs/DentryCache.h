@@ -0,0 +1,106 @@
+#pragma once
+
+#include "types.h"
+#include "Mutex.h"
+#include "ustring.h"
+
+class Dentry;
+
+/**
+ * Results of the lookups of the PathWalker, keyed by the parent dentry and the name of the
+ * component. A found name maps to its dentry, a name which does not exist in the parent
+ * is cached as a negative entry, so looking it up again does not ask the file system.
+ *
+ * Once MAX_ENTRIES entries are cached, the least recently used one is evicted. Inserting or
+ * removing a child of a dentry drops the entry of its name, destroying a dentry drops all
+ * entries looked up in it.
+ */
+class DentryCache
+{
+  public:
+    static const size_t MAX_ENTRIES = 1024;
+    static const size_t NUM_BUCKETS = 256;
+
+    static DentryCache* instance();
+
+    DentryCache();
+
+    /**
+     * @param parent the dentry the name is looked up in
+     * @param name the name, it does not have to be terminated
+     * @param length the length of the name
+     * @param name_hash the hash of the name, see Dentry::hashName
+     * @param dentry set to the cached dentry, 0 for a negative entry
+     * @param generation set to the current generation on a miss, insert needs it
+     * @return true if the lookup is cached
+     */
+    bool lookup(Dentry* parent, const char* name, size_t length, size_t name_hash, Dentry*& dentry,
+                size_t& generation);
+
+    /**
+     * caches the result of a lookup which missed the cache. It is not cached if a child has
+     * been inserted or removed since, because the result might not be valid anymore.
+     * @param name the name, it is swapped into the entry
+     * @param dentry the dentry found, 0 if the name does not exist in the parent
+     * @param generation the generation lookup returned
+     */
+    void insert(Dentry* parent, ustl::string& name, size_t name_hash, Dentry* dentry, size_t generation);
+
+    /**
+     * drops the entry of the name, called whenever a child is inserted into or removed from parent
+     */
+    void invalidate(Dentry* parent, const char* name, size_t name_hash);
+
+    /**
+     * drops all entries looked up in the parent, called when it is destroyed
+     */
+    void dropParent(Dentry* parent);
+
+    size_t getHits() const;
+    size_t getMisses() const;
+
+    /**
+     * prints the number of cached entries and the hit statistics
+     */
+    void printStatistics();
+
+  private:
+    struct Entry
+    {
+      Entry* hash_next;
+      Entry* lru_prev;
+      Entry* lru_next;
+      Dentry* parent;
+      size_t name_hash;
+      Dentry* dentry;
+      ustl::string name;
+    };
+
+    static size_t bucketOf(Dentry* parent, size_t name_hash);
+
+    /**
+     * the entry of the name in the parent, 0 if there is none, the lock has to be held
+     */
+    Entry** find(Dentry* parent, const char* name, size_t length, size_t name_hash);
+
+    /**
+     * unlinks the entry from its bucket and the lru list and deletes it, the lock has to be held
+     * @param link the link to the entry in its bucket
+     */
+    void remove(Entry** link);
+
+    void lruUnlink(Entry* entry);
+    void lruPushFront(Entry* entry);
+
+    Entry* buckets_[NUM_BUCKETS];
+    Entry* lru_head_;
+    Entry* lru_tail_;
+    size_t num_entries_;
+    size_t generation_;
+    size_t hits_;
+    size_t negative_hits_;
+    size_t misses_;
+    Mutex lock_;
+
+    static DentryCache* instance_;
+};
@@ -123,6 +123,16 @@ class File
      */
     l_off_t lseek(l_off_t offset, uint8 origin);
 
+    /**
+     * reads from an absolute position in the file, the file position is neither used
+     * nor changed, so several threads can read from the same file at once
+     * @param buffer is the buffer where the data is written to
+     * @param count is the number of bytes to read.
+     * @param position is the position to read from counted from the start of the file.
+     * @returns the number of bytes read or -1 if the file is not readable.
+     */
+    int32 pread(char *buffer, size_t count, l_off_t position);
+
     /**
      * not implemented here
      * reads from the file
@@ -1,26 +1,41 @@
 #pragma once
 
 #include "types.h"
-#include "ulist.h"
 
 class File;
-class FileDescriptor;
-
-extern ustl::list<FileDescriptor*> global_fd;
 
 class FileDescriptor
 {
+  friend class FileDescriptorTable;
+
   protected:
     size_t fd_;
     File* file_;
 
+    /**
+     * the number of fd tables the descriptor is in, a fork shares it with the child
+     */
+    size_t users_;
+
   public:
     FileDescriptor ( File* file );
     virtual ~FileDescriptor() {}
+
+#ifndef EXE2MINIXFS
+    /**
+     * file descriptors are allocated from a KmemCache
+     */
+    static void* operator new(size_t size);
+    static void operator delete(void* address);
+#endif
+
     uint32 getFd() { return fd_; }
     File* getFile() { return file_; }
 
-    static void add(FileDescriptor* fd);
-    static void remove(FileDescriptor* fd);
+    /**
+     * adds the file descriptor to the fd table of the current process
+     * @return the fd it got
+     */
+    static uint32 add(FileDescriptor* fd);
 };
 
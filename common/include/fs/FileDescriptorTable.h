@@ -0,0 +1,83 @@
+#pragma once
+
+#include "types.h"
+#ifndef EXE2MINIXFS
+#include "Mutex.h"
+#endif
+
+class FileDescriptor;
+
+/**
+ * The open files of a process, indexed by their fd numbers. A new file gets the lowest
+ * free number, so the table stays as small as the highest fd in use.
+ *
+ * A forked process gets a copy of the table of its parent, both share the open files
+ * (see FileDescriptor::users_). A file is closed when the last table using it drops it.
+ */
+class FileDescriptorTable
+{
+  public:
+    /**
+     * 0, 1 and 2 are the terminal, the syscalls handle them before asking the table
+     */
+    static const uint32 FIRST_FD = 3;
+
+    FileDescriptorTable();
+
+    /**
+     * closes all files which are still open
+     */
+    ~FileDescriptorTable();
+
+    /**
+     * adds the file descriptors of the parent, the files are shared with it
+     * @param parent the table of the forking process
+     */
+    void copyFrom(FileDescriptorTable& parent);
+
+    /**
+     * @param file_descriptor the open file
+     * @return the lowest free fd, which now refers to the file
+     */
+    uint32 add(FileDescriptor* file_descriptor);
+
+    /**
+     * @return the open file with the fd, 0 if there is none
+     */
+    FileDescriptor* get(uint32 fd);
+
+    /**
+     * removes the file from the table without closing it
+     * @return the open file with the fd, 0 if there is none
+     */
+    FileDescriptor* remove(uint32 fd);
+
+    /**
+     * removes the file from the table and closes it if no other table uses it
+     * @return 0 on success, -1 if the fd is not open
+     */
+    int32 close(uint32 fd);
+
+    /**
+     * drops one user of the file, the last one closes it
+     */
+    static void release(FileDescriptor* file_descriptor);
+
+  private:
+    FileDescriptorTable(const FileDescriptorTable&);
+    FileDescriptorTable& operator=(const FileDescriptorTable&);
+
+    /**
+     * makes room for fds up to fd, the lock has to be held
+     */
+    void grow(uint32 fd);
+
+    FileDescriptor** fds_;
+    uint32 size_;
+    uint32 lowest_free_;
+    Mutex lock_;
+};
+
+// you use a different getFdTable() method depending on where your cpp is being compiled
+//   (it can come either from Thread.cpp or from exe2minixfs.cpp)
+FileDescriptorTable* getFdTable();
@@ -35,6 +35,8 @@ class Superblock;
 class Inode
 {
   protected:
+    friend class TextPageCache;
+
     Dentry *i_dentry_;
     ustl::list<Dentry*> i_dentry_link_;
 
@@ -65,6 +67,11 @@ class Inode
      */
     uint32 i_state_;
 
+    /**
+     * The number of pages of this inode in the TextPageCache.
+     */
+    size_t i_text_pages_;
+
   public:
 
     /**
@@ -73,14 +80,12 @@ class Inode
      * @param inode_type the inode type
      */
     Inode(Superblock *super_block, uint32 inode_type) :
-        i_dentry_(0), i_nlink_(0), i_size_(0), i_state_(I_UNUSED)
+        i_dentry_(0), i_nlink_(0), i_size_(0), i_state_(I_UNUSED), i_text_pages_(0)
     {
       superblock_ = super_block, i_type_ = inode_type;
     }
 
-    virtual ~Inode()
-    {
-    }
+    virtual ~Inode();
 
     /**
      * Create a directory with the given dentry.
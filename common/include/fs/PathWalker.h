@@ -97,10 +97,18 @@ class PathWalker
     /**
      * extract the first part of a path
      * @param path is a char* containing the path to get the next part from.
-     * @param npart_len will be set to the length of the next part
-     * @return length of the next part
+     * @return length of the next part, without the separator
      */
-    static int32 getNextPartLen(const char* path, int32& npart_len);
+    static size_t getNextPartLen(const char* path);
+
+    /**
+     * looks a part of a path up in the parent, the DentryCache remembers the result
+     * @param parent the dentry to look the name up in
+     * @param name the part of the path, it does not have to be terminated
+     * @param length the length of the name
+     * @return the found dentry, 0 if the name does not exist
+     */
+    static Dentry* lookup(Dentry* parent, const char* name, size_t length);
   private:
     PathWalker();
     ~PathWalker();
@@ -48,6 +48,14 @@ class MinixFSInode : public Inode
     MinixFSInode(Superblock *super_block, uint16 i_mode, uint32 i_size, uint16 i_nlinks, uint32* i_zones, uint32 i_num);
     virtual ~MinixFSInode();
 
+#ifndef EXE2MINIXFS
+    /**
+     * inodes are allocated from a KmemCache
+     */
+    static void* operator new(size_t size);
+    static void operator delete(void* address);
+#endif
+
     /**
      * lookup checks if that name (given by the char-array) exists in the
      * directory (I_DIR inode) and returns the Dentry if it does.
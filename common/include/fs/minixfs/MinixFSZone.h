@@ -15,6 +15,15 @@ class MinixFSZone
      */
     MinixFSZone(MinixFSSuperblock *superblock, uint32 *zones);
     ~MinixFSZone();
+
+#ifndef EXE2MINIXFS
+    /**
+     * zone lists are allocated from a KmemCache
+     */
+    static void* operator new(size_t size);
+    static void operator delete(void* address);
+#endif
+
     uint32 getZone(uint32 index);
     void setZone(uint32 index, uint32 zone);
     void addZone(uint32 zone);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "types.h"
+#include "ArchThreads.h"
+#include "ArchInterrupts.h"
+
+/**
+ * Busy waiting lock for the scheduler internals (run queues, timer wheel, wait queues).
+ * These run with interrupts disabled, so unlike SpinLock it can neither yield nor
+ * block and keeps no bookkeeping which could call back into the scheduler.
+ * Interrupts stay disabled while it is held, so an interrupt handler on the same cpu
+ * can never deadlock on it. The lock is not recursive.
+ *
+ *   bool interrupts_enabled = lock.acquire();
+ *   ...
+ *   lock.release(interrupts_enabled);
+ */
+class IrqSafeSpinLock
+{
+  public:
+    constexpr IrqSafeSpinLock() : lock_(0)
+    {
+    }
+
+    /**
+     * disables interrupts and spins until the lock is free
+     * @return whether interrupts were enabled before, has to be passed to release()
+     */
+    bool acquire()
+    {
+      bool interrupts_enabled = ArchInterrupts::disableInterrupts();
+      while (ArchThreads::testSetLock(lock_, 1))
+      {
+        // wait on the cached value instead of hammering the bus with locked writes
+        while (__atomic_load_n(&lock_, __ATOMIC_RELAXED))
+          ;
+      }
+      return interrupts_enabled;
+    }
+
+    /**
+     * @param interrupts_enabled the return value of the matching acquire()
+     */
+    void release(bool interrupts_enabled)
+    {
+      __atomic_store_n(&lock_, 0, __ATOMIC_RELEASE);
+      if (interrupts_enabled)
+        ArchInterrupts::enableInterrupts();
+    }
+
+    bool isHeld() const
+    {
+      return __atomic_load_n(&lock_, __ATOMIC_RELAXED) != 0;
+    }
+
+  private:
+    size_t lock_;
+
+    IrqSafeSpinLock(IrqSafeSpinLock const &);
+    IrqSafeSpinLock &operator=(IrqSafeSpinLock const&);
+};
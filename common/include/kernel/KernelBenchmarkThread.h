@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Thread.h"
+
+/**
+ * set to 1 to run the kernel benchmarks in a kernel thread after booting,
+ * results are printed with the BENCHMARK debug flag
+ */
+#define KERNEL_BENCHMARKS 0
+
+class KernelBenchmarkThread : public Thread
+{
+  public:
+    /**
+     * @param next thread added to the scheduler once the benchmarks are done, so it can not
+     * disturb them (e.g. the ProcessRegistry starting the user programs)
+     */
+    KernelBenchmarkThread(Thread* next);
+
+    virtual void Run();
+
+  private:
+    /**
+     * Spawns an increasing number of kernel threads which do nothing but yield,
+     * and measures the time a context switch takes.
+     */
+    void benchmarkScheduler();
+
+    /**
+     * Two kernel threads pass the turn back and forth via a Mutex and a Condition,
+     * every hand-off needs a wake up of the other thread and a transfer of the mutex.
+     */
+    void benchmarkMutexHandoff();
+
+    /**
+     * Keeps 10k objects of random sizes alive on the kernel heap and measures the throughput
+     * of freeing a random one and allocating a replacement.
+     */
+    void benchmarkKernelHeap();
+
+    /**
+     * Allocates and frees physical blocks of random orders in random order, checks that no
+     * block overlaps another one and that all pages are free again afterwards. The free page
+     * count only adds up if nobody else allocates meanwhile, no user process runs before it.
+     * A shorter check without the random pattern runs on every boot, see PageManager::selfCheck.
+     */
+    void stressPageManager();
+
+    Thread* next_;
+};
@@ -9,11 +9,49 @@
 #include <uvector.h>
 
 class Stabs2DebugInfo;
+class Inode;
+class File;
+
+/**
+ * How many pages of the binary a page fault loads: the pages of its segment around the
+ * faulting one, only the faulting one, or its whole segment at once, which suits small
+ * binaries. Keep in sync with LOAD_MODE_* in userspace nonstd.h
+ */
+enum LoadMode
+{
+  FaultAroundLoad, SinglePageLoad, PrefaultLoad
+};
 
 class Loader
 {
   public:
-    Loader(ssize_t fd);
+    /**
+     * the size of the aligned window of pages which is loaded around a faulting page
+     */
+    static const size_t FAULT_AROUND_PAGES = 8;
+
+    /**
+     * larger segments are not prefaulted at once but loaded around the faulting pages
+     */
+    static const size_t PREFAULT_MAX_PAGES = 256;
+
+    /**
+     * the number of consecutive pages of the binary which are mapped at once
+     */
+    static const size_t MAP_BATCH_PAGES = 32;
+
+    /**
+     * @param file the binary, it has to stay open as long as the loader exists
+     * @param load_mode how many pages of the binary a page fault loads
+     */
+    Loader(File* file, LoadMode load_mode = FaultAroundLoad);
+
+    /**
+     * creates the loader of a forked process, the pages of the parent are shared copy-on-write
+     * @param parent the loader of the forking process
+     * @param file the binary, opened again for the child
+     */
+    Loader(Loader& parent, File* file);
     ~Loader();
 
     /**
@@ -25,11 +63,20 @@ class Loader
     bool loadExecutableAndInitProcess();
 
     /**
-     * loads one page by its virtual address: gets a free page, copies the page, maps it
+     * loads the page of a virtual address: gets a free page, copies the page, maps it
+     * depending on the load mode, the unmapped pages of the same segment around it are loaded as well
      * @param virtual_address virtual address where to find the page to load
      */
     void loadPage(pointer virtual_address);
 
+    /**
+     * moves the end of the heap, which starts right after the highest segment of the binary
+     * heap pages are mapped on their first access, pages above the new end are unmapped
+     * @param new_break the new end of the heap, 0 only returns the current one
+     * @return the end of the heap afterwards, the unchanged one if new_break is invalid
+     */
+    pointer setBreak(pointer new_break);
+
     Stabs2DebugInfo const* getDebugInfos() const;
 
     void* getEntryFunction() const;
@@ -55,15 +102,91 @@ class Loader
     bool loadDebugInfoIfAvailable();
 
 
+    /**
+     * reads from the binary by position, without a file descriptor or a file position
+     * @return true if the length could not be read completely
+     */
     bool readFromBinary (char* buffer, l_off_t position, size_t length);
 
 
-    size_t fd_;
+    /**
+     * maps a zeroed page for an address inside the heap, heap_lock_ has to be held
+     * @param virt_page_start_addr the page aligned address
+     */
+    void loadHeapPage(pointer virt_page_start_addr);
+
+
+    /**
+     * maps the huge page around an address if the heap covers all of it, heap_lock_ has to be held
+     * @return false if it does not fit into the heap or cannot be mapped, see ArchMemory::mapHugePage
+     */
+    bool loadHeapHugePage(pointer virt_page_start_addr);
+
+
+    /**
+     * loads the faulting page and the unmapped pages of its window and maps them, in batches
+     * of up to MAP_BATCH_PAGES consecutive pages
+     * @param virt_page_start_addr the page aligned address of the faulting page
+     * @return the number of pages loaded around the faulting one
+     */
+    size_t loadBinaryPages(pointer virt_page_start_addr, pointer window_start, pointer window_end);
+
+
+    /**
+     * @param virt_page_start_addr the page aligned address
+     * @param read_only the page is shared with other processes running the binary
+     * @return a frame with the content of the page, the caller is one of its users
+     */
+    size_t getBinaryPage(pointer virt_page_start_addr, bool read_only);
+
+
+    /**
+     * maps consecutive pages of the binary, frames of pages which have been mapped meanwhile are freed
+     */
+    void mapBinaryPages(pointer first_page, size_t num_pages, const size_t* ppns, bool read_only);
+
+
+    /**
+     * @param virt_page_start_addr the page aligned address of a faulting page
+     * @param window_start first page which is loaded along with it
+     * @param window_end end of the pages which are loaded along with it, the window
+     * contains the faulting page
+     */
+    void getLoadWindow(pointer virt_page_start_addr, pointer& window_start, pointer& window_end);
+
+
+    /**
+     * reads a page from the binary into a new frame, exits the process if that fails
+     * @param virt_page_start_addr the page aligned address
+     * @return the frame
+     */
+    size_t readPage(pointer virt_page_start_addr);
+
+
+    /**
+     * @param virt_page_start_addr the page aligned address
+     * @return true if no writable segment covers the page, so it can be shared between processes
+     */
+    bool isReadOnlyPage(pointer virt_page_start_addr);
+
+
+    /**
+     * the binary is read by position, so page faults of several threads can read it at once
+     */
+    File* file_;
+    Inode* inode_;
+    LoadMode load_mode_;
     Elf::Ehdr *hdr_;
     ustl::list<Elf::Phdr> phdrs_;
-    Mutex program_binary_lock_;
+
+    pointer heap_start_;
+    pointer heap_break_;
+    Mutex heap_lock_;
 
     Stabs2DebugInfo *userspace_debug_info_;
 
+    size_t num_page_faults_;
+    size_t num_pages_loaded_around_;
+
 };
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "types.h"
+#include "WaitQueue.h"
 
 class Thread;
 
@@ -76,14 +77,9 @@ protected:
    */
   pointer last_accessed_at_;
 
-  /**
-   * Remove the current thread from the holding list.
-   */
-  void removeCurrentThreadFromWaitersList();
-
   inline bool threadsAreOnWaitersList() const
   {
-    return waiters_list_;
+    return !waiters_.isEmpty();
   }
 
   /**
@@ -126,49 +122,17 @@ protected:
    */
   void checkInvalidRelease(const char* method);
 
-  /**
-   * Lock the waiters list, so it may be modified.
-   * The lock may not be held in case the list is read out in some special cases.
-   */
-  void lockWaitersList();
-
-  /**
-   * unlock the waiters list.
-   */
-  void unlockWaitersList();
-
-  /**
-   * Check if the waiters list is locked at the moment.
-   * Only use this method for assertions, it is not ensured that the lock is held by the current thread.
-   * @return true in case the lock is held by a thread at the moment
-   * @return false in case the lock is not held by a thread at the moment
-   */
-  inline bool waitersListIsLocked() const
-  {
-    return waiters_list_lock_;
-  }
-
-  /**
-   * Pop the longest waiting thread from the waiters list.
-   * @return The thread in case one is waiting
-   * @return 0 in case no thread is waiting for this lock.
-   */
-  Thread* popBackThreadFromWaitersList();
-
-  /**
-   * Add the current thread to the waiters list of this lock.
-   */
-  void pushFrontCurrentThreadToWaitersList();
-
   /**
    * Print the lock status.
    */
   void printStatus();
 
   /**
-   * Release the lock, and set the thread to sleeping.
+   * The threads waiting on this lock, longest waiting thread first.
+   * The list can be read out while the lock is not held (for checks and prints).
+   * In case of a spinlock the threads in there are busy-waiters, else usually sleepers.
    */
-  void sleepAndRelease();
+  WaitQueue waiters_;
 
 private:
 
@@ -178,20 +142,6 @@ private:
    */
   const char* name_;
 
-  /**
-   * The single chained list of threads waiting on this lock.
-   * The list can be read out while the lock is not held (for checks and prints).
-   * To be able to read out without locking, all modifying accesses have to be atomic!
-   * If not, the list may become invalid while someone is reading out of it!
-   */
-  Thread* waiters_list_;
-
-  /**
-   * The lock for the waiters list. The list has to be locked for writing access,
-   * but may be used for unlocked access in case no element is going to be removed meanwhile.
-   */
-  size_t waiters_list_lock_;
-
   /**
    * Check if a deadlock would happen in combination with other locks.
    * @param thread_waiting The thread which wants to wait on the lock
@@ -3,6 +3,7 @@
 #include "Thread.h"
 #include "Mutex.h"
 #include "Condition.h"
+#include "Loader.h"
 
 class ProcessRegistry : public Thread
 {
@@ -36,7 +37,7 @@ class ProcessRegistry : public Thread
     size_t processCount();
 
     static ProcessRegistry* instance();
-    void createProcess(const char* path);
+    void createProcess(const char* path, LoadMode load_mode = FaultAroundLoad);
 
   private:
 
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "types.h"
+
+class Thread;
+
+/**
+ * Multi-level queue of runnable threads.
+ * Every level is an intrusive FIFO (linked via Thread::next_in_run_queue_ / prev_in_run_queue_),
+ * a bitmask keeps track of the non-empty levels. Level 0 is served first.
+ * All operations are O(1) and never allocate memory, so they can be used from within the
+ * scheduler with interrupts disabled.
+ * The RunQueue does no locking on its own, the caller has to ensure that interrupts are disabled.
+ */
+class RunQueue
+{
+  public:
+    static const size_t NUM_LEVELS = 32;
+    static const size_t NOT_QUEUED = -1;
+
+    RunQueue();
+
+    /**
+     * appends the thread at the tail of the given level
+     * @param thread the thread to enqueue, must not be queued already
+     * @param level the queue level, 0 has the highest precedence
+     */
+    void enqueue(Thread* thread, size_t level);
+
+    /**
+     * removes the thread from whichever level it is queued on
+     * @param thread the thread to remove, must be queued
+     */
+    void remove(Thread* thread);
+
+    /**
+     * removes and returns the first thread of the given level
+     * @param level the queue level, has to be non-empty
+     * @return the thread
+     */
+    Thread* dequeue(size_t level);
+
+    /**
+     * @return bitmask of the levels holding at least one thread, bit n stands for level n
+     */
+    uint32 nonEmptyLevels() const;
+
+    bool isQueued(Thread* thread) const;
+
+    size_t size() const;
+
+  private:
+    Thread* heads_[NUM_LEVELS];
+    Thread* tails_[NUM_LEVELS];
+    uint32 non_empty_levels_;
+    size_t size_;
+
+    RunQueue(RunQueue const &);
+    RunQueue &operator=(RunQueue const&);
+};
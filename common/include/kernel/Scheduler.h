@@ -4,6 +4,10 @@
 #include <ulist.h>
 #include "IdleThread.h"
 #include "CleanupThread.h"
+#include "RunQueue.h"
+#include "WaitQueue.h"
+#include "TimerWheel.h"
+#include "IrqSafeSpinLock.h"
 
 class Thread;
 class Mutex;
@@ -13,11 +17,60 @@ class Lock;
 class Scheduler
 {
   public:
+    /**
+     * number of priorities within each scheduling class, 0 is the most important one
+     */
+    static const size_t PRIORITY_LEVELS = 8;
+    static const size_t DEFAULT_PRIORITY = PRIORITY_LEVELS / 2;
+
+    /**
+     * time a thread may run before it gets preempted if the timer is in one-shot mode
+     */
+    static const uint64 TIME_SLICE_NS = 10000000ULL;
+
     static Scheduler *instance();
 
     void addNewThread(Thread *thread);
+
+    /**
+     * Hands a thread which has been killed in its constructor over to the CleanupThread,
+     * it is never scheduled.
+     */
+    void addDeadThread(Thread *thread);
     void sleep();
-    void wake(Thread *thread_to_wake);
+
+    /**
+     * Lets the current thread sleep until the given point in time, it does not occupy
+     * the run queue meanwhile.
+     * @param wakeup_ns monotonic time (see ArchCommon::getMonotonicTimeNs) to wake up at
+     */
+    void sleepUntil(uint64 wakeup_ns);
+
+    /**
+     * Gives up the cpu like sleepUntil, for a thread which has already been set to Sleeping
+     * (see WaitQueue::sleepUntil) and may also be woken up by someone else before.
+     * Has to be called with interrupts disabled, they are enabled before yielding.
+     * @param wakeup_ns monotonic time to wake up at at the latest
+     */
+    void yieldUntil(uint64 wakeup_ns);
+
+    /**
+     * Puts a thread which just became Running back into the run queue.
+     * Called by Thread::setState, safe to call from an interrupt handler.
+     * @param thread the thread to enqueue, nothing happens if it is already queued
+     */
+    void makeRunnable(Thread *thread);
+
+    /**
+     * Changes scheduling class and priority of a thread.
+     * Realtime threads are scheduled strictly by priority and run before everything else,
+     * normal threads share the cpu weighted by their priority, idle threads only run if
+     * no realtime or normal thread is runnable.
+     * @param thread the thread to change
+     * @param sched_class the new scheduling class
+     * @param priority the new priority within the class, has to be below PRIORITY_LEVELS
+     */
+    void setScheduling(Thread *thread, SchedulingClass sched_class, size_t priority);
     void yield();
     void printThreadList();
     void printStackTraces();
@@ -27,11 +80,19 @@ class Scheduler
     void incTicks();
     uint32 getTicks();
 
+    /**
+     * Switches the timer to one-shot mode if the platform supports it. Afterwards the timer
+     * only fires when the time slice of a thread ends, there is no timer interrupt at all
+     * while the idle thread runs.
+     * Has to be called with interrupts disabled, after the timer has been enabled.
+     */
+    void enableTickless();
+
     /**
      * NEVER EVER EVER CALL THIS METHOD OUTSIDE OF AN INTERRUPT CONTEXT
      * this is the method that decides which threads will be scheduled next
      * it is called by either the timer interrupt handler or the yield interrupt handler
-     * and changes the global variables currentThread and currentThreadRegisters
+     * and changes the cpu local variables currentThread and currentThreadRegisters
      * @return 1 if the InterruptHandler should switch to Usercontext or 0 if we can stay in Kernelcontext
      */
     uint32 schedule();
@@ -39,9 +100,20 @@ class Scheduler
   protected:
     friend class IdleThread;
     friend class CleanupThread;
+    friend class Thread;
 
     void cleanupDeadThreads();
 
+    /**
+     * Lets the CleanupThread sleep until a thread has been set to ToBeDestroyed.
+     */
+    void waitForDeadThreads();
+
+    /**
+     * Called by Thread::setState once a thread is ToBeDestroyed, safe to call with interrupts disabled.
+     */
+    void wakeCleanupThread();
+
   private:
     Scheduler();
 
@@ -58,15 +130,74 @@ class Scheduler
      */
     void unlockScheduling();
 
+    /**
+     * @return the run queue level the thread is enqueued on
+     */
+    size_t runQueueLevel(Thread *thread);
+
+    /**
+     * Removes the next thread to run from the run queue. Realtime and idle levels are served
+     * strictly in order, the normal levels in a weighted round robin based on normal_credits_
+     * so low priority threads do not starve.
+     * Has to be called with run_queue_lock_ held.
+     * @return the thread or 0 if the run queue is empty
+     */
+    Thread* dequeueNextThread();
+
+    /**
+     * arms the one-shot timer for the end of the time slice of currentThread
+     * or the next sleeper to wake up, whichever comes first
+     */
+    void programTimer(uint64 now_ns);
+
     static Scheduler *instance_;
 
     typedef ustl::list<Thread*> ThreadList;
     ThreadList threads_;
 
+    /**
+     * Threads ready to run. The thread currently running is not part of it, it gets
+     * requeued on the next call of schedule(). Threads which went to sleep while being
+     * enqueued are dropped lazily once they reach the head of the queue.
+     * Only the boot cpu schedules, the application processors stay parked
+     * (see ArchMulticore::startOtherCpus) until the rest of the kernel is SMP safe.
+     */
+    RunQueue run_queue_;
+    IrqSafeSpinLock run_queue_lock_;
+
+    /**
+     * picks left per normal priority in the current round of the weighted round robin
+     */
+    size_t normal_credits_[PRIORITY_LEVELS];
+
+    /**
+     * monotonic time of the last thread switch, for the cpu time accounting
+     */
+    uint64 last_schedule_ns_;
+
+    /**
+     * Threads sleeping via sleepUntil, advanced on every call of schedule().
+     * Protected by timer_wheel_lock_, which may be taken before run_queue_lock_ but not after it.
+     */
+    TimerWheel timer_wheel_;
+    IrqSafeSpinLock timer_wheel_lock_;
+
     size_t block_scheduling_;
 
     size_t ticks_;
 
+    /**
+     * true if the timer interrupt is a one-shot timer programmed by schedule()
+     */
+    bool tickless_;
+
+    /**
+     * the CleanupThread waits here, dead_threads_pending_ remembers wake ups which
+     * happened while it was busy cleaning up
+     */
+    WaitQueue dead_threads_;
+    volatile bool dead_threads_pending_;
+
     IdleThread idle_thread_;
     CleanupThread cleanup_thread_;
 };
@@ -6,6 +6,21 @@
 #include "Scheduler.h"
 #include "kprintf.h"
 
+/**
+ * clocks of clock_gettime, keep in sync with CLOCK_* in userspace time.h
+ */
+#define CLOCK_MONOTONIC 1
+#define CLOCK_THREAD_CPUTIME_ID 3
+
+/**
+ * layout of struct timespec in userspace
+ */
+struct UserTimespec
+{
+  long tv_sec;
+  long tv_nsec;
+};
+
 class Syscall
 {
   public:
@@ -18,8 +33,14 @@ class Syscall
   static size_t read(size_t fd, pointer buffer, size_t count);
   static size_t close(size_t fd);
   static size_t open(size_t path, size_t flags);
+  static size_t unlink(size_t path);
 
-  static size_t createprocess(size_t path, size_t sleep);
+  static size_t createprocess(size_t path, size_t sleep, size_t load_mode);
+  static size_t fork();
+  static size_t sched_setclass(size_t sched_class, size_t priority);
+  static size_t nanosleep(size_t request, size_t remaining);
+  static size_t clock_gettime(size_t clock_id, size_t time);
+  static size_t brk(size_t end_data_segment);
   static void trace();
 };
 
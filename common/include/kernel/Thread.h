@@ -2,6 +2,8 @@
 
 #include "types.h"
 #include "fs/FileSystemInfo.h"
+#include "fs/FileDescriptorTable.h"
+#include "ArchMulticore.h"
 
 #define STACK_CANARY ((uint32)0xDEADDEAD ^ (uint32)(size_t)this)
 
@@ -10,6 +12,15 @@ enum ThreadState
   Running, Sleeping, ToBeDestroyed
 };
 
+/**
+ * Realtime threads always run before normal ones, idle threads only run if
+ * there is nothing else to do. Keep in sync with SCHED_CLASS_* in userspace nonstd.h
+ */
+enum SchedulingClass
+{
+  RealtimeClass, NormalClass, IdleClass
+};
+
 enum SystemState { BOOTING, RUNNING, KPANIC };
 extern SystemState system_state;
 
@@ -21,14 +32,16 @@ class Mutex;
 class FsWorkingDirectory;
 class Lock;
 
-extern Thread* currentThread;
-
 class Thread
 {
     friend class Scheduler;
+    friend class RunQueue;
+    friend class WaitQueue;
+    friend class TimerWheel;
   public:
 
     static const char* threadStatePrintable[3];
+    static const char* schedulingClassPrintable[3];
 
     enum TYPE { KERNEL_THREAD, USER_THREAD };
 
@@ -42,6 +55,13 @@ class Thread
 
     virtual ~Thread();
 
+    /**
+     * Threads are allocated from a KmemCache, subclasses which do not fit
+     * into its objects fall back to the kernel heap
+     */
+    static void* operator new(size_t size);
+    static void operator delete(void* address, size_t size);
+
     /**
      * Marks the thread to be deleted by the scheduler.
      * DO Not use new / delete in this Method, as it sometimes called from an Interrupt Handler with Interrupts disabled
@@ -78,6 +98,12 @@ class Thread
      */
     void setWorkingDirInfo(FileSystemInfo* working_dir);
 
+    /**
+     * the files opened by this Thread
+     * @return the thread's fd table
+     */
+    FileDescriptorTable* getFdTable();
+
     /**
      * prints a backtrace (i.e. the call stack) to the
      * debug output.
@@ -104,12 +130,24 @@ class Thread
 
     void setState(ThreadState state);
 
+    SchedulingClass getSchedulingClass() const;
+
+    /**
+     * @return the priority within the scheduling class, 0 is the most important one
+     */
+    size_t getPriority() const;
+
     /**
-     * A part of the single-chained waiters list for the locks.
-     * It references to the next element of the list.
+     * @return nanoseconds this thread has been running, updated on every call of Scheduler::schedule
+     */
+    uint64 getCpuTimeNs() const;
+
+    /**
+     * A part of the single-chained list of the WaitQueue the thread is waiting in
+     * (e.g. the waiters list of a lock). It references to the next element of the list.
      * In case of a spinlock it is a busy-waiter, else usually it is a sleeper ^^.
      */
-    Thread* next_thread_in_lock_waiters_list_;
+    Thread* next_thread_in_wait_queue_;
 
     /**
      * The information which lock the thread is currently waiting on.
@@ -125,6 +163,33 @@ class Thread
     Lock* holding_lock_list_;
 
   private:
+    /**
+     * Links of the intrusive run queue the thread is enqueued in, and its level there.
+     * Only the RunQueue touches these, run_queue_level_ is RunQueue::NOT_QUEUED while
+     * the thread is not in any run queue.
+     */
+    Thread* next_in_run_queue_;
+    Thread* prev_in_run_queue_;
+    size_t run_queue_level_;
+
+    /**
+     * Only changed by Scheduler::setScheduling, as the thread might need to be moved within the run queue
+     */
+    SchedulingClass scheduling_class_;
+    size_t priority_;
+
+    /**
+     * Links of the timer wheel slot the thread sleeps in, only touched by the TimerWheel.
+     * timer_wheel_slot_ is TimerWheel::NOT_QUEUED while the thread is not in the wheel,
+     * timer_wheel_expiry_ is the wheel tick the thread has to be woken up at.
+     */
+    Thread* next_in_timer_wheel_;
+    Thread* prev_in_timer_wheel_;
+    size_t timer_wheel_slot_;
+    uint64 timer_wheel_expiry_;
+
+    uint64 cpu_time_ns_;
+
     Thread(Thread const &src);
     Thread &operator=(Thread const &src);
 
@@ -139,6 +204,8 @@ class Thread
 
     FileSystemInfo* working_dir_;
 
+    FileDescriptorTable fd_table_;
+
     ustl::string name_;
 
 };
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "types.h"
+
+class Thread;
+
+/**
+ * Hierarchical timer wheel holding the threads which sleep until a point in time.
+ * Time is counted in wheel ticks of 2^RESOLUTION_SHIFT ns. Level 0 has one slot per
+ * tick, every further level covers SLOTS times the range of the one below. A thread is
+ * put into the lowest level its expiry fits in, whenever a lower level wraps around the
+ * next slot of the level above is cascaded down. Adding, removing and expiring a thread
+ * are O(1), a bitmask per level lets advanceTo() jump from one non-empty slot to the next.
+ * Threads are linked via Thread::next_in_timer_wheel_ / prev_in_timer_wheel_, so nothing
+ * is allocated and the wheel can be used from the scheduler.
+ * The TimerWheel does no locking on its own, the caller has to ensure that interrupts are disabled.
+ */
+class TimerWheel
+{
+  public:
+    static const size_t RESOLUTION_SHIFT = 17; // ~131 us per tick
+    static const size_t SLOT_BITS = 6;
+    static const size_t SLOTS = 1 << SLOT_BITS;
+    static const size_t LEVELS = 5; // 2^(17 + 5 * 6) ns, about 39 hours, later expiries get cascaded again
+    static const size_t NOT_QUEUED = -1;
+
+    TimerWheel();
+
+    static uint64 nsToTicks(uint64 ns)
+    {
+      return ns >> RESOLUTION_SHIFT;
+    }
+
+    static uint64 ticksToNs(uint64 ticks)
+    {
+      return ticks << RESOLUTION_SHIFT;
+    }
+
+    /**
+     * @param thread the thread to add, must not be in the wheel already
+     * @param expiry_ns monotonic time the thread should be woken up at, is rounded up to the next tick
+     */
+    void add(Thread* thread, uint64 expiry_ns);
+
+    /**
+     * removes the thread from the wheel, nothing happens if it is not in the wheel
+     */
+    void remove(Thread* thread);
+
+    /**
+     * Advances the wheel to the given time and wakes up every thread which expired until then.
+     * @param now_ns current monotonic time
+     * @return the number of threads woken up
+     */
+    size_t advanceTo(uint64 now_ns);
+
+    /**
+     * @return a time at which advanceTo() has to be called next, no thread expires before it.
+     * This is a lower bound, it might only be the point at which the next slot gets cascaded.
+     * -1 if the wheel is empty.
+     */
+    uint64 nextEventNs() const;
+
+    bool isQueued(Thread* thread) const;
+
+    size_t size() const;
+
+  private:
+    void insert(Thread* thread);
+    void cascade(size_t level);
+    size_t expire(size_t slot);
+
+    /**
+     * @return distance from the slot index `from` to the next non-empty slot of the mask, wrapping around, SLOTS if the mask is empty
+     */
+    static size_t distanceToNextSlot(uint64 mask, size_t from);
+
+    /**
+     * @return the next tick at which a slot of any level has to be expired or cascaded, -1 if the wheel is empty
+     */
+    uint64 nextEventTick() const;
+
+    Thread* slots_[LEVELS][SLOTS];
+    uint64 non_empty_slots_[LEVELS];
+
+    /**
+     * the tick advanceTo() processes next
+     */
+    uint64 current_tick_;
+    size_t size_;
+
+    TimerWheel(TimerWheel const &);
+    TimerWheel &operator=(TimerWheel const&);
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Thread.h"
+#include "Loader.h"
 
 class UserProcess : public Thread
 {
@@ -10,15 +11,30 @@ class UserProcess : public Thread
      * @param minixfs_filename filename of the file in minixfs to execute
      * @param fs_info filesysteminfo-object to be used
      * @param terminal_number the terminal to run in (default 0)
+     * @param load_mode how many pages of the binary a page fault loads
      *
      */
-    UserProcess(ustl::string minixfs_filename, FileSystemInfo *fs_info, uint32 terminal_number = 0);
+    UserProcess(ustl::string minixfs_filename, FileSystemInfo *fs_info, uint32 terminal_number = 0,
+                LoadMode load_mode = FaultAroundLoad);
+
+    /**
+     * Constructor for fork(), the new process continues where the parent entered the syscall
+     * @param parent the forking process, has to be the current thread
+     */
+    UserProcess(UserProcess& parent);
 
     virtual ~UserProcess();
 
     virtual void Run(); // not used
 
   private:
-    int32 fd_;
+    /**
+     * opens the binary and takes it out of the fd table of the creating thread, so the
+     * program cannot close it while the loader still reads from it
+     * @return the open binary, 0 if it could not be opened
+     */
+    static FileDescriptor* openBinary(const char* path);
+
+    FileDescriptor* binary_;
 };
 
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "types.h"
+#include "IrqSafeSpinLock.h"
+
+class Thread;
+
+/**
+ * A FIFO of threads waiting for some event.
+ * Waiting is split into two steps, so a wake up happening in between can not get lost:
+ *
+ *   queue.prepareToWait();      // enqueue, mark as Sleeping, disable interrupts
+ *   if (condition_already_met)
+ *     queue.finishWait();       // changed our mind, dequeue and keep running
+ *   else
+ *     queue.sleep();            // actually give up the cpu
+ *
+ * Between prepareToWait() and sleep()/finishWait() interrupts are disabled, so the
+ * code in between must neither block nor yield. A waker just calls wakeOne()/wakeAll(),
+ * which never has to wait for the sleeper to go to sleep and can also be used from
+ * interrupt handlers.
+ *
+ * The queue links the threads via Thread::next_thread_in_wait_queue_, a thread can only
+ * wait in one queue at a time. The list and the state changes of the threads in it are
+ * protected by an IrqSafeSpinLock. Only the boot cpu schedules so far, waking up a
+ * thread which is about to sleep on another cpu is not handled.
+ */
+class WaitQueue
+{
+  public:
+    WaitQueue();
+
+    /**
+     * Sets the current thread to Sleeping and appends it to the queue, both under the lock.
+     * Has to be called with interrupts enabled, they stay disabled until
+     * sleep() or finishWait() is called.
+     */
+    void prepareToWait();
+
+    /**
+     * Gives up the cpu after prepareToWait(), returns once the thread has been woken up.
+     */
+    void sleep();
+
+    /**
+     * Like sleep(), but gives up waiting at the given point in time. The caller has to check
+     * its condition again afterwards to find out whether it has been woken up.
+     * @param wakeup_ns monotonic time (see ArchCommon::getMonotonicTimeNs) to wake up at at the latest
+     */
+    void sleepUntil(uint64 wakeup_ns);
+
+    /**
+     * Undoes prepareToWait() in case the awaited condition has been met in between.
+     */
+    void finishWait();
+
+    /**
+     * Wakes up the longest waiting thread.
+     * @return the thread woken up or 0 if the queue was empty
+     */
+    Thread* wakeOne();
+
+    /**
+     * Wakes up all waiting threads.
+     * @return the number of threads woken up
+     */
+    size_t wakeAll();
+
+    /**
+     * Appends a thread without sending it to sleep, e.g. a busy waiter which wants to be
+     * visible for deadlock detection. It has to be taken out again with remove().
+     */
+    void add(Thread* thread);
+
+    /**
+     * Removes the thread from the queue, nothing happens if it is not in the queue.
+     */
+    void remove(Thread* thread);
+
+    bool isEmpty() const
+    {
+      return head_ == 0;
+    }
+
+    /**
+     * The longest waiting thread, follow Thread::next_thread_in_wait_queue_ for the others.
+     * Reading the list without the queue being locked is only safe if no element can be
+     * removed meanwhile (i.e. for checks and debug output).
+     */
+    Thread* first() const
+    {
+      return head_;
+    }
+
+  private:
+    /**
+     * list operations, lock_ has to be held
+     */
+    void append(Thread* thread);
+    void unlink(Thread* thread);
+    Thread* popFront();
+
+    Thread* head_;
+    Thread* tail_;
+    IrqSafeSpinLock lock_;
+
+    WaitQueue(WaitQueue const &);
+    WaitQueue &operator=(WaitQueue const&);
+};
@@ -10,10 +10,15 @@
 #define sc_write 4
 #define sc_open 5
 #define sc_close 6
+#define sc_unlink 10
 #define sc_lseek 19
+#define sc_brk 45
 #define sc_pseudols 43
 #define sc_outline 105
+#define sc_sched_setclass 156
 #define sc_sched_yield 158
+#define sc_nanosleep 162
 #define sc_createprocess 191
 #define sc_trace 252
+#define sc_clock_gettime 265
 
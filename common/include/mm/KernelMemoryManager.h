@@ -4,6 +4,12 @@
 #include "SpinLock.h"
 #include "assert.h"
 
+/**
+ * set to 1 to verify the markers of all segments, the consistency of the free lists and
+ * that free memory is still zero after every allocation and free, this makes both O(heap size)
+ */
+#define KMM_DEBUG_CHECKS (0)
+
 class MallocSegment
 {
   public:
@@ -19,6 +25,8 @@ class MallocSegment
       marker_(0xdeadbeef00000000ull | (uint32) (size_t) this),
       next_(next),
       prev_(prev),
+      next_free_(0),
+      prev_free_(0),
       freed_at_(0),
       alloc_at_(0)
     {
@@ -59,6 +67,9 @@ class MallocSegment
     uint64 marker_; // = (0xdeadbeef << 32) | (this & 0xffffffff);
     MallocSegment *next_; // = NULL;
     MallocSegment *prev_; // = NULL;
+    // links within the free list of the size class, only valid while the segment is free
+    MallocSegment *next_free_;
+    MallocSegment *prev_free_;
     // the address where this chunk has been allocated or released at last
     pointer freed_at_;
     pointer alloc_at_;
@@ -77,7 +88,7 @@ class KernelMemoryManager
 
     /**
      * allocateMemory is called by new
-     * searches the MallocSegment-List for a free segment with size >= requested_size
+     * takes a free segment with size >= requested_size out of the smallest fitting size class
      * @param requested_size number of bytes to allocate
      * @return pointer to Memory Address or 0 if Not Enough Memory
      */
@@ -127,15 +138,52 @@ class KernelMemoryManager
     static KernelMemoryManager *instance_;
 
   private:
+    /**
+     * Free segments are kept in segregated free lists (two level segregated fit, TLSF).
+     * The first level splits the sizes into powers of two, the second level splits every
+     * power of two into SL_COUNT equally sized classes. Sizes below SMALL_LIMIT get exact
+     * classes with a granularity of 16 bytes. One bitmap per level tells which lists are
+     * non-empty, so finding a fitting segment is O(1) regardless of fragmentation.
+     */
+    static const size_t GRANULE_SHIFT = 4;
+    static const size_t SL_BITS = 4;
+    static const size_t SL_COUNT = 1 << SL_BITS;
+    static const size_t FL_SHIFT = SL_BITS + GRANULE_SHIFT;
+    static const size_t SMALL_LIMIT = 1 << FL_SHIFT;
+    static const size_t FL_COUNT = 31 - FL_SHIFT + 2; // segments are smaller than 2^31
+
+    /**
+     * removes a free segment with size >= requested_size from the free lists,
+     * grows the heap if there is none
+     */
     MallocSegment *findFreeSegment(size_t requested_size);
 
+    /**
+     * size class a free segment of the given size belongs to
+     */
+    static void mappingInsert(size_t size, size_t& fl, size_t& sl);
+
+    /**
+     * first size class in which every segment is at least the given size
+     * @return false if there is no such class
+     */
+    static bool mappingSearch(size_t size, size_t& fl, size_t& sl);
+
+    void insertFreeSegment(MallocSegment *this_one);
+    void removeFreeSegment(MallocSegment *this_one);
+
+    /**
+     * walks the whole heap, only used if KMM_DEBUG_CHECKS is enabled
+     */
+    void checkHeap();
+
     /**
      * creates a new segment after the given one if the space is big enough
+     * free memory is always zeroed, the new segment and an allocated free segment need no clearing
      * @param this_one the segment
      * @param size the size to used
-     * @param zero_check whether memory is zero'd
      */
-    void fillSegment(MallocSegment *this_one, size_t size, uint32 zero_check = 1);
+    void fillSegment(MallocSegment *this_one, size_t size);
 
     void freeSegment(MallocSegment *this_one);
     MallocSegment *getSegmentFromAddress(pointer virtual_address);
@@ -160,6 +208,10 @@ class KernelMemoryManager
     size_t reserved_min_;
     bool tracing_;
 
+    uint32 fl_bitmap_;
+    uint32 sl_bitmap_[FL_COUNT];
+    MallocSegment* free_lists_[FL_COUNT][SL_COUNT];
+
     void lockKMM();
     void unlockKMM();
 
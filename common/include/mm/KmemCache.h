@@ -0,0 +1,122 @@
+#pragma once
+
+#include "types.h"
+#include "IrqSafeSpinLock.h"
+
+/**
+ * Object cache for fixed size kernel objects, similar to the kmem_cache of Solaris and Linux.
+ * The objects are handed out from slabs of 2^n physically contiguous pages which are taken
+ * directly from the PageManager, so neither the KMM lock nor a heap search is involved.
+ * Every slab starts with a header, free objects inside a slab are linked through their first
+ * word. Slabs are aligned to their size, so the slab of an object is found by masking its
+ * address. One completely free slab is kept per cache, all others go back to the PageManager.
+ *
+ * Caches are global objects which are constant initialised (there are no global constructors
+ * in the kernel), they register themselves for the statistics on their first allocation.
+ * A class uses a cache by defining its own operator new and delete, so the regular C++
+ * constructors and destructors run on the cached memory:
+ *
+ *   static KmemCache dentry_cache("Dentry", sizeof(Dentry));
+ *   void* Dentry::operator new(size_t size) { return dentry_cache.allocate(size); }
+ *   void Dentry::operator delete(void* object) { dentry_cache.free(object); }
+ */
+class KmemCache
+{
+  public:
+    /**
+     * @param name shown in the statistics, has to be a string literal
+     * @param object_size size of the objects, rounded up to OBJECT_ALIGNMENT
+     */
+    constexpr KmemCache(const char* name, size_t object_size) :
+        name_(name), object_size_((object_size + OBJECT_ALIGNMENT - 1) & ~(OBJECT_ALIGNMENT - 1)),
+        slab_order_(0), objects_per_slab_(0), partial_slabs_(0), full_slabs_(0), empty_slab_(0), num_slabs_(0),
+        objects_in_use_(0), allocations_(0), frees_(0), next_cache_(0), registered_(false)
+    {
+    }
+
+    /**
+     * @param size the size the caller needs, only for checking against the object size
+     * @return an uninitialised object
+     */
+    void* allocate(size_t size);
+
+    /**
+     * @param object has to be allocated from this cache
+     */
+    void free(void* object);
+
+    size_t objectSize() const
+    {
+      return object_size_;
+    }
+
+    /**
+     * prints the statistics of all caches which have been used so far
+     */
+    static void printStatistics();
+
+    /**
+     * @return the number of bytes used by the slabs of all caches
+     */
+    static size_t getUsedSlabMemory();
+
+    static const size_t OBJECT_ALIGNMENT = 16;
+
+  private:
+    /**
+     * at least this many objects have to fit into a slab unless it would exceed MAX_SLAB_ORDER
+     */
+    static const size_t MIN_OBJECTS_PER_SLAB = 4;
+    static const size_t MAX_SLAB_ORDER = 4;
+
+    struct Slab
+    {
+      KmemCache* cache;
+      Slab* next;
+      Slab* prev;
+      void* free_objects;
+      size_t objects_in_use;
+      size_t ppn;
+    };
+
+    /**
+     * picks the slab size and adds the cache to the statistics list
+     */
+    void registerCache();
+
+    /**
+     * takes the pages for a new slab and links all of its objects into its free list
+     */
+    Slab* createSlab();
+
+    size_t slabSize() const;
+    size_t firstObjectOffset() const;
+
+    static void listInsert(Slab*& head, Slab* slab);
+    static void listRemove(Slab*& head, Slab* slab);
+
+    const char* name_;
+    size_t object_size_;
+    size_t slab_order_;
+    size_t objects_per_slab_;
+
+    Slab* partial_slabs_;
+    Slab* full_slabs_;
+    Slab* empty_slab_;
+
+    size_t num_slabs_;
+    size_t objects_in_use_;
+    size_t allocations_;
+    size_t frees_;
+
+    KmemCache* next_cache_;
+    bool registered_;
+
+    IrqSafeSpinLock lock_;
+
+    static KmemCache* caches_;
+    static IrqSafeSpinLock caches_lock_;
+
+    KmemCache(KmemCache const &);
+    KmemCache &operator=(KmemCache const&);
+};
@@ -13,13 +13,15 @@ private:
 
   /**
    * Print out the pagefault information. Check if the pagefault is valid, or the thread state is corrupt.
-   * Afterwards, load a the if necessary.
+   * A write to a copy-on-write page is valid, the page is copied right away.
    * @param address The address on which the fault happened
    * @param user true if the fault occurred in user mode, else from kernel mode
    * @param present true if the fault happened on a already mapped page
+   * @param writing true if the fault happened by writing to an address, only such faults
+   *                may hit a mapped (copy-on-write) page
    * @param switch_to_us the switch to userspace flag of the current thread
    */
-  static inline bool checkPageFaultIsValid(size_t address, bool user, bool present, bool switch_to_us);
+  static inline bool checkPageFaultIsValid(size_t address, bool user, bool present, bool writing, bool switch_to_us);
 
   /**
    * Print out the pagefault information. Check if the pagefault is valid, or the thread state is corrupt.
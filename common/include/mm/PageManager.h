@@ -4,13 +4,52 @@
 #include "paging-definitions.h"
 #include "SpinLock.h"
 #include "Bitmap.h"
+#include "ArchMulticore.h"
 
 #define DYNAMIC_KMM (0) // Please note that this means that the KMM depends on the page manager
 // and you will have a harder time implementing swapping. Pros only!
 
+/**
+ * Physical page allocator. Free memory is managed by a binary buddy allocator with blocks of
+ * 2^order pages, order 0 to MAX_ORDER. Blocks are aligned to their size and every free block
+ * is linked into the free list of its order through a FreeBlock header in its first page, so
+ * allocating and freeing take O(MAX_ORDER). A bitmap marks the pages which start a free block,
+ * it is needed to find out whether the buddy of a freed block can be merged with it.
+ * The page usage bitmap of the old allocator is only used while booting.
+ *
+ * Single zeroed pages are taken from a small pool of pages which the IdleThread clears
+ * ahead of time, so page faults do not have to wait for the 4 KiB memset.
+ *
+ * Single pages are allocated from and freed to a magazine of the current cpu first, which
+ * only needs interrupts disabled. The magazines are refilled from the zero pool and the free
+ * lists and drained back in batches of MAGAZINE_BATCH pages, so only every MAGAZINE_BATCH-th
+ * single page operation has to take the lock.
+ *
+ * Pages which fork() maps into two address spaces at once keep a count of their
+ * additional users, they are only freed once the last address space lets them go.
+ */
 class PageManager
 {
   public:
+    static const size_t MAX_ORDER = 10;
+    static const size_t ZERO_POOL_SIZE = 64;
+    static const size_t MAGAZINE_SIZE = 32;
+    static const size_t MAGAZINE_BATCH = 16;
+
+    enum AllocFlags
+    {
+      ALLOC_ZEROED = 0,
+      /**
+       * the caller overwrites the whole block, its content is undefined
+       */
+      ALLOC_NO_ZERO = 1,
+      /**
+       * returns 0 right away if no free block is large enough, instead of scraping the
+       * magazines and the zero pool together and failing an assertion
+       */
+      ALLOC_MAY_FAIL = 2
+    };
+
     static PageManager *instance();
 
     /**
@@ -27,19 +66,48 @@ class PageManager
     size_t getNumFreePages() const;
 
     /**
-     * returns the number of the lowest free Page
-     * and marks that Page as used.
+     * allocates physically contiguous, zeroed memory aligned to its size
      * returns always 4kb ppns!
+     * @param page_size PAGE_SIZE times a power of two up to 2^MAX_ORDER
+     * @param flags ALLOC_NO_ZERO skips clearing the block, ALLOC_MAY_FAIL allows failing
+     * @return the first ppn of the block, 0 if it may fail and did
      */
-    uint32 allocPPN(uint32 page_size = PAGE_SIZE);
+    uint32 allocPPN(uint32 page_size = PAGE_SIZE, uint32 flags = ALLOC_ZEROED);
 
     /**
      * marks physical page <page_number> as free, if it was used in
-     * user or kernel space.
+     * user or kernel space. Blocks may also be freed in smaller aligned pieces.
      * @param page_number Physcial Page to mark as unused
+     * @param page_size PAGE_SIZE times a power of two
      */
     void freePPN(uint32 page_number, uint32 page_size = PAGE_SIZE);
 
+    /**
+     * adds a user to a single page which is mapped into another address space as well,
+     * freePPN then only drops one user until the last one frees the page
+     * @param ppn a page allocated with allocPPN
+     */
+    void shareFrame(size_t ppn);
+
+    /**
+     * called on the first write to a copy-on-write page: a page which is still shared is
+     * copied and the writer is dropped from its users, a page which has no other users
+     * left is handed back unchanged
+     * @param ppn the shared page
+     * @return the page which the writer owns exclusively now
+     */
+    size_t copySharedFrame(size_t ppn);
+
+    /**
+     * @return number of additional users of a page, 0 if only one user has it
+     */
+    size_t getShareCount(size_t ppn) const;
+
+    /**
+     * @return number of pages which have been copied by copySharedFrame
+     */
+    size_t getNumCopiedFrames() const;
+
     Thread* heldBy()
     {
       return lock_.heldBy();
@@ -47,25 +115,147 @@ class PageManager
 
     PageManager();
 
-    void printBitmap()
+    /**
+     * clears one free page and adds it to the zero pool, called by the IdleThread
+     * @return true if the pool is full or no free page is left
+     */
+    bool refillZeroPool();
+
+    /**
+     * @return number of zeroed single page allocations served from the zero pool
+     */
+    size_t getZeroPoolHits() const;
+
+    /**
+     * @return number of zeroed single page allocations which had to clear the page themselves
+     */
+    size_t getZeroPoolMisses() const;
+
+    /**
+     * @return how often the lock has been taken so far
+     */
+    size_t getLockAcquisitions() const;
+
+    /**
+     * prints the number of free blocks of every order and the zero pool statistics
+     */
+    void printUsage();
+
+    /**
+     * Allocates two blocks of every order which fits into the free memory, checks that they
+     * are aligned, zeroed and do not overlap and frees them again, partly in smaller pieces.
+     * Asserts that no page got lost. Called once while booting, nobody else may allocate
+     * meanwhile.
+     */
+    void selfCheck();
+
+  private:
+    /**
+     * header in the first page of every free block, reached via the identity mapping
+     */
+    struct FreeBlock
+    {
+      FreeBlock* next;
+      FreeBlock* prev;
+      size_t ppn;
+      size_t order;
+    };
+
+    /**
+     * free single pages of one cpu, only accessed by that cpu with interrupts disabled
+     */
+    struct PageMagazine
+    {
+      size_t count;
+      size_t ppns[MAGAZINE_SIZE];
+      bool zeroed[MAGAZINE_SIZE];
+    };
+
+    void acquireLock()
     {
-      page_usage_table_->bmprint();
+      lock_.acquire();
+      ++lock_acquisitions_;
     }
 
-  private:
     /**
-     * used internally to mark pages as reserved
-     * @param ppn
-     * @param num
-     * @return
+     * takes a single page from the magazine of the current cpu, refills it if it is empty
+     * @param zero clear the page unless it is known to be zero already
+     * @return the ppn or 0 if there is no free page left
      */
-    bool reservePages(uint32 ppn, uint32 num = 1);
+    size_t allocPage(bool zero);
+
+    /**
+     * puts a single page into the magazine of the current cpu, drains it if it is full
+     */
+    void freePage(size_t ppn);
+
+    /**
+     * moves up to MAGAZINE_BATCH pages from the zero pool and the free lists into the
+     * magazine of the current cpu
+     */
+    void refillMagazine();
+
+    /**
+     * returns all pages of the magazine of the current cpu to the free lists
+     */
+    void drainMagazine();
+
+    /**
+     * returns a block to the free lists and merges it with its buddies as far as possible
+     * the lock has to be held
+     */
+    void freeBlock(size_t ppn, size_t order);
+
+    /**
+     * frees the pages [start, end) in as few blocks as possible, only used while booting
+     */
+    void freeRange(size_t start, size_t end);
+
+    /**
+     * takes a block from the free lists, splitting a larger one if necessary
+     * the lock has to be held
+     * @return the first ppn of the block or 0 if there is no large enough block
+     */
+    size_t allocBlock(size_t order);
+
+    /**
+     * returns all pages of the zero pool to the free lists, so they can be merged again
+     * the lock has to be held
+     */
+    void drainZeroPool();
+
+    /**
+     * drops one additional user of a shared page
+     * @return false if the page was not shared, the caller is its last user then
+     */
+    bool releaseSharedFrame(size_t ppn);
+
+    void insertFreeBlock(size_t ppn, size_t order);
+    void removeFreeBlock(FreeBlock* block);
+
+    static size_t pageSizeToOrder(size_t page_size);
 
     PageManager(PageManager const&);
 
-    Bitmap* page_usage_table_;
+    Bitmap* free_block_heads_;
+    FreeBlock* free_lists_[MAX_ORDER + 1];
+    size_t num_free_blocks_[MAX_ORDER + 1];
     uint32 number_of_pages_;
-    uint32 lowest_unreserved_page_;
+    size_t num_free_pages_;
+
+    size_t zero_pool_[ZERO_POOL_SIZE];
+    size_t zero_pool_count_;
+    size_t zero_pool_hits_;
+    size_t zero_pool_misses_;
+
+    /**
+     * number of additional users of every page, only changed atomically
+     */
+    uint16* share_counts_;
+    size_t num_copied_frames_;
+
+    PageMagazine magazines_[ArchMulticore::MAX_CPUS];
+    size_t lock_acquisitions_;
 
     SpinLock lock_;
 
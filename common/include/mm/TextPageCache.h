@@ -0,0 +1,79 @@
+#pragma once
+
+#include "types.h"
+#include "Mutex.h"
+
+class Inode;
+
+/**
+ * Frames of the read only pages of binaries, so processes which run the same binary map
+ * the same frames instead of reading every page from the file system once per process.
+ * Pages are keyed by the inode of the binary and their virtual page number.
+ *
+ * The cache is one user of each of its frames (see PageManager::shareFrame), every address
+ * space mapping a frame is another one. Once MAX_PAGES pages are cached, the pages which
+ * no address space maps anymore are evicted. The pages of an inode are dropped when it is
+ * written to or destroyed.
+ */
+class TextPageCache
+{
+  public:
+    static const size_t MAX_PAGES = 1024;
+    static const size_t NUM_BUCKETS = 256;
+
+    static TextPageCache* instance();
+
+    TextPageCache();
+
+    /**
+     * @param inode the binary
+     * @param virtual_page the page in the address space of the binary
+     * @return the cached frame, the caller is one more user of it, or 0 if it is not cached
+     */
+    size_t acquire(Inode* inode, size_t virtual_page);
+
+    /**
+     * adds a page which has just been loaded, the cache becomes a user of the frame as well
+     * @param ppn the loaded page, it is freed if the page has been cached meanwhile
+     * @return the frame which is cached for the page, the caller is one of its users
+     */
+    size_t insert(Inode* inode, size_t virtual_page, size_t ppn);
+
+    /**
+     * drops all pages of the inode, the address spaces mapping them keep their frames.
+     * Returns right away for inodes without cached pages (see Inode::i_text_pages_).
+     */
+    void dropInode(Inode* inode);
+
+    size_t getHits() const;
+    size_t getMisses() const;
+
+    /**
+     * prints the number of cached pages and the hit statistics
+     */
+    void printStatistics();
+
+  private:
+    struct Entry
+    {
+      Entry* next;
+      Inode* inode;
+      size_t virtual_page;
+      size_t ppn;
+    };
+
+    static size_t bucketOf(Inode* inode, size_t virtual_page);
+
+    /**
+     * frees all pages which only the cache uses, the lock has to be held
+     */
+    void evictUnused();
+
+    Entry* buckets_[NUM_BUCKETS];
+    size_t num_pages_;
+    size_t hits_;
+    size_t misses_;
+    Mutex lock_;
+
+    static TextPageCache* instance_;
+};
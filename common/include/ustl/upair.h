@@ -39,7 +39,9 @@ public:
     inline void		write (ostream& os) const;
     void		text_write (ostringstream& os) const;
     inline size_t	stream_size (void) const;
-#if HAVE_CPP11
+#if !HAVE_CPP11
+    inline		pair (const pair& p2)		: first (p2.first), second (p2.second) {}
+#else
 			pair (const pair&) = default;
 			pair (pair&&) = default;
     template <typename T3, typename T4>
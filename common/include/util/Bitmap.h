@@ -4,13 +4,23 @@
 
 #define BITMAP_BYTE_COUNT(number_of_bits) (number_of_bits / Bitmap::bits_per_bitmap_atom_ + ((number_of_bits % Bitmap::bits_per_bitmap_atom_ > 0) ? 1 : 0))
 
+/**
+ * The bits are stored in bytes, but searched 64 bits at a time. Bitmaps which are searched
+ * for clear bits very often can keep a summary level with one bit per 64 bit word, which is
+ * set when all bits of the word are set, so findFirstClear skips 4096 used bits per word
+ * of the summary.
+ */
 class Bitmap
 {
   public:
 
     static uint8 const bits_per_bitmap_atom_;
 
-    Bitmap(size_t number_of_bits);
+    /**
+     * @param number_of_bits size of the bitmap, all bits are clear
+     * @param with_summary keep the summary level for findFirstClear
+     */
+    Bitmap(size_t number_of_bits, bool with_summary = false);
     ~Bitmap();
 
     bool setBit(size_t bit_number);
@@ -24,6 +34,20 @@ class Bitmap
 
     size_t getSize();
 
+    /**
+     * @param start the first bit to look at
+     * @return the first clear bit at or after start, getSize() if there is none
+     */
+    size_t findFirstClear(size_t start = 0);
+    static size_t findFirstClear(const uint8* b, size_t num_bits, size_t start);
+
+    /**
+     * @param start the first bit to look at
+     * @return the first set bit at or after start, getSize() if there is none
+     */
+    size_t findNextSet(size_t start = 0);
+    static size_t findNextSet(const uint8* b, size_t num_bits, size_t start);
+
     /**
      * returns the number of bits set
      * @return the number of bits set
@@ -59,8 +83,23 @@ class Bitmap
     uint8 getByte(size_t byte_number);
 
   private:
+    /**
+     * @return the 64 bit word <word_number> of b, bits beyond num_bits are clear
+     */
+    static uint64 getWord(const uint8* b, size_t num_bits, size_t word_number);
+
+    /**
+     * sets the summary bit of the word containing bit_number if all of its bits are set,
+     * clears it otherwise
+     */
+    void updateSummary(size_t bit_number);
+
     size_t size_;
     size_t num_bits_set_;
     uint8 *bitmap_;
+    uint8 *summary_;
+
+    Bitmap(Bitmap const &);
+    Bitmap &operator=(Bitmap const&);
 };
 
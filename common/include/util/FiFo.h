@@ -3,7 +3,7 @@
 #include "kprintf.h"
 #include "new.h"
 #include "Mutex.h"
-#include "Condition.h"
+#include "WaitQueue.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -60,9 +60,15 @@ class FiFo
     void clear();
 
   private:
+    /**
+     * Releases the buffer lock and sleeps in the given queue until woken up,
+     * re-acquires the lock afterwards
+     */
+    void waitIn(WaitQueue& queue);
+
     Mutex input_buffer_lock_;
-    Condition something_to_read_;
-    Condition space_to_write_;
+    WaitQueue something_to_read_;
+    WaitQueue space_to_write_;
 
     uint32 input_buffer_size_;
     T *input_buffer_;
@@ -74,8 +80,7 @@ class FiFo
 
 template<class T>
 FiFo<T>::FiFo(uint32 inputb_size, uint8 flags) :
-    input_buffer_lock_("FiFo input_buffer_lock_"), something_to_read_(&input_buffer_lock_, "FiFo::something_to_read_"),
-	space_to_write_(&input_buffer_lock_, "FiFo::space_to_write_")
+    input_buffer_lock_("FiFo input_buffer_lock_")
 {
   if (inputb_size < 2)
     input_buffer_size_ = 512;
@@ -114,14 +119,24 @@ void FiFo<T>::put(T c)
     }
     else
       while (ib_write_pos_ == ib_read_pos_)
-        space_to_write_.wait();
+        waitIn(space_to_write_);
   }
-  something_to_read_.signal();
   input_buffer_[ib_write_pos_++] = c;
   ib_write_pos_ %= input_buffer_size_;
+  something_to_read_.wakeOne();
   input_buffer_lock_.release();
 }
 
+template<class T>
+void FiFo<T>::waitIn(WaitQueue& queue)
+{
+  // we are in the queue before the lock is released, so a wake up can not get lost
+  queue.prepareToWait();
+  input_buffer_lock_.release();
+  queue.sleep();
+  input_buffer_lock_.acquire();
+}
+
 template<class T>
 void FiFo<T>::clear(void)
 {
@@ -139,11 +154,11 @@ T FiFo<T>::get()
   input_buffer_lock_.acquire();
 
   while (ib_write_pos_ == ((ib_read_pos_ + 1) % input_buffer_size_)) //nothing new to read
-    something_to_read_.wait(); //this implicates release & acquire
+    waitIn(something_to_read_); //this implicates release & acquire
 
-  space_to_write_.signal();
   ib_read_pos_ = (ib_read_pos_ + 1) % input_buffer_size_;
   ret = input_buffer_[ib_read_pos_];
+  space_to_write_.wakeOne();
 
   input_buffer_lock_.release();
   return ret;
@@ -22,6 +22,7 @@ class RingBuffer
     bool get ( T &c );
     void put ( T c );
     void clear();
+    bool isEmpty();
 
   private:
 
@@ -66,6 +67,12 @@ void RingBuffer<T>::clear()
   ArchThreads::testSetLock ( read_pos_,0 );
 }
 
+template <class T>
+bool RingBuffer<T>::isEmpty()
+{
+  return write_pos_ == ( read_pos_ + 1 ) % buffer_size_;
+}
+
 template <class T>
 bool RingBuffer<T>::get ( T &c )
 {
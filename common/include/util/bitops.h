@@ -0,0 +1,13 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * the index of the lowest set bit of value, which must not be 0. __builtin_ctzll becomes a
+ * call to __ctzdi2 from libgcc on 32 bit targets, which the kernel does not link
+ */
+static inline size_t ctz64(uint64 value)
+{
+  uint32 low = (uint32) value;
+  return low ? __builtin_ctz(low) : 32 + __builtin_ctz((uint32) (value >> 32));
+}
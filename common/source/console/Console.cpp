@@ -4,6 +4,8 @@
 #include "KeyboardManager.h"
 #include "Scheduler.h"
 #include "PageManager.h"
+#include "TextPageCache.h"
+#include "DentryCache.h"
 #include "backtrace.h"
 
 Console* main_console;
@@ -48,7 +50,9 @@ void Console::handleKey(uint32 key)
   switch (key)
   {
     case KEY_F9:
-      PageManager::instance()->printBitmap();
+      PageManager::instance()->printUsage();
+      TextPageCache::instance()->printStatistics();
+      DentryCache::instance()->printStatistics();
       kprintfd("Used kernel memory: %zu\n", KernelMemoryManager::instance()->getUsedKernelMemory(true));
       break;
 
@@ -118,7 +122,7 @@ void Console::Run(void)
         handleKey(key);
       }
     }
-    Scheduler::instance()->yield();
+    km->waitForKeys();
   } while (1);
 }
 bool Console::isDisplayable(uint32 key)
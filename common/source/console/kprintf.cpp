@@ -6,6 +6,7 @@
 #include "ArchInterrupts.h"
 #include "RingBuffer.h"
 #include "Scheduler.h"
+#include "WaitQueue.h"
 #include "assert.h"
 #include "debug.h"
 #include "ustringformat.h"
@@ -15,18 +16,24 @@
 
 RingBuffer<char> *nosleep_rb_;
 Thread *flush_thread_;
+WaitQueue *nosleep_rb_filled_;
+volatile bool nosleep_rb_wake_pending_;
 
 void flushActiveConsole()
 {
   assert(main_console);
   assert(nosleep_rb_);
   assert(ArchInterrupts::testIFSet());
+  nosleep_rb_filled_->prepareToWait();
+  if (nosleep_rb_->isEmpty())
+    nosleep_rb_filled_->sleep();
+  else
+    nosleep_rb_filled_->finishWait();
   char c = 0;
   while (nosleep_rb_->get(c))
   {
     main_console->getActiveTerminal()->write(c);
   }
-  Scheduler::instance()->yield();
 }
 
 class KprintfFlushingThread : public Thread
@@ -49,8 +56,10 @@ class KprintfFlushingThread : public Thread
 void kprintf_init()
 {
   nosleep_rb_ = new RingBuffer<char>(1024);
+  nosleep_rb_filled_ = new WaitQueue();
   debug(KPRINTF, "Adding Important kprintf Flush Thread\n");
   flush_thread_ = new KprintfFlushingThread();
+  Scheduler::instance()->setScheduling(flush_thread_, NormalClass, Scheduler::PRIORITY_LEVELS - 1);
   Scheduler::instance()->addNewThread(flush_thread_);
 }
 
@@ -65,9 +74,19 @@ void kprintf_func(int ch, void *arg __attribute__((unused)))
   else
   {
     nosleep_rb_->put(ch);
+    // waking the thread takes the run queue lock, which might be held right now
+    nosleep_rb_wake_pending_ = true;
   }
 }
 
+void kprintf_wake_flush_thread()
+{
+  if (!nosleep_rb_wake_pending_)
+    return;
+  nosleep_rb_wake_pending_ = false;
+  nosleep_rb_filled_->wakeOne();
+}
+
 void kprintf(const char *fmt, ...)
 {
   va_list args;
@@ -1,17 +1,44 @@
 #include "Dentry.h"
 #include "assert.h"
 #include "Inode.h"
+#ifndef EXE2MINIXFS
+#include "KmemCache.h"
+#include "DentryCache.h"
+#endif
 
 #include "kprintf.h"
 
+/**
+ * the number of buckets of a new hash index, it doubles whenever there are more children
+ */
+#define CHILD_HASH_MIN_SIZE 8
+
+#ifndef EXE2MINIXFS
+static KmemCache dentry_cache("Dentry", sizeof(Dentry));
+
+void* Dentry::operator new(size_t size)
+{
+  return dentry_cache.allocate(size);
+}
+
+void Dentry::operator delete(void* address)
+{
+  dentry_cache.free(address);
+}
+#endif
+
 Dentry::Dentry(const char* name) :
-    d_inode_(0), d_parent_(this), d_mounts_(0), d_name_(name)
+    d_inode_(0), d_parent_(this), d_first_child_(0), d_last_child_(0), d_num_children_(0),
+    d_prev_sibling_(0), d_next_sibling_(0), d_child_hash_(0), d_child_hash_size_(0), d_hash_next_(0),
+    d_name_hash_(hashName(name, strlen(name))), d_cache_entries_(0), d_mounts_(0), d_name_(name)
 {
   debug(DENTRY, "created Dentry with Name %s\n", name);
 }
 
-Dentry::Dentry(Dentry *parent) :
-    d_inode_(0), d_parent_(parent), d_mounts_(0), d_name_("NamELLEss")
+Dentry::Dentry(Dentry *parent, const char* name) :
+    d_inode_(0), d_parent_(parent), d_first_child_(0), d_last_child_(0), d_num_children_(0),
+    d_prev_sibling_(0), d_next_sibling_(0), d_child_hash_(0), d_child_hash_size_(0), d_hash_next_(0),
+    d_name_hash_(hashName(name, strlen(name))), d_cache_entries_(0), d_mounts_(0), d_name_(name)
 {
   parent->setChild(this);
 }
@@ -24,8 +51,13 @@ Dentry::~Dentry()
     debug(DENTRY, "deleting Dentry child remove d_parent_: %p\n", d_parent_);
     d_parent_->childRemove(this);
   }
-  for (Dentry* dentry : d_child_)
+  for (Dentry* dentry = d_first_child_; dentry; dentry = dentry->d_next_sibling_)
     dentry->d_parent_ = 0;
+  delete[] d_child_hash_;
+#ifndef EXE2MINIXFS
+  if (d_cache_entries_)
+    DentryCache::instance()->dropParent(this);
+#endif
   debug(DENTRY, "deleting Dentry finished\n");
 }
 
@@ -37,15 +69,43 @@ void Dentry::setInode(Inode *inode)
 void Dentry::childInsert(Dentry *child_dentry)
 {
   assert(child_dentry != 0);
-  d_child_.push_back(child_dentry);
+  child_dentry->d_prev_sibling_ = d_last_child_;
+  child_dentry->d_next_sibling_ = 0;
+  if (d_last_child_)
+    d_last_child_->d_next_sibling_ = child_dentry;
+  else
+    d_first_child_ = child_dentry;
+  d_last_child_ = child_dentry;
+  ++d_num_children_;
+  hashInsert(child_dentry);
+#ifndef EXE2MINIXFS
+  // the name might be cached as not existing
+  DentryCache::instance()->invalidate(this, child_dentry->getName(), child_dentry->d_name_hash_);
+#endif
 }
 
 int32 Dentry::childRemove(Dentry *child_dentry)
 {
-  debug(DENTRY, "Dentry childRemove d_child_ included: %d\n",
-        ustl::find(d_child_.begin(), d_child_.end(), child_dentry) != d_child_.end());
   assert(child_dentry != 0);
-  d_child_.remove(child_dentry);
+  bool included = hashRemove(child_dentry);
+  debug(DENTRY, "Dentry childRemove child included: %d\n", included);
+  if (included)
+  {
+    if (child_dentry->d_prev_sibling_)
+      child_dentry->d_prev_sibling_->d_next_sibling_ = child_dentry->d_next_sibling_;
+    else
+      d_first_child_ = child_dentry->d_next_sibling_;
+    if (child_dentry->d_next_sibling_)
+      child_dentry->d_next_sibling_->d_prev_sibling_ = child_dentry->d_prev_sibling_;
+    else
+      d_last_child_ = child_dentry->d_prev_sibling_;
+    child_dentry->d_prev_sibling_ = 0;
+    child_dentry->d_next_sibling_ = 0;
+    --d_num_children_;
+#ifndef EXE2MINIXFS
+    DentryCache::instance()->invalidate(this, child_dentry->getName(), child_dentry->d_name_hash_);
+#endif
+  }
   child_dentry->d_parent_ = 0;
   debug(DENTRY, "Dentry childRemove remove == 0\n");
   return 0;
@@ -58,33 +118,101 @@ const char* Dentry::getName()
 
 int32 Dentry::setChild(Dentry *dentry)
 {
-  if (dentry == 0 || ustl::find(d_child_.begin(), d_child_.end(), dentry) != d_child_.end())
+  if (dentry == 0)
     return -1;
+  if (d_child_hash_)
+  {
+    for (Dentry* child = hashBucket(dentry->d_name_hash_); child; child = child->d_hash_next_)
+    {
+      if (child == dentry)
+        return -1;
+    }
+  }
 
-  d_child_.push_back(dentry);
+  childInsert(dentry);
 
   return 0;
 }
 
 Dentry* Dentry::checkName(const char* name)
 {
-  for (Dentry* dentry : d_child_)
+  if (!d_child_hash_)
+    return 0;
+
+  size_t name_hash = hashName(name, strlen(name));
+  for (Dentry* dentry = hashBucket(name_hash); dentry; dentry = dentry->d_hash_next_)
   {
-    const char *tmp_name = dentry->getName();
-    debug(DENTRY, "(checkname) name : %s\n", tmp_name);
-    if (strcmp(tmp_name, name) == 0)
+    debug(DENTRY, "(checkname) name : %s\n", dentry->getName());
+    if (dentry->d_name_hash_ == name_hash && strcmp(dentry->getName(), name) == 0)
       return dentry;
   }
 
   return 0;
 }
 
+size_t Dentry::hashName(const char* name, size_t length)
+{
+  // FNV-1a
+  uint32 hash = 2166136261U;
+  for (size_t i = 0; i < length; ++i)
+  {
+    hash ^= (uint8) name[i];
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+Dentry*& Dentry::hashBucket(size_t name_hash)
+{
+  return d_child_hash_[name_hash & (d_child_hash_size_ - 1)];
+}
+
+void Dentry::hashInsert(Dentry *child_dentry)
+{
+  if (d_num_children_ <= d_child_hash_size_)
+  {
+    Dentry*& bucket = hashBucket(child_dentry->d_name_hash_);
+    child_dentry->d_hash_next_ = bucket;
+    bucket = child_dentry;
+    return;
+  }
+
+  // the child list already holds the new child, so rebuilding the index from it inserts the child as well
+  delete[] d_child_hash_;
+  d_child_hash_size_ = d_child_hash_size_ ? d_child_hash_size_ * 2 : CHILD_HASH_MIN_SIZE;
+  d_child_hash_ = new Dentry*[d_child_hash_size_];
+  for (size_t i = 0; i < d_child_hash_size_; ++i)
+    d_child_hash_[i] = 0;
+  for (Dentry* dentry = d_first_child_; dentry; dentry = dentry->d_next_sibling_)
+  {
+    Dentry*& bucket = hashBucket(dentry->d_name_hash_);
+    dentry->d_hash_next_ = bucket;
+    bucket = dentry;
+  }
+}
+
+bool Dentry::hashRemove(Dentry *child_dentry)
+{
+  if (!d_child_hash_)
+    return false;
+  for (Dentry** link = &hashBucket(child_dentry->d_name_hash_); *link; link = &(*link)->d_hash_next_)
+  {
+    if (*link == child_dentry)
+    {
+      *link = child_dentry->d_hash_next_;
+      child_dentry->d_hash_next_ = 0;
+      return true;
+    }
+  }
+  return false;
+}
+
 uint32 Dentry::getNumChild()
 {
-  return d_child_.size();
+  return d_num_children_;
 }
 
 bool Dentry::emptyChild()
 {
-  return d_child_.empty();
+  return d_first_child_ == 0;
 }
@@ -0,0 +1,173 @@
+#include "DentryCache.h"
+#include "Dentry.h"
+#include "MutexLock.h"
+#include "kstring.h"
+#include "kprintf.h"
+#include "assert.h"
+#include "debug.h"
+
+const size_t DentryCache::MAX_ENTRIES;
+const size_t DentryCache::NUM_BUCKETS;
+
+DentryCache* DentryCache::instance_ = 0;
+
+DentryCache* DentryCache::instance()
+{
+  if (unlikely(!instance_))
+    instance_ = new DentryCache();
+  return instance_;
+}
+
+DentryCache::DentryCache() :
+    lru_head_(0), lru_tail_(0), num_entries_(0), generation_(0), hits_(0), negative_hits_(0), misses_(0),
+    lock_("DentryCache::lock_")
+{
+  for (size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+    buckets_[bucket] = 0;
+}
+
+size_t DentryCache::bucketOf(Dentry* parent, size_t name_hash)
+{
+  return (((size_t)parent / sizeof(size_t)) * 2654435761U ^ name_hash) % NUM_BUCKETS;
+}
+
+DentryCache::Entry** DentryCache::find(Dentry* parent, const char* name, size_t length, size_t name_hash)
+{
+  for (Entry** link = &buckets_[bucketOf(parent, name_hash)]; *link; link = &(*link)->hash_next)
+  {
+    Entry* entry = *link;
+    if (entry->parent == parent && entry->name_hash == name_hash && entry->name.size() == length &&
+        memcmp(entry->name.c_str(), name, length) == 0)
+      return link;
+  }
+  return 0;
+}
+
+bool DentryCache::lookup(Dentry* parent, const char* name, size_t length, size_t name_hash, Dentry*& dentry,
+                         size_t& generation)
+{
+  MutexLock lock(lock_);
+  Entry** link = find(parent, name, length, name_hash);
+  if (!link)
+  {
+    ++misses_;
+    generation = generation_;
+    return false;
+  }
+
+  Entry* entry = *link;
+  lruUnlink(entry);
+  lruPushFront(entry);
+  dentry = entry->dentry;
+  if (dentry)
+    ++hits_;
+  else
+    ++negative_hits_;
+  return true;
+}
+
+void DentryCache::insert(Dentry* parent, ustl::string& name, size_t name_hash, Dentry* dentry, size_t generation)
+{
+  MutexLock lock(lock_);
+  if (generation != generation_ || find(parent, name.c_str(), name.size(), name_hash))
+  {
+    debug(DENTRY, "DentryCache::insert: %s changed meanwhile, not caching it\n", name.c_str());
+    return;
+  }
+
+  if (num_entries_ >= MAX_ENTRIES)
+  {
+    Entry* victim = lru_tail_;
+    remove(find(victim->parent, victim->name.c_str(), victim->name.size(), victim->name_hash));
+  }
+
+  Entry*& bucket = buckets_[bucketOf(parent, name_hash)];
+  Entry* entry = new Entry();
+  entry->hash_next = bucket;
+  entry->parent = parent;
+  entry->name_hash = name_hash;
+  entry->dentry = dentry;
+  entry->name.swap(name);
+  bucket = entry;
+  lruPushFront(entry);
+  ++parent->d_cache_entries_;
+  ++num_entries_;
+}
+
+void DentryCache::invalidate(Dentry* parent, const char* name, size_t name_hash)
+{
+  MutexLock lock(lock_);
+  // lookups which are running concurrently must not cache what they have found before the change
+  ++generation_;
+  if (!parent->d_cache_entries_)
+    return;
+  Entry** link = find(parent, name, strlen(name), name_hash);
+  if (link)
+    remove(link);
+}
+
+void DentryCache::dropParent(Dentry* parent)
+{
+  MutexLock lock(lock_);
+  for (size_t bucket = 0; bucket < NUM_BUCKETS && parent->d_cache_entries_; ++bucket)
+  {
+    Entry** link = &buckets_[bucket];
+    while (*link)
+    {
+      if ((*link)->parent == parent)
+        remove(link);
+      else
+        link = &(*link)->hash_next;
+    }
+  }
+  assert(parent->d_cache_entries_ == 0);
+}
+
+void DentryCache::remove(Entry** link)
+{
+  Entry* entry = *link;
+  *link = entry->hash_next;
+  lruUnlink(entry);
+  --entry->parent->d_cache_entries_;
+  --num_entries_;
+  delete entry;
+}
+
+void DentryCache::lruUnlink(Entry* entry)
+{
+  if (entry->lru_prev)
+    entry->lru_prev->lru_next = entry->lru_next;
+  else
+    lru_head_ = entry->lru_next;
+  if (entry->lru_next)
+    entry->lru_next->lru_prev = entry->lru_prev;
+  else
+    lru_tail_ = entry->lru_prev;
+}
+
+void DentryCache::lruPushFront(Entry* entry)
+{
+  entry->lru_prev = 0;
+  entry->lru_next = lru_head_;
+  if (lru_head_)
+    lru_head_->lru_prev = entry;
+  else
+    lru_tail_ = entry;
+  lru_head_ = entry;
+}
+
+size_t DentryCache::getHits() const
+{
+  return hits_ + negative_hits_;
+}
+
+size_t DentryCache::getMisses() const
+{
+  return misses_;
+}
+
+void DentryCache::printStatistics()
+{
+  kprintfd("DentryCache: %zu of %zu entries cached, %zu hits (%zu negative), %zu misses\n", num_entries_,
+           MAX_ENTRIES, hits_ + negative_hits_, negative_hits_, misses_);
+}
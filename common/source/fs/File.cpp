@@ -24,3 +24,10 @@ l_off_t File::lseek(l_off_t offset, uint8 origin)
 
   return offset_;
 }
+
+int32 File::pread(char *buffer, size_t count, l_off_t position)
+{
+  if (((flag_ == O_RDONLY) || (flag_ == O_RDWR)) && (mode_ & A_READABLE))
+    return f_inode_->readData(position, count, buffer);
+  return -1;
+}
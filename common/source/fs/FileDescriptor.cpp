@@ -1,30 +1,30 @@
 #include "FileDescriptor.h"
-#include <ulist.h>
+#include "FileDescriptorTable.h"
 #ifndef EXE2MINIXFS
-#include "ArchThreads.h"
-#include "Mutex.h"
+#include "KmemCache.h"
 #endif
 #include "kprintf.h"
 
-ustl::list<FileDescriptor*> global_fd;
-Mutex global_fd_lock("global_fd_lock");
+#ifndef EXE2MINIXFS
+static KmemCache file_descriptor_cache("FileDescriptor", sizeof(FileDescriptor));
 
-static size_t fd_num_ = 3;
+void* FileDescriptor::operator new(size_t size)
+{
+  return file_descriptor_cache.allocate(size);
+}
 
-void FileDescriptor::add(FileDescriptor* fd)
+void FileDescriptor::operator delete(void* address)
 {
-  MutexLock ml(global_fd_lock);
-  global_fd.push_back(fd);
+  file_descriptor_cache.free(address);
 }
+#endif
 
-void FileDescriptor::remove(FileDescriptor* fd)
+uint32 FileDescriptor::add(FileDescriptor* fd)
 {
-  MutexLock ml(global_fd_lock);
-  global_fd.remove(fd);
+  return getFdTable()->add(fd);
 }
 
-FileDescriptor::FileDescriptor(File* file)
+FileDescriptor::FileDescriptor(File* file) :
+    fd_(0), file_(file), users_(1)
 {
-  fd_ = ArchThreads::atomic_add(fd_num_, 1);
-  file_ = file;
 }
@@ -0,0 +1,116 @@
+#include "FileDescriptorTable.h"
+#include "FileDescriptor.h"
+#include "File.h"
+#include "Inode.h"
+#include "Superblock.h"
+#include "assert.h"
+#include "kprintf.h"
+#ifndef EXE2MINIXFS
+#include "ArchThreads.h"
+#endif
+
+const uint32 FileDescriptorTable::FIRST_FD;
+
+FileDescriptorTable::FileDescriptorTable() :
+    fds_(0), size_(0), lowest_free_(FIRST_FD), lock_("FileDescriptorTable::lock_")
+{
+}
+
+FileDescriptorTable::~FileDescriptorTable()
+{
+  for (uint32 fd = FIRST_FD; fd < size_; ++fd)
+  {
+    if (fds_[fd])
+    {
+      debug(VFSSYSCALL, "~FileDescriptorTable: closing fd %u\n", fd);
+      release(fds_[fd]);
+    }
+  }
+  delete[] fds_;
+}
+
+void FileDescriptorTable::copyFrom(FileDescriptorTable& parent)
+{
+  MutexLock parent_lock(parent.lock_);
+  MutexLock lock(lock_);
+  assert(lowest_free_ == FIRST_FD && "the table of a forked process has to be empty");
+  if (parent.size_)
+    grow(parent.size_ - 1);
+  for (uint32 fd = FIRST_FD; fd < parent.size_; ++fd)
+  {
+    fds_[fd] = parent.fds_[fd];
+    if (fds_[fd])
+      ArchThreads::atomic_add(fds_[fd]->users_, 1);
+  }
+  lowest_free_ = parent.lowest_free_;
+}
+
+uint32 FileDescriptorTable::add(FileDescriptor* file_descriptor)
+{
+  assert(file_descriptor);
+  MutexLock lock(lock_);
+  uint32 fd = lowest_free_;
+  while (fd < size_ && fds_[fd])
+    ++fd;
+  grow(fd);
+
+  fds_[fd] = file_descriptor;
+  file_descriptor->fd_ = fd;
+  lowest_free_ = fd + 1;
+  return fd;
+}
+
+FileDescriptor* FileDescriptorTable::get(uint32 fd)
+{
+  MutexLock lock(lock_);
+  return fd < size_ ? fds_[fd] : 0;
+}
+
+FileDescriptor* FileDescriptorTable::remove(uint32 fd)
+{
+  MutexLock lock(lock_);
+  if (fd < FIRST_FD || fd >= size_ || !fds_[fd])
+    return 0;
+
+  FileDescriptor* file_descriptor = fds_[fd];
+  fds_[fd] = 0;
+  if (fd < lowest_free_)
+    lowest_free_ = fd;
+  return file_descriptor;
+}
+
+int32 FileDescriptorTable::close(uint32 fd)
+{
+  FileDescriptor* file_descriptor = remove(fd);
+  if (!file_descriptor)
+    return -1;
+
+  release(file_descriptor);
+  return 0;
+}
+
+void FileDescriptorTable::release(FileDescriptor* file_descriptor)
+{
+  if (ArchThreads::atomic_add(file_descriptor->users_, -1) != 1)
+    return;
+
+  Inode* inode = file_descriptor->getFile()->getInode();
+  assert(inode->getSuperblock()->removeFd(inode, file_descriptor) == 0);
+}
+
+void FileDescriptorTable::grow(uint32 fd)
+{
+  if (fd < size_)
+    return;
+
+  uint32 size = size_ ? size_ : 2 * FIRST_FD;
+  while (size <= fd)
+    size *= 2;
+
+  FileDescriptor** fds = new FileDescriptor*[size];
+  for (uint32 i = 0; i < size; ++i)
+    fds[i] = i < size_ ? fds_[i] : 0;
+  delete[] fds_;
+  fds_ = fds;
+  size_ = size;
+}
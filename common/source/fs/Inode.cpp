@@ -0,0 +1,11 @@
+#include "Inode.h"
+#ifndef EXE2MINIXFS
+#include "TextPageCache.h"
+#endif
+
+Inode::~Inode()
+{
+#ifndef EXE2MINIXFS
+  TextPageCache::instance()->dropInode(this);
+#endif
+}
@@ -7,7 +7,9 @@
 #include "kstring.h"
 #include "kprintf.h"
 #include "FileSystemInfo.h"
+#include "ustring.h"
 #ifndef EXE2MINIXFS
+#include "DentryCache.h"
 #include "Mutex.h"
 #include "Thread.h"
 #endif
@@ -23,9 +25,6 @@ int32 PathWalker::pathWalk(const char* pathname, uint32 flags_ __attribute__ ((u
   // Flag indicating the type of the last path component.
   int32 last_type_ = 0;
 
-  // The last path component
-  char* last_ = 0;
-
   FileSystemInfo *fs_info = getcwd();
   if (pathname == 0)
   {
@@ -76,37 +75,26 @@ int32 PathWalker::pathWalk(const char* pathname, uint32 flags_ __attribute__ ((u
   bool parts_left = true;
   while (parts_left)
   {
-    int32 npart_pos = 0;
-    int32 npart_len = getNextPartLen(pathname, npart_pos);
-    char npart[npart_len];
-    strncpy(npart, pathname, npart_len);
-    npart[npart_len - 1] = 0;
-    debug(PATHWALKER, "pathWalk> npart : %s\n", npart);
-    debug(PATHWALKER, "pathWalk> npart_pos : %d\n", npart_pos);
-    if (npart_pos < 0)
-    {
-      debug(PATHWALKER, "pathWalk> return path invalid npart_pos < 0 \n");
-      return PW_EINVALID;
-    }
-
-    if ((*npart == NULL_CHAR) || (npart_pos == 0))
+    // the part is not copied, it ends at the next separator or at the end of the path
+    const char* npart = pathname;
+    size_t npart_len = getNextPartLen(pathname);
+    debug(PATHWALKER, "pathWalk> npart : %.*s\n", (int) npart_len, npart);
+    if (npart_len == 0)
     {
       debug(PATHWALKER, "pathWalk> return success\n");
       return PW_SUCCESS;
     }
-    pathname += npart_pos;
+    pathname += npart_len;
+    while (*pathname == SEPARATOR)
+      pathname++;
 
-    last_ = npart;
-    if (*npart == CHAR_DOT)
+    if (npart_len == 1 && *npart == CHAR_DOT)
     {
-      if (*(npart + 1) == NULL_CHAR)
-      {
-        last_type_ = LAST_DOT;
-      }
-      else if ((*(npart + 1) == CHAR_DOT) && (*(npart + 2) == NULL_CHAR))
-      {
-        last_type_ = LAST_DOTDOT;
-      }
+      last_type_ = LAST_DOT;
+    }
+    else if (npart_len == 2 && *npart == CHAR_DOT && *(npart + 1) == CHAR_DOT)
+    {
+      last_type_ = LAST_DOTDOT;
     }
     else
     {
@@ -118,13 +106,11 @@ int32 PathWalker::pathWalk(const char* pathname, uint32 flags_ __attribute__ ((u
     if (last_type_ == LAST_DOT) // follow LAST_DOT
     {
       debug(PATHWALKER, "pathWalk> follow last dot\n");
-      last_ = 0;
       continue;
     }
     else if (last_type_ == LAST_DOTDOT) // follow LAST_DOTDOT
     {
       debug(PATHWALKER, "pathWalk> follow last dotdot\n");
-      last_ = 0;
 
       if ((dentry_ == fs_info->getRoot()) && (vfs_mount_ == fs_info->getRootMnt()))
       {
@@ -147,14 +133,12 @@ int32 PathWalker::pathWalk(const char* pathname, uint32 flags_ __attribute__ ((u
     }
     else if (last_type_ == LAST_NORM) // follow LAST_NORM
     {
-      debug(PATHWALKER, "pathWalk> follow last norm last_: %s\n", last_);
-      Inode* current_inode = dentry_->getInode();
-      Dentry *found = current_inode->lookup(last_);
+      debug(PATHWALKER, "pathWalk> follow last norm: %.*s\n", (int) npart_len, npart);
+      Dentry* found = lookup(dentry_, npart, npart_len);
       if (found)
         debug(PATHWALKER, "pathWalk> found->getName() : %s\n", found->getName());
       else
         debug(PATHWALKER, "pathWalk> no dentry found !!!\n");
-      last_ = 0;
       if (found != 0)
       {
         dentry_ = found;
@@ -180,10 +164,7 @@ int32 PathWalker::pathWalk(const char* pathname, uint32 flags_ __attribute__ ((u
 #endif
     }
 
-    while (*pathname == SEPARATOR)
-      pathname++;
-
-    if (strlen(pathname) == 0)
+    if (!*pathname)
     {
       break;
     }
@@ -193,20 +174,27 @@ int32 PathWalker::pathWalk(const char* pathname, uint32 flags_ __attribute__ ((u
   return PW_SUCCESS;
 }
 
-int32 PathWalker::getNextPartLen(const char* path, int32 &npart_len)
+size_t PathWalker::getNextPartLen(const char* path)
 {
-  char* tmp = 0;
-  tmp = strchr((char*) path, SEPARATOR);
-
-  npart_len = (size_t) (tmp - path + 1);
-
-  uint32 length = npart_len;
+  const char* separator = strchr((char*) path, SEPARATOR);
+  return separator ? (size_t) (separator - path) : strlen(path);
+}
 
-  if (tmp == 0)
-  {
-    npart_len = strlen(path);
-    length = npart_len + 1;
-  }
+Dentry* PathWalker::lookup(Dentry* parent, const char* name, size_t length)
+{
+  Dentry* found = 0;
+#ifndef EXE2MINIXFS
+  size_t name_hash = Dentry::hashName(name, length);
+  size_t generation = 0;
+  if (DentryCache::instance()->lookup(parent, name, length, name_hash, found, generation))
+    return found;
+#endif
 
-  return length;
+  // the file system needs a terminated name
+  ustl::string npart(name, length);
+  found = parent->getInode()->lookup(npart.c_str());
+#ifndef EXE2MINIXFS
+  DentryCache::instance()->insert(parent, npart, name_hash, found, generation);
+#endif
+  return found;
 }
@@ -7,6 +7,7 @@
 #include "Superblock.h"
 #include "File.h"
 #include "FileDescriptor.h"
+#include "FileDescriptorTable.h"
 #include "FileSystemType.h"
 #include "FileSystemInfo.h"
 #include "VirtualFileSystem.h"
@@ -17,6 +18,7 @@
 #ifndef EXE2MINIXFS
 #include "Mutex.h"
 #include "Thread.h"
+#include "TextPageCache.h"
 #endif
 
 #define SEPARATOR '/'
@@ -24,17 +26,7 @@
 
 FileDescriptor* VfsSyscall::getFileDescriptor(uint32 fd)
 {
-  extern Mutex global_fd_lock;
-  MutexLock mlock(global_fd_lock);
-  for (auto it : global_fd)
-  {
-    if (it->getFd() == fd)
-    {
-      debug(VFSSYSCALL, "found the fd\n");
-      return it;
-    }
-  }
-  return 0;
+  return getFdTable()->get(fd);
 }
 
 int32 VfsSyscall::dupChecking(const char* pathname, Dentry*& pw_dentry, VfsMount*& pw_vfs_mount)
@@ -97,8 +89,7 @@ int32 VfsSyscall::mkdir(const char* pathname, int32)
   }
 
   // create a new dentry
-  Dentry *sub_dentry = new Dentry(pw_dentry);
-  sub_dentry->d_name_ = sub_dentry_name;
+  Dentry *sub_dentry = new Dentry(pw_dentry, sub_dentry_name.c_str());
   debug(VFSSYSCALL, "(mkdir) creating Inode: current_dentry->getName(): %s\n", pw_dentry->getName());
   debug(VFSSYSCALL, "(mkdir) creating Inode: sub_dentry->getName(): %s\n", sub_dentry->getName());
   debug(VFSSYSCALL, "(mkdir) current_sb: %p\n", current_sb);
@@ -133,7 +124,7 @@ Dirent* VfsSyscall::readdir(const char* pathname)
     }
 
     debug(VFSSYSCALL, "listing dir %s:\n", pw_dentry->getName());
-    for (Dentry* sub_dentry : pw_dentry->d_child_)
+    for (Dentry* sub_dentry = pw_dentry->d_first_child_; sub_dentry; sub_dentry = sub_dentry->d_next_sibling_)
     {
       uint32 inode_type = sub_dentry->getInode()->getType();
       switch (inode_type)
@@ -259,15 +250,11 @@ int32 VfsSyscall::rmdir(const char* pathname)
 
 int32 VfsSyscall::close(uint32 fd)
 {
-  FileDescriptor* file_descriptor = getFileDescriptor(fd);
-
-  if (file_descriptor == 0)
+  if (getFdTable()->close(fd))
   {
     debug(VFSSYSCALL, "(close) Error: the fd does not exist.\n");
     return -1;
   }
-  Inode* current_inode = file_descriptor->getFile()->getInode();
-  assert(current_inode->getSuperblock()->removeFd(current_inode, file_descriptor) == 0);
   return 0;
 }
 
@@ -327,9 +314,7 @@ int32 VfsSyscall::open(const char* pathname, uint32 flag)
     }
 
     // create a new dentry
-    Dentry *sub_dentry = new Dentry(pw_dentry);
-    sub_dentry->d_name_ = sub_dentry_name;
-    sub_dentry->setParent(pw_dentry);
+    Dentry *sub_dentry = new Dentry(pw_dentry, sub_dentry_name.c_str());
     debug(VFSSYSCALL, "(open) calling create Inode\n");
     Inode* sub_inode = current_sb->createInode(sub_dentry, I_FILE);
     if (!sub_inode)
@@ -375,6 +360,10 @@ int32 VfsSyscall::write(uint32 fd, const char *buffer, uint32 count)
 
   if (count == 0)
     return 0;
+#ifndef EXE2MINIXFS
+  // processes which already run the binary keep the old pages, new ones load the written content
+  TextPageCache::instance()->dropInode(file_descriptor->getFile()->getInode());
+#endif
   return file_descriptor->getFile()->write(buffer, count, 0);
 }
 
@@ -33,8 +33,7 @@ DeviceFSSuperBlock::DeviceFSSuperBlock(Dentry* s_root, uint32 s_dev) :
   assert(root_init == 0);
   all_inodes_.push_back(root_inode);
 
-  Dentry *device_root_dentry = new Dentry(root_dentry);
-  device_root_dentry->d_name_ = DEVICE_ROOT_NAME;
+  Dentry *device_root_dentry = new Dentry(root_dentry, DEVICE_ROOT_NAME);
 
   // create the inode for the device_root_dentry
   Inode *device_root_inode = (Inode*) (new RamFSInode(this, I_DIR));
@@ -71,8 +70,7 @@ DeviceFSSuperBlock::~DeviceFSSuperBlock()
 
 void DeviceFSSuperBlock::addDevice(Inode* device, const char* device_name)
 {
-  Dentry* fdntr = new Dentry(s_dev_dentry_);
-  fdntr->d_name_ = device_name;
+  Dentry* fdntr = new Dentry(s_dev_dentry_, device_name);
 
   cDevice = (Inode *) device;
   cDevice->mknod(fdntr);
@@ -93,7 +91,7 @@ Inode* DeviceFSSuperBlock::createInode(Dentry* dentry, uint32 type)
   }
   else if (type == I_FILE)
   {
-    kprintfd("createInode: I_FILE\n");
+    debug(RAMFS, "createInode: I_FILE\n");
     int32 inode_init = inode->mkfile(dentry);
     assert(inode_init == 0);
   }
@@ -126,7 +124,6 @@ int32 DeviceFSSuperBlock::removeFd(Inode* inode, FileDescriptor* fd)
   assert(fd);
 
   s_files_.remove(fd);
-  FileDescriptor::remove(fd);
 
   File* file = fd->getFile();
   int32 tmp = inode->unlink(file);
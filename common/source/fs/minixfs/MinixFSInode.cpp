@@ -1,12 +1,27 @@
 #include "MinixFSInode.h"
 #ifndef EXE2MINIXFS
 #include "kstring.h"
+#include "KmemCache.h"
 #endif
 #include <assert.h>
 #include "MinixFSSuperblock.h"
 #include "MinixFSFile.h"
 #include "Dentry.h"
 
+#ifndef EXE2MINIXFS
+static KmemCache minix_fs_inode_cache("MinixFSInode", sizeof(MinixFSInode));
+
+void* MinixFSInode::operator new(size_t size)
+{
+  return minix_fs_inode_cache.allocate(size);
+}
+
+void MinixFSInode::operator delete(void* address)
+{
+  minix_fs_inode_cache.free(address);
+}
+#endif
+
 MinixFSInode::MinixFSInode(Superblock *super_block, uint32 inode_type) :
     Inode(super_block, inode_type), i_zones_(0), i_num_(0), children_loaded_(false)
 {
@@ -291,7 +306,7 @@ int32 MinixFSInode::rmdir()
 
   //the "." and ".." dentries will be deleted in some inode-dtor
   //("." in this inodes-dtor, ".." in the parent-dentry-inodes-dtor)
-  for (Dentry* child : dentry->d_child_)
+  for (Dentry* child = dentry->d_first_child_; child; child = child->d_next_sibling_)
   {
     if (strcmp(child->getName(), ".") != 0 && strcmp(child->getName(), "..") != 0)
     {
@@ -425,9 +440,7 @@ void MinixFSInode::loadChildren()
         name[MAX_NAME_LENGTH] = 0;
 
         debug(M_INODE, "loadChildren: dentry name: %s\n", name);
-        Dentry *new_dentry = new Dentry(name);
-        i_dentry_->setChild(new_dentry);
-        new_dentry->setParent(i_dentry_);
+        Dentry *new_dentry = new Dentry(i_dentry_, name);
         if (!is_already_loaded)
         {
           ((MinixFSInode *) inode)->i_dentry_ = new_dentry;
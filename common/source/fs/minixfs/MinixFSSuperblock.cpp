@@ -343,7 +343,6 @@ int32 MinixFSSuperblock::removeFd(Inode* inode, FileDescriptor* fd)
   assert(fd);
 
   s_files_.remove(fd);
-  FileDescriptor::remove(fd);
 
   File* file = fd->getFile();
   int32 tmp = inode->unlink(file);
@@ -2,11 +2,26 @@
 #include "MinixFSSuperblock.h"
 #ifndef EXE2MINIXFS
 #include "kstring.h"
+#include "KmemCache.h"
 #endif
 #include "kprintf.h"
 #include <assert.h>
 #include "minix_fs_consts.h"
 
+#ifndef EXE2MINIXFS
+static KmemCache minix_fs_zone_cache("MinixFSZone", sizeof(MinixFSZone));
+
+void* MinixFSZone::operator new(size_t size)
+{
+  return minix_fs_zone_cache.allocate(size);
+}
+
+void MinixFSZone::operator delete(void* address)
+{
+  minix_fs_zone_cache.free(address);
+}
+#endif
+
 MinixFSZone::MinixFSZone(MinixFSSuperblock *superblock, uint32 *zones)
 {
   superblock_ = superblock;
@@ -60,24 +60,15 @@ uint32 MinixStorageManager::getNumUsedInodes()
 
 size_t MinixStorageManager::allocZone()
 {
-  size_t pos = curr_zone_pos_ + 1;
-  for (; pos != curr_zone_pos_; ++pos)
+  size_t pos = zone_bitmap_.findFirstClear(curr_zone_pos_ + 1);
+  if (pos >= zone_bitmap_.getSize())
+    pos = zone_bitmap_.findFirstClear(0);
+  if (pos < zone_bitmap_.getSize())
   {
-    if (pos >= zone_bitmap_.getSize())
-    {
-      pos = 0;
-      if(pos == curr_zone_pos_) // Increment happens before check in for loop, which would lead to an infinite loop when curr_zone_pos_ = 0
-      {
-              break;
-      }
-    }
-    if (!zone_bitmap_.getBit(pos))
-    {
-      zone_bitmap_.setBit(pos);
-      curr_zone_pos_ = pos;
-      debug(M_STORAGE_MANAGER, "acquireZone: Zone %zu acquired\n", pos);
-      return pos;
-    }
+    zone_bitmap_.setBit(pos);
+    curr_zone_pos_ = pos;
+    debug(M_STORAGE_MANAGER, "acquireZone: Zone %zu acquired\n", pos);
+    return pos;
   }
   debug(M_STORAGE_MANAGER, "acquireZone: NO FREE ZONE FOUND!\n");
   assert(false); // full memory should have been checked.
@@ -86,18 +77,15 @@ size_t MinixStorageManager::allocZone()
 
 size_t MinixStorageManager::allocInode()
 {
-  size_t pos = curr_inode_pos_ + 1;
-  for (; pos != curr_inode_pos_; pos++)
+  size_t pos = inode_bitmap_.findFirstClear(curr_inode_pos_ + 1);
+  if (pos >= inode_bitmap_.getSize())
+    pos = inode_bitmap_.findFirstClear(0);
+  if (pos < inode_bitmap_.getSize())
   {
-    if (pos >= inode_bitmap_.getSize())
-      pos = 0;
-    if (!inode_bitmap_.getBit(pos))
-    {
-      inode_bitmap_.setBit(pos);
-      curr_inode_pos_ = pos;
-      debug(M_STORAGE_MANAGER, "acquireInode: Inode %zu acquired\n", pos);
-      return pos;
-    }
+    inode_bitmap_.setBit(pos);
+    curr_inode_pos_ = pos;
+    debug(M_STORAGE_MANAGER, "acquireInode: Inode %zu acquired\n", pos);
+    return pos;
   }
   kprintfd("acquireInode: NO FREE INODE FOUND!\n");
   assert(false); // full memory should have been checked.
@@ -19,8 +19,8 @@ void CleanupThread::Run()
 {
   while (1)
   {
+    Scheduler::instance()->waitForDeadThreads();
     Scheduler::instance()->cleanupDeadThreads();
-    Scheduler::instance()->yield();
   }
 }
 
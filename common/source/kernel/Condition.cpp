@@ -47,11 +47,12 @@ void Condition::wait(bool re_acquire_mutex, pointer called_by)
           currentThread->getName(), currentThread, getName(), this);
     printHoldingList(currentThread);
   }
-  lockWaitersList();
   last_accessed_at_ = called_by;
-  // The mutex can be released here, because for waking up another thread, the list lock is needed, which is still held by the thread.
+  currentThread->lock_waiting_on_ = this;
+  waiters_.prepareToWait();
+  // The mutex can be released here, because we are already on the waiters list, so a signal can not get lost.
   mutex_->release(called_by);
-  sleepAndRelease();
+  waiters_.sleep();
   // Thread has been woken up again
   currentThread->lock_waiting_on_ = 0;
 
@@ -79,25 +80,11 @@ void Condition::signal(pointer called_by, bool broadcast)
 
   assert(mutex_->isHeldBy(currentThread));
   checkInterrupts("Condition::signal");
-  do
-  {
-    lockWaitersList();
-    last_accessed_at_ = called_by;
-    Thread* thread_to_be_woken_up = popBackThreadFromWaitersList();
-    unlockWaitersList();
-
-    if(thread_to_be_woken_up)
-    {
-      //debug(LOCK, "Condition: Thread %s (%p) being signaled for condition %s (%p).\n",
-      //      thread_to_be_woken_up->getName(), thread_to_be_woken_up, getName(), this);
-
-      Scheduler::instance()->wake(thread_to_be_woken_up);
-    }
-    else
-    {
-      break;
-    }
-  } while (broadcast);
+  last_accessed_at_ = called_by;
+  if(broadcast)
+    waiters_.wakeAll();
+  else
+    waiters_.wakeOne();
 }
 
 void Condition::broadcast(pointer called_by)
@@ -1,6 +1,8 @@
 #include "IdleThread.h"
 #include "Scheduler.h"
 #include "ArchCommon.h"
+#include "ArchInterrupts.h"
+#include "PageManager.h"
 
 IdleThread::IdleThread() : Thread(0, "IdleThread", Thread::KERNEL_THREAD)
 {
@@ -8,20 +10,19 @@ IdleThread::IdleThread() : Thread(0, "IdleThread", Thread::KERNEL_THREAD)
 
 void IdleThread::Run()
 {
-  uint32 last_ticks = 0;
-  uint32 new_ticks = 0;
   while (1)
   {
-    new_ticks = Scheduler::instance()->getTicks();
-    if (new_ticks == last_ticks)
-    {
-      last_ticks = new_ticks + 1;
+    // clear a page for the zero pool instead of halting, one at a time so a thread which
+    // becomes runnable does not have to wait long
+    bool zero_pool_full = PageManager::instance()->refillZeroPool();
+
+    // with interrupts disabled nobody can become runnable between the check and the halt,
+    // idle() enables them again and returns after the next interrupt
+    ArchInterrupts::disableInterrupts();
+    if (zero_pool_full && Scheduler::instance()->run_queue_.size() == 0)
       ArchCommon::idle();
-    }
     else
-    {
-      last_ticks = new_ticks;
-      Scheduler::instance()->yield();
-    }
+      ArchInterrupts::enableInterrupts();
+    Scheduler::instance()->yield();
   }
 }
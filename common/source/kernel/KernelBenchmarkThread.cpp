@@ -0,0 +1,236 @@
+#include "KernelBenchmarkThread.h"
+#include "Scheduler.h"
+#include "ArchThreads.h"
+#include "ArchCommon.h"
+#include "Mutex.h"
+#include "Condition.h"
+#include "KernelMemoryManager.h"
+#include "PageManager.h"
+#include "ArchMemory.h"
+#include "assert.h"
+#include "kprintf.h"
+
+namespace
+{
+  /**
+   * simple linear congruential generator, good enough to pick sizes and victims
+   */
+  size_t nextRandom(size_t& state)
+  {
+    state = state * 1103515245 + 12345;
+    return (state >> 16) & 0x7FFF;
+  }
+
+  class YieldingThread : public Thread
+  {
+    public:
+      YieldingThread(size_t yields, int64* finished) :
+          Thread(0, "YieldingThread", Thread::KERNEL_THREAD), yields_(yields), finished_(finished)
+      {
+      }
+
+      virtual void Run()
+      {
+        for (size_t i = 0; i < yields_; ++i)
+          Scheduler::instance()->yield();
+        ArchThreads::atomic_add(*finished_, 1);
+      }
+
+    private:
+      size_t yields_;
+      int64* finished_;
+  };
+
+  struct HandoffState
+  {
+    HandoffState() : lock_("HandoffState::lock_"), turn_changed_(&lock_, "HandoffState::turn_changed_"), turn_(0),
+        finished_(0)
+    {
+    }
+
+    Mutex lock_;
+    Condition turn_changed_;
+    size_t turn_;
+    int64 finished_;
+  };
+
+  class HandoffThread : public Thread
+  {
+    public:
+      HandoffThread(HandoffState* state, size_t me, size_t rounds) :
+          Thread(0, "HandoffThread", Thread::KERNEL_THREAD), state_(state), me_(me), rounds_(rounds)
+      {
+      }
+
+      virtual void Run()
+      {
+        for (size_t i = 0; i < rounds_; ++i)
+        {
+          state_->lock_.acquire();
+          while (state_->turn_ != me_)
+            state_->turn_changed_.wait();
+          state_->turn_ = 1 - me_;
+          state_->turn_changed_.signal();
+          state_->lock_.release();
+        }
+        ArchThreads::atomic_add(state_->finished_, 1);
+      }
+
+    private:
+      HandoffState* state_;
+      size_t me_;
+      size_t rounds_;
+  };
+}
+
+KernelBenchmarkThread::KernelBenchmarkThread(Thread* next) :
+    Thread(0, "KernelBenchmarkThread", Thread::KERNEL_THREAD), next_(next)
+{
+}
+
+void KernelBenchmarkThread::Run()
+{
+  benchmarkScheduler();
+  benchmarkMutexHandoff();
+  benchmarkKernelHeap();
+  stressPageManager();
+  debug(BENCHMARK, "all kernel benchmarks done\n");
+  if (next_)
+    Scheduler::instance()->addNewThread(next_);
+}
+
+void KernelBenchmarkThread::benchmarkScheduler()
+{
+  const size_t YIELDS_PER_THREAD = 200;
+  const size_t thread_counts[] = { 1, 4, 16, 64, 128 };
+
+  for (size_t thread_count : thread_counts)
+  {
+    int64 finished = 0;
+    uint64 start = ArchCommon::getMonotonicTimeNs();
+    for (size_t i = 0; i < thread_count; ++i)
+      Scheduler::instance()->addNewThread(new YieldingThread(YIELDS_PER_THREAD, &finished));
+    while (finished != (int64)thread_count)
+      Scheduler::instance()->yield();
+    uint64 ns = ArchCommon::getMonotonicTimeNs() - start;
+
+    size_t switches = thread_count * YIELDS_PER_THREAD;
+    debug(BENCHMARK, "scheduler: %4zu threads, %7zu yields in %8zu us (%zu ns/yield)\n", thread_count, switches,
+          (size_t)(ns / 1000), (size_t)(ns / switches));
+  }
+}
+
+void KernelBenchmarkThread::benchmarkMutexHandoff()
+{
+  const size_t ROUNDS = 5000;
+
+  HandoffState state;
+  uint64 start = ArchCommon::getMonotonicTimeNs();
+  Scheduler::instance()->addNewThread(new HandoffThread(&state, 0, ROUNDS));
+  Scheduler::instance()->addNewThread(new HandoffThread(&state, 1, ROUNDS));
+  while (state.finished_ != 2)
+    Scheduler::instance()->yield();
+  uint64 ns = ArchCommon::getMonotonicTimeNs() - start;
+
+  size_t handoffs = 2 * ROUNDS;
+  debug(BENCHMARK, "mutex handoff: %zu handoffs in %zu us (%zu ns/handoff)\n", handoffs, (size_t)(ns / 1000),
+        (size_t)(ns / handoffs));
+}
+
+void KernelBenchmarkThread::benchmarkKernelHeap()
+{
+  const size_t LIVE_OBJECTS = 10000;
+  const size_t ROUNDS = 100000;
+  const size_t MAX_OBJECT_SIZE = 256;
+
+  size_t random = 12345;
+
+  size_t used_before = KernelMemoryManager::instance()->getUsedKernelMemory(false);
+  uint8** objects = new uint8*[LIVE_OBJECTS];
+
+  uint64 start = ArchCommon::getMonotonicTimeNs();
+  for (size_t i = 0; i < LIVE_OBJECTS; ++i)
+    objects[i] = new uint8[1 + nextRandom(random) % MAX_OBJECT_SIZE];
+  uint64 fill_ns = ArchCommon::getMonotonicTimeNs() - start;
+
+  start = ArchCommon::getMonotonicTimeNs();
+  for (size_t i = 0; i < ROUNDS; ++i)
+  {
+    size_t victim = nextRandom(random) % LIVE_OBJECTS;
+    delete[] objects[victim];
+    objects[victim] = new uint8[1 + nextRandom(random) % MAX_OBJECT_SIZE];
+  }
+  uint64 churn_ns = ArchCommon::getMonotonicTimeNs() - start;
+
+  size_t used_live = KernelMemoryManager::instance()->getUsedKernelMemory(false);
+
+  start = ArchCommon::getMonotonicTimeNs();
+  for (size_t i = 0; i < LIVE_OBJECTS; ++i)
+    delete[] objects[i];
+  uint64 drain_ns = ArchCommon::getMonotonicTimeNs() - start;
+  delete[] objects;
+
+  debug(BENCHMARK, "kernel heap: %zu live objects, fill %zu ns/alloc, drain %zu ns/free\n", LIVE_OBJECTS,
+        (size_t)(fill_ns / LIVE_OBJECTS), (size_t)(drain_ns / LIVE_OBJECTS));
+  debug(BENCHMARK, "kernel heap: %zu free+alloc pairs in %zu us (%zu ns/pair), %zu bytes in use while live\n", ROUNDS,
+        (size_t)(churn_ns / 1000), (size_t)(churn_ns / ROUNDS), used_live - used_before);
+}
+
+void KernelBenchmarkThread::stressPageManager()
+{
+  const size_t SLOTS = 64;
+  const size_t ROUNDS = 20000;
+
+  size_t random = 54321;
+  size_t ppns[SLOTS];
+  size_t orders[SLOTS];
+  for (size_t i = 0; i < SLOTS; ++i)
+    ppns[i] = 0;
+
+  size_t free_before = PageManager::instance()->getNumFreePages();
+  size_t lock_acquisitions_before = PageManager::instance()->getLockAcquisitions();
+  size_t allocations = 0;
+  uint64 start = ArchCommon::getMonotonicTimeNs();
+  for (size_t i = 0; i < ROUNDS; ++i)
+  {
+    size_t slot = nextRandom(random) % SLOTS;
+    if (ppns[slot])
+    {
+      // every page of the block still has to carry the tag written on allocation
+      for (size_t p = 0; p < (1U << orders[slot]); ++p)
+        assert(*(size_t*)ArchMemory::getIdentAddressOfPPN(ppns[slot] + p) == ppns[slot] &&
+               "PageManager handed out overlapping blocks");
+      PageManager::instance()->freePPN(ppns[slot], PAGE_SIZE << orders[slot]);
+      ppns[slot] = 0;
+    }
+    else
+    {
+      // mostly small blocks, like the callers of the PageManager
+      size_t order = nextRandom(random) % (PageManager::MAX_ORDER + 1);
+      if (nextRandom(random) % 4)
+        order %= 3;
+      if (PageManager::instance()->getNumFreePages() < free_before / 2 + (1U << order))
+        continue;
+      ppns[slot] = PageManager::instance()->allocPPN(PAGE_SIZE << order);
+      orders[slot] = order;
+      assert((ppns[slot] & ((1U << order) - 1)) == 0 && "block is not aligned to its size");
+      for (size_t p = 0; p < (1U << order); ++p)
+      {
+        size_t* page = (size_t*)ArchMemory::getIdentAddressOfPPN(ppns[slot] + p);
+        assert(*page == 0 && "block is not zeroed");
+        *page = ppns[slot];
+      }
+      ++allocations;
+    }
+  }
+  for (size_t i = 0; i < SLOTS; ++i)
+  {
+    if (ppns[i])
+      PageManager::instance()->freePPN(ppns[i], PAGE_SIZE << orders[i]);
+  }
+  uint64 ns = ArchCommon::getMonotonicTimeNs() - start;
+
+  assert(PageManager::instance()->getNumFreePages() == free_before && "PageManager lost pages");
+  debug(BENCHMARK, "page manager: %zu mixed order allocations and frees in %zu us, lock taken %zu times\n",
+        allocations, (size_t)(ns / 1000), PageManager::instance()->getLockAcquisitions() - lock_acquisitions_before);
+}
@@ -6,21 +6,37 @@
 #include "kstring.h"
 #include "ArchInterrupts.h"
 #include "Syscall.h"
-#include "VfsSyscall.h"
 #include <uvector.h>
 #include "backtrace.h"
 #include "Stabs2DebugInfo.h"
 #include "SWEBDebugInfo.h"
 #include <umemory.h>
 #include "File.h"
-#include "FileDescriptor.h"
+#include "offsets.h"
+#include "TextPageCache.h"
 
-Loader::Loader(ssize_t fd) : fd_(fd), hdr_(0), phdrs_(), program_binary_lock_("Loader::program_binary_lock_"), userspace_debug_info_(0)
+const size_t Loader::FAULT_AROUND_PAGES;
+const size_t Loader::PREFAULT_MAX_PAGES;
+
+Loader::Loader(File* file, LoadMode load_mode) : file_(file),
+    inode_(file_->getInode()), load_mode_(load_mode), hdr_(0), phdrs_(), heap_start_(0), heap_break_(0),
+    heap_lock_("Loader::heap_lock_"), userspace_debug_info_(0), num_page_faults_(0), num_pages_loaded_around_(0)
 {
 }
 
+Loader::Loader(Loader& parent, File* file) : arch_memory_(parent.arch_memory_),
+    file_(file), inode_(file_->getInode()), load_mode_(parent.load_mode_),
+    hdr_(new Elf::Ehdr(*parent.hdr_)), phdrs_(parent.phdrs_), heap_start_(parent.heap_start_), heap_break_(parent.heap_break_), heap_lock_("Loader::heap_lock_"), userspace_debug_info_(0), num_page_faults_(0),
+    num_pages_loaded_around_(0)
+{
+  if (USERTRACE & OUTPUT_ENABLED)
+    loadDebugInfoIfAvailable();
+}
+
 Loader::~Loader()
 {
+  debug(LOADER, "~Loader: %zu page faults in the binary, %zu pages loaded around them\n", num_page_faults_,
+        num_pages_loaded_around_);
   delete userspace_debug_info_;
   delete hdr_;
 }
@@ -29,12 +45,126 @@ void Loader::loadPage(pointer virtual_address)
 {
   debug(LOADER, "Loader:loadPage: Request to load the page for address %p.\n", (void*)virtual_address);
   const pointer virt_page_start_addr = virtual_address & ~(PAGE_SIZE - 1);
+
+  if (virtual_address >= heap_start_)
+  {
+    MutexLock lock(heap_lock_);
+    if (virtual_address < heap_break_)
+    {
+      loadHeapPage(virt_page_start_addr);
+      return;
+    }
+  }
+
+  __atomic_add_fetch(&num_page_faults_, 1, __ATOMIC_RELAXED);
+  pointer window_start, window_end;
+  getLoadWindow(virt_page_start_addr, window_start, window_end);
+  size_t loaded_around = loadBinaryPages(virt_page_start_addr, window_start, window_end);
+  __atomic_add_fetch(&num_pages_loaded_around_, loaded_around, __ATOMIC_RELAXED);
+  debug(LOADER, "Loader::loadPage: Load request for address %p has been successfully finished, %zu pages loaded around it.\n",
+        (void*)virtual_address, loaded_around);
+}
+
+size_t Loader::loadBinaryPages(pointer virt_page_start_addr, pointer window_start, pointer window_end)
+{
+  size_t ppns[MAP_BATCH_PAGES];
+  pointer batch_start = window_start;
+  size_t batch_pages = 0;
+  bool batch_read_only = false;
+  size_t loaded_around = 0;
+  for (pointer page = window_start; page < window_end; page += PAGE_SIZE)
+  {
+    bool around = page != virt_page_start_addr;
+    bool load = !around || !arch_memory_.checkAddressValid(page);
+    bool read_only = load && isReadOnlyPage(page);
+    // a batch consists of consecutive pages which are all shared or all private
+    if (batch_pages && (!load || read_only != batch_read_only || batch_pages == MAP_BATCH_PAGES))
+    {
+      mapBinaryPages(batch_start, batch_pages, ppns, batch_read_only);
+      batch_pages = 0;
+    }
+    if (!load)
+      continue;
+    if (!batch_pages)
+    {
+      batch_start = page;
+      batch_read_only = read_only;
+    }
+    ppns[batch_pages++] = getBinaryPage(page, read_only);
+    if (around)
+      ++loaded_around;
+  }
+  if (batch_pages)
+    mapBinaryPages(batch_start, batch_pages, ppns, batch_read_only);
+  return loaded_around;
+}
+
+size_t Loader::getBinaryPage(pointer virt_page_start_addr, bool read_only)
+{
+  if (!read_only)
+    return readPage(virt_page_start_addr);
+
+  // other processes running the same binary may have loaded the page already
+  const size_t virtual_page = virt_page_start_addr / PAGE_SIZE;
+  size_t ppn = TextPageCache::instance()->acquire(inode_, virtual_page);
+  if (!ppn)
+    ppn = TextPageCache::instance()->insert(inode_, virtual_page, readPage(virt_page_start_addr));
+  return ppn;
+}
+
+void Loader::mapBinaryPages(pointer first_page, size_t num_pages, const size_t* ppns, bool read_only)
+{
+  size_t mapped = read_only ? arch_memory_.mapSharedRange(first_page / PAGE_SIZE, num_pages, ppns) :
+                              arch_memory_.mapRange(first_page / PAGE_SIZE, num_pages, ppns, true);
+  if (mapped < num_pages)
+    debug(LOADER, "Loader::mapBinaryPages: %zu pages have been mapped by someone else.\n", num_pages - mapped);
+}
+
+void Loader::getLoadWindow(pointer virt_page_start_addr, pointer& window_start, pointer& window_end)
+{
+  window_start = virt_page_start_addr;
+  window_end = virt_page_start_addr + PAGE_SIZE;
+  if (load_mode_ == SinglePageLoad)
+    return;
+
+  for(ustl::list<Elf::Phdr>::iterator it = phdrs_.begin(); it != phdrs_.end(); it++)
+  {
+    if((*it).p_vaddr < virt_page_start_addr + PAGE_SIZE && (*it).p_vaddr + (*it).p_memsz > virt_page_start_addr)
+    {
+      // only pages of the faulting segment, those of other segments are loaded on their own faults
+      const pointer segment_start = (*it).p_vaddr & ~(PAGE_SIZE - 1);
+      const pointer segment_end = ((*it).p_vaddr + (*it).p_memsz + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+      if (load_mode_ == PrefaultLoad && segment_end - segment_start <= PREFAULT_MAX_PAGES * PAGE_SIZE)
+      {
+        window_start = segment_start;
+        window_end = segment_end;
+      }
+      else
+      {
+        const pointer window_size = FAULT_AROUND_PAGES * PAGE_SIZE;
+        window_start = ustl::max(segment_start, virt_page_start_addr & ~(window_size - 1));
+        window_end = ustl::min(segment_end, (virt_page_start_addr & ~(window_size - 1)) + window_size);
+      }
+      return;
+    }
+  }
+}
+
+size_t Loader::readPage(pointer virt_page_start_addr)
+{
   const pointer virt_page_end_addr = virt_page_start_addr + PAGE_SIZE;
   bool found_page_content = false;
-  // get a new page for the mapping
-  size_t ppn = PageManager::instance()->allocPPN();
 
-  program_binary_lock_.acquire();
+  // pages which are read completely from the binary do not have to be cleared first
+  bool page_overwritten = false;
+  for(ustl::list<Elf::Phdr>::iterator it = phdrs_.begin(); it != phdrs_.end(); it++)
+  {
+    if((*it).p_vaddr <= virt_page_start_addr && (*it).p_vaddr + (*it).p_filesz >= virt_page_end_addr)
+      page_overwritten = true;
+  }
+  // get a new page for the mapping
+  size_t ppn = PageManager::instance()->allocPPN(PAGE_SIZE, page_overwritten ? PageManager::ALLOC_NO_ZERO :
+                                                                               PageManager::ALLOC_ZEROED);
 
   // Iterate through all sections and load the ones intersecting into the page.
   for(ustl::list<Elf::Phdr>::iterator it = phdrs_.begin(); it != phdrs_.end(); it++)
@@ -51,7 +181,6 @@ void Loader::loadPage(pointer virtual_address)
         //      bytes_to_load, bin_start_addr, virt_start_addr);
         if(readFromBinary((char *)ArchMemory::getIdentAddressOfPPN(ppn) + virt_offs_on_page, bin_start_addr, bytes_to_load))
         {
-          program_binary_lock_.release();
           PageManager::instance()->freePPN(ppn);
           debug(LOADER, "ERROR! Some parts of the content could not be loaded from the binary.\n");
           Syscall::exit(999);
@@ -64,7 +193,6 @@ void Loader::loadPage(pointer virtual_address)
       }
     }
   }
-  program_binary_lock_.release();
 
   if(!found_page_content)
   {
@@ -72,26 +200,71 @@ void Loader::loadPage(pointer virtual_address)
     debug(LOADER, "Loader::loadPage: ERROR! No section refers to the given address.\n");
     Syscall::exit(666);
   }
+  return ppn;
+}
+
+bool Loader::isReadOnlyPage(pointer virt_page_start_addr)
+{
+  const pointer virt_page_end_addr = virt_page_start_addr + PAGE_SIZE;
+  for(ustl::list<Elf::Phdr>::iterator it = phdrs_.begin(); it != phdrs_.end(); it++)
+  {
+    if((*it).p_vaddr < virt_page_end_addr && (*it).p_vaddr + (*it).p_memsz > virt_page_start_addr &&
+       ((*it).p_flags & Elf::PF_W))
+      return false;
+  }
+  return true;
+}
 
-  bool page_mapped = arch_memory_.mapPage(virt_page_start_addr / PAGE_SIZE, ppn, true);
-  if (!page_mapped)
+void Loader::loadHeapPage(pointer virt_page_start_addr)
+{
+  assert(heap_lock_.isHeldBy(currentThread));
+  if (ArchMemory::HUGE_PAGE_SIZE && loadHeapHugePage(virt_page_start_addr))
+    return;
+  size_t ppn = PageManager::instance()->allocPPN();
+  if (!arch_memory_.mapPage(virt_page_start_addr / PAGE_SIZE, ppn, true))
   {
-    debug(LOADER, "Loader::loadPage: The page has been mapped by someone else.\n");
+    debug(LOADER, "Loader::loadHeapPage: The page has been mapped by someone else.\n");
     PageManager::instance()->freePPN(ppn);
   }
-  debug(LOADER, "Loader::loadPage: Load request for address %p has been successfully finished.\n", (void*)virtual_address);
+  debug(LOADER, "Loader::loadHeapPage: Mapped a zeroed page at %p.\n", (void*)virt_page_start_addr);
+}
+
+bool Loader::loadHeapHugePage(pointer virt_page_start_addr)
+{
+  pointer huge_page_start = virt_page_start_addr & ~(ArchMemory::HUGE_PAGE_SIZE - 1);
+  if (huge_page_start < heap_start_ || huge_page_start + ArchMemory::HUGE_PAGE_SIZE > heap_break_)
+    return false;
+  if (!arch_memory_.mapHugePage(huge_page_start / PAGE_SIZE, true))
+    return false;
+  debug(LOADER, "Loader::loadHeapHugePage: Mapped a zeroed huge page at %p.\n", (void*)huge_page_start);
+  return true;
+}
+
+pointer Loader::setBreak(pointer new_break)
+{
+  MutexLock lock(heap_lock_);
+  // the upper half of the user address space is left to the stacks
+  if (new_break < heap_start_ || new_break >= USER_BREAK / 2)
+    return heap_break_;
+
+  pointer old_end = (heap_break_ + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+  pointer new_end = (new_break + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+  heap_break_ = new_break;
+
+  if (new_end < old_end)
+    arch_memory_.unmapRange(new_end / PAGE_SIZE, (old_end - new_end) / PAGE_SIZE);
+
+  debug(LOADER, "Loader::setBreak: heap is now %p - %p\n", (void*)heap_start_, (void*)heap_break_);
+  return heap_break_;
 }
 
 bool Loader::readFromBinary (char* buffer, l_off_t position, size_t length)
 {
-  assert(program_binary_lock_.isHeldBy(currentThread));
-  VfsSyscall::lseek(fd_, position, SEEK_SET);
-  return VfsSyscall::read(fd_, buffer, length) - (ssize_t)length;
+  return file_->pread(buffer, length, position) != (int32)length;
 }
 
 bool Loader::readHeaders()
 {
-  MutexLock lock(program_binary_lock_);
   hdr_ = new Elf::Ehdr;
 
   if(readFromBinary((char*)hdr_, 0, sizeof(Elf::Ehdr)))
@@ -144,6 +317,13 @@ bool Loader::loadExecutableAndInitProcess()
   if (USERTRACE & OUTPUT_ENABLED)
     loadDebugInfoIfAvailable();
 
+  // the heap starts at the first page above all segments
+  for(ustl::list<Elf::Phdr>::iterator it = phdrs_.begin(); it != phdrs_.end(); it++)
+    heap_start_ = ustl::max(heap_start_, (pointer)((*it).p_vaddr + (*it).p_memsz));
+  heap_start_ = (heap_start_ + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+  heap_break_ = heap_start_;
+  debug(LOADER, "loadExecutableAndInitProcess: heap starts at %p\n", (void*)heap_start_);
+
   return true;
 }
 
@@ -158,8 +338,6 @@ bool Loader::loadDebugInfoIfAvailable()
     return false;
   }
 
-  MutexLock lock(program_binary_lock_);
-
   ustl::vector<Elf::Shdr> section_headers;
   section_headers.resize(hdr_->e_shnum);
   if (readFromBinary(reinterpret_cast<char*>(&section_headers[0]), hdr_->e_shoff, hdr_->e_shnum*sizeof(Elf::Shdr)))
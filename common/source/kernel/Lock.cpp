@@ -12,9 +12,7 @@ Lock::Lock(const char *name) :
   held_by_(0),
   next_lock_on_holding_list_(0),
   last_accessed_at_(0),
-  name_(name ? name : ""),
-  waiters_list_(0),
-  waiters_list_lock_(0)
+  name_(name ? name : "")
 {
 }
 
@@ -23,16 +21,14 @@ Lock::~Lock()
   if(unlikely(system_state != RUNNING))
     return;
   // copy the pointers to the stack because it may be reseted before printing the element out.
-  Thread* waiter = waiters_list_;
+  Thread* waiter = waiters_.first();
   Thread* held_by = held_by_;
   if(waiter)
   {
     debug(LOCK, "ERROR: Lock::~Lock %s (%p): At least thread %p is still waiting on this lock,\n"
         "currentThread is: %p, the thread holding this lock is: %p\n",
         name_, this, waiter, currentThread, held_by);
-    lockWaitersList();
     printWaitersList();
-    // The waiters list does not has to be unlocked here, because the kernel is going to die.
     assert(false);
   }
   if(held_by)
@@ -44,9 +40,9 @@ Lock::~Lock()
 
 void Lock::printWaitersList()
 {
-  debug(LOCK, "Threads waiting for lock %s (%p), newest thread waiting first:\n", name_, this);
+  debug(LOCK, "Threads waiting for lock %s (%p), longest waiting thread first:\n", name_, this);
   size_t count = 0;
-  for(Thread* thread = waiters_list_; thread != 0; thread = thread->next_thread_in_lock_waiters_list_)
+  for(Thread* thread = waiters_.first(); thread != 0; thread = thread->next_thread_in_wait_queue_)
   {
     kprintfd("%zu: %s (%p)\n", ++count, thread->getName(), thread);
   }
@@ -141,7 +137,7 @@ void Lock::checkCurrentThreadStillWaitingOnAnotherLock()
   if(currentThread->lock_waiting_on_ != 0)
   {
     debug(LOCK, "ERROR: Lock: Thread %s (%p) is trying to lock %s (%p), eventhough is already waiting on lock %s (%p).\n"
-          "You shouldn't use Scheduler::wake() with a thread sleeping on a lock!\n",
+          "You shouldn't set a thread sleeping on a lock to Running by hand!\n",
           currentThread->getName(), currentThread, name_, this,
           currentThread->lock_waiting_on_->getName(), currentThread->lock_waiting_on_);
     if(kernel_debug_info)
@@ -178,8 +174,8 @@ void Lock::checkForCircularDeadLock(Thread* thread_waiting, Lock* start)
       printOutCircularDeadLock(thread_waiting);
       assert(false);
     }
-    for(Thread* thread_waiting = lock->waiters_list_; thread_waiting != 0;
-        thread_waiting = thread_waiting->next_thread_in_lock_waiters_list_)
+    for(Thread* thread_waiting = lock->waiters_.first(); thread_waiting != 0;
+        thread_waiting = thread_waiting->next_thread_in_wait_queue_)
     {
       // The method has to be called recursively, so it is possible to check indirect
       // deadlocks. The recursive approach may be slower than other checking methods,
@@ -230,92 +226,6 @@ void Lock::checkInterrupts(const char* method)
   }
 }
 
-void Lock::lockWaitersList()
-{
-  // The waiters list lock is a simple spinlock.
-  // Just wait until the holding thread is releasing the lock,
-  // and acquire it. These steps have to be atomic.
-  while(ArchThreads::testSetLock(waiters_list_lock_, 1))
-  {
-    Scheduler::instance()->yield();
-  }
-}
-
-void Lock::unlockWaitersList()
-{
-  waiters_list_lock_ = 0;
-}
-
-void Lock::pushFrontCurrentThreadToWaitersList()
-{
-  assert(currentThread);
-  assert(waitersListIsLocked());
-  currentThread->next_thread_in_lock_waiters_list_ = waiters_list_;
-  // the following set has to be atomic
-  // waiters_list_ = currentThread;
-  ArchThreads::atomic_set((pointer&)(waiters_list_), (pointer)(currentThread));
-}
-
-Thread* Lock::popBackThreadFromWaitersList()
-{
-  assert(waitersListIsLocked());
-  Thread* thread = 0;
-  if(waiters_list_ == 0)
-  {
-    // the waiters list is empty
-  }
-  else if(waiters_list_->next_thread_in_lock_waiters_list_ == 0)
-  {
-    // this thread is the only one in the waiters list
-    thread = waiters_list_;
-    ArchThreads::atomic_set((pointer&)(waiters_list_), (pointer)(0));
-    waiters_list_ = 0;
-  }
-  else
-  {
-    // there is more than one thread in the waiters list
-    // search for the thread before the last thread in the list
-    Thread* previos;
-    for(previos = waiters_list_; previos->next_thread_in_lock_waiters_list_->next_thread_in_lock_waiters_list_ != 0;
-        previos = previos->next_thread_in_lock_waiters_list_);
-
-    thread = previos->next_thread_in_lock_waiters_list_;
-    // remove the last element
-    ArchThreads::atomic_set((pointer&)(previos->next_thread_in_lock_waiters_list_), (pointer)(0));
-  }
-  return thread;
-}
-
-void Lock::removeCurrentThreadFromWaitersList()
-{
-  if(!currentThread)
-    return;
-  assert(waitersListIsLocked());
-  assert(waiters_list_);
-  if(currentThread == waiters_list_)
-  {
-    // the current thread is the first element
-    ArchThreads::atomic_set((pointer&)(waiters_list_), (pointer)(currentThread->next_thread_in_lock_waiters_list_));
-  }
-  else
-  {
-
-    for(Thread* thread = waiters_list_; thread->next_thread_in_lock_waiters_list_ != 0;
-        thread = thread->next_thread_in_lock_waiters_list_)
-    {
-      if(thread->next_thread_in_lock_waiters_list_ == currentThread)
-      {
-
-        ArchThreads::atomic_set((pointer&)(thread->next_thread_in_lock_waiters_list_),
-                                (pointer)(currentThread->next_thread_in_lock_waiters_list_));
-        break;
-      }
-    }
-  }
-  ArchThreads::atomic_set((pointer&)(currentThread->next_thread_in_lock_waiters_list_ ), (pointer)0);
-  return;
-}
-
 void Lock::checkInvalidRelease(const char* method)
 {
   if(unlikely(held_by_ != currentThread))
@@ -331,13 +241,3 @@ void Lock::checkInvalidRelease(const char* method)
     assert(false);
   }
 }
-
-void Lock::sleepAndRelease ()
-{
-  currentThread->lock_waiting_on_ = this;
-  pushFrontCurrentThreadToWaitersList();
-  unlockWaitersList();
-  // we can risk to go to sleep after the list has been unlocked,
-  // because the thread waking this thread waits until it goes to sleep
-  Scheduler::instance()->sleep();
-}
@@ -62,17 +62,18 @@ void Mutex::acquire(pointer called_by)
 //  }
   while(ArchThreads::testSetLock(mutex_, 1))
   {
-    checkCurrentThreadStillWaitingOnAnotherLock();
-    lockWaitersList();
+    // check for deadlocks, interrupts...
+    doChecksBeforeWaiting();
+    currentThread->lock_waiting_on_ = this;
+    waiters_.prepareToWait();
     // Here we have to check for the lock again, in case some one released it in between, we might sleep forever.
     if(!ArchThreads::testSetLock(mutex_, 1))
     {
-      unlockWaitersList();
+      waiters_.finishWait();
+      currentThread->lock_waiting_on_ = 0;
       break;
     }
-    // check for deadlocks, interrupts...
-    doChecksBeforeWaiting();
-    sleepAndRelease();
+    waiters_.sleep();
     // We have been waken up again.
     currentThread->lock_waiting_on_ = 0;
   }
@@ -100,18 +101,13 @@ void Mutex::release(pointer called_by)
   removeFromCurrentThreadHoldingList();
   last_accessed_at_ = called_by;
   held_by_ = 0;
-  mutex_ = 0;
+  __atomic_store_n(&mutex_, 0, __ATOMIC_RELEASE);
   // Wake up a sleeping thread. It is okay that the mutex is not held by the current thread any longer.
   // In worst case a new thread is woken up. Otherwise (first wake up, then release),
   // it could happen that a thread is going to sleep after the this one is trying to wake up one.
   // Then we are dead... (the thread may sleep forever, in case no other thread is going to acquire this mutex again).
-  lockWaitersList();
-  Thread* thread_to_be_woken_up = popBackThreadFromWaitersList();
-  unlockWaitersList();
-  if(thread_to_be_woken_up)
-  {
-    Scheduler::instance()->wake(thread_to_be_woken_up);
-  }
+  // Waking up never waits for the thread, it already went to sleep in WaitQueue::prepareToWait.
+  waiters_.wakeOne();
 }
 
 bool Mutex::isFree()
@@ -85,10 +85,10 @@ size_t ProcessRegistry::processCount()
   return progs_running_;
 }
 
-void ProcessRegistry::createProcess(const char* path)
+void ProcessRegistry::createProcess(const char* path, LoadMode load_mode)
 {
   debug(PROCESS_REG, "create process %s\n", path);
-  Thread* process = new UserProcess(path, new FileSystemInfo(*working_dir_));
+  Thread* process = new UserProcess(path, new FileSystemInfo(*working_dir_), 0, load_mode);
   debug(PROCESS_REG, "created userprocess %s\n", path);
   Scheduler::instance()->addNewThread(process);
   debug(PROCESS_REG, "added thread %s\n", path);
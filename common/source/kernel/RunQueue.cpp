@@ -0,0 +1,79 @@
+#include "RunQueue.h"
+#include "Thread.h"
+#include "assert.h"
+
+const size_t RunQueue::NUM_LEVELS;
+const size_t RunQueue::NOT_QUEUED;
+
+RunQueue::RunQueue() : non_empty_levels_(0), size_(0)
+{
+  for (size_t i = 0; i < NUM_LEVELS; ++i)
+  {
+    heads_[i] = 0;
+    tails_[i] = 0;
+  }
+}
+
+void RunQueue::enqueue(Thread* thread, size_t level)
+{
+  assert(thread && level < NUM_LEVELS);
+  assert(!isQueued(thread) && "Thread is already in the run queue");
+
+  thread->run_queue_level_ = level;
+  thread->next_in_run_queue_ = 0;
+  thread->prev_in_run_queue_ = tails_[level];
+  if (tails_[level])
+    tails_[level]->next_in_run_queue_ = thread;
+  else
+    heads_[level] = thread;
+  tails_[level] = thread;
+
+  non_empty_levels_ |= (1U << level);
+  ++size_;
+}
+
+void RunQueue::remove(Thread* thread)
+{
+  assert(thread && isQueued(thread));
+  size_t level = thread->run_queue_level_;
+
+  if (thread->prev_in_run_queue_)
+    thread->prev_in_run_queue_->next_in_run_queue_ = thread->next_in_run_queue_;
+  else
+    heads_[level] = thread->next_in_run_queue_;
+  if (thread->next_in_run_queue_)
+    thread->next_in_run_queue_->prev_in_run_queue_ = thread->prev_in_run_queue_;
+  else
+    tails_[level] = thread->prev_in_run_queue_;
+
+  if (!heads_[level])
+    non_empty_levels_ &= ~(1U << level);
+
+  thread->next_in_run_queue_ = 0;
+  thread->prev_in_run_queue_ = 0;
+  thread->run_queue_level_ = NOT_QUEUED;
+  --size_;
+}
+
+Thread* RunQueue::dequeue(size_t level)
+{
+  assert(level < NUM_LEVELS && heads_[level]);
+  Thread* thread = heads_[level];
+  remove(thread);
+  return thread;
+}
+
+uint32 RunQueue::nonEmptyLevels() const
+{
+  return non_empty_levels_;
+}
+
+bool RunQueue::isQueued(Thread* thread) const
+{
+  return thread->run_queue_level_ != NOT_QUEUED;
+}
+
+size_t RunQueue::size() const
+{
+  return size_;
+}
@@ -14,11 +14,12 @@
 #include "ustring.h"
 #include "Lock.h"
 
-ArchThreadRegisters *currentThreadRegisters;
-Thread *currentThread;
-
 Scheduler *Scheduler::instance_ = 0;
 
+const size_t Scheduler::PRIORITY_LEVELS;
+const size_t Scheduler::DEFAULT_PRIORITY;
+const uint64 Scheduler::TIME_SLICE_NS;
+
 Scheduler *Scheduler::instance()
 {
   if (unlikely(!instance_))
@@ -28,8 +29,15 @@ Scheduler *Scheduler::instance()
 
 Scheduler::Scheduler()
 {
-  block_scheduling_ = 0;
+  __atomic_store_n(&block_scheduling_, 0, __ATOMIC_RELEASE);
   ticks_ = 0;
+  tickless_ = false;
+  dead_threads_pending_ = false;
+  last_schedule_ns_ = 0;
+  for (size_t i = 0; i < PRIORITY_LEVELS; ++i)
+    normal_credits_[i] = 0;
+  setScheduling(&cleanup_thread_, NormalClass, PRIORITY_LEVELS - 1);
+  setScheduling(&idle_thread_, IdleClass, 0);
   addNewThread(&cleanup_thread_);
   addNewThread(&idle_thread_);
 }
@@ -40,22 +48,35 @@ uint32 Scheduler::schedule()
   if (block_scheduling_ != 0)
   {
     debug(SCHEDULER, "schedule: currently blocked\n");
+    if (tickless_)
+      ArchInterrupts::setOneShotTimer(TIME_SLICE_NS); // try again later
     return 0;
   }
 
-  auto it = threads_.begin();
-  for(; it != threads_.end(); ++it)
-  {
-    if((*it)->schedulable())
-    {
-      currentThread = *it;
-      break;
-    }
-  }
+  uint64 now = ArchCommon::getMonotonicTimeNs();
+  if (currentThread)
+    currentThread->cpu_time_ns_ += now - last_schedule_ns_;
+  last_schedule_ns_ = now;
 
-  assert(it != threads_.end() && "No schedulable thread found");
+  bool interrupts_enabled = timer_wheel_lock_.acquire();
+  timer_wheel_.advanceTo(now);
+  timer_wheel_lock_.release(interrupts_enabled);
+  kprintf_wake_flush_thread();
 
-  ustl::rotate(threads_.begin(), it + 1, threads_.end()); // no new/delete here - important because interrupts are disabled
+  interrupts_enabled = run_queue_lock_.acquire();
+  if (currentThread && currentThread->schedulable() && !run_queue_.isQueued(currentThread))
+    run_queue_.enqueue(currentThread, runQueueLevel(currentThread));
+
+  Thread* next;
+  while ((next = dequeueNextThread()) && !next->schedulable())
+    ; // went to sleep or died since it was enqueued, it will be requeued on wake up
+  run_queue_lock_.release(interrupts_enabled);
+
+  assert(next && "No schedulable thread found");
+  ArchMulticore::setCurrentThread(next);
+
+  if (tickless_)
+    programTimer(now);
 
   //debug(SCHEDULER, "Scheduler::schedule: new currentThread is %p %s, switch_to_userspace: %d\n", currentThread, currentThread->getName(), currentThread->switch_to_userspace_);
 
@@ -63,11 +84,11 @@ uint32 Scheduler::schedule()
 
   if (currentThread->switch_to_userspace_)
   {
-    currentThreadRegisters = currentThread->user_registers_;
+    ArchMulticore::setCurrentThreadRegisters(currentThread->user_registers_);
   }
   else
   {
-    currentThreadRegisters = currentThread->kernel_registers_;
+    ArchMulticore::setCurrentThreadRegisters(currentThread->kernel_registers_);
     ret = 0;
   }
 
@@ -84,22 +105,116 @@ void Scheduler::addNewThread(Thread *thread)
   lockScheduling();
   KernelMemoryManager::instance()->getKMMLock().release();
   threads_.push_back(thread);
+  makeRunnable(thread);
   unlockScheduling();
 }
 
-void Scheduler::sleep()
+void Scheduler::addDeadThread(Thread *thread)
+{
+  assert(thread && thread->getState() == ToBeDestroyed);
+  KernelMemoryManager::instance()->getKMMLock().acquire();
+  lockScheduling();
+  KernelMemoryManager::instance()->getKMMLock().release();
+  threads_.push_back(thread);
+  unlockScheduling();
+  wakeCleanupThread();
+}
+
+void Scheduler::makeRunnable(Thread *thread)
+{
+  bool interrupts_enabled = run_queue_lock_.acquire();
+  if (thread != currentThread && thread->schedulable() && !run_queue_.isQueued(thread))
+    run_queue_.enqueue(thread, runQueueLevel(thread));
+  run_queue_lock_.release(interrupts_enabled);
+}
+
+void Scheduler::setScheduling(Thread *thread, SchedulingClass sched_class, size_t priority)
+{
+  assert(sched_class <= IdleClass && priority < PRIORITY_LEVELS);
+  bool interrupts_enabled = run_queue_lock_.acquire();
+  bool queued = run_queue_.isQueued(thread);
+  if (queued)
+    run_queue_.remove(thread);
+  thread->scheduling_class_ = sched_class;
+  thread->priority_ = priority;
+  if (queued)
+    run_queue_.enqueue(thread, runQueueLevel(thread));
+  run_queue_lock_.release(interrupts_enabled);
+}
+
+size_t Scheduler::runQueueLevel(Thread *thread)
+{
+  return thread->scheduling_class_ * PRIORITY_LEVELS + thread->priority_;
+}
+
+Thread* Scheduler::dequeueNextThread()
+{
+  uint32 levels = run_queue_.nonEmptyLevels();
+  if (!levels)
+    return 0;
+
+  size_t level = __builtin_ctz(levels);
+  if (level / PRIORITY_LEVELS != NormalClass)
+    return run_queue_.dequeue(level);
+
+  uint32 normal_levels = (levels >> (NormalClass * PRIORITY_LEVELS)) & ((1U << PRIORITY_LEVELS) - 1);
+  while (true)
+  {
+    for (size_t priority = 0; priority < PRIORITY_LEVELS; ++priority)
+    {
+      if ((normal_levels & (1U << priority)) && normal_credits_[priority])
+      {
+        --normal_credits_[priority];
+        return run_queue_.dequeue(NormalClass * PRIORITY_LEVELS + priority);
+      }
+    }
+    // every runnable priority used up its share, start the next round
+    for (size_t priority = 0; priority < PRIORITY_LEVELS; ++priority)
+      normal_credits_[priority] = PRIORITY_LEVELS - priority;
+  }
+}
+
+void Scheduler::programTimer(uint64 now_ns)
+{
+  bool interrupts_enabled = timer_wheel_lock_.acquire();
+  uint64 deadline = timer_wheel_.nextEventNs();
+  timer_wheel_lock_.release(interrupts_enabled);
+  // the idle thread gets interrupted by whatever wakes up another thread, it needs no time slice
+  if (currentThread != &idle_thread_ && now_ns + TIME_SLICE_NS < deadline)
+    deadline = now_ns + TIME_SLICE_NS;
+
+  if (deadline == -1ULL)
+    ArchInterrupts::setOneShotTimer(0);
+  else
+    ArchInterrupts::setOneShotTimer(deadline > now_ns ? deadline - now_ns : 1);
+}
+
+void Scheduler::sleepUntil(uint64 wakeup_ns)
 {
+  assert(ArchInterrupts::testIFSet() && "Scheduler::sleepUntil: interrupts have to be enabled");
+  ArchInterrupts::disableInterrupts();
   currentThread->setState(Sleeping);
-  assert(block_scheduling_ == 0);
+  yieldUntil(wakeup_ns);
+}
+
+void Scheduler::yieldUntil(uint64 wakeup_ns)
+{
+  assert(!ArchInterrupts::testIFSet() && currentThread->getState() == Sleeping);
+  timer_wheel_lock_.acquire();
+  timer_wheel_.add(currentThread, wakeup_ns);
+  timer_wheel_lock_.release(true);
   yield();
+  // in case someone else woke us up before the timer expired
+  bool interrupts_enabled = timer_wheel_lock_.acquire();
+  timer_wheel_.remove(currentThread);
+  timer_wheel_lock_.release(interrupts_enabled);
 }
 
-void Scheduler::wake(Thread* thread_to_wake)
+void Scheduler::sleep()
 {
-  // wait until the thread is sleeping
-  while(thread_to_wake->getState() != Sleeping)
-    yield();
-  thread_to_wake->setState(Running);
+  currentThread->setState(Sleeping);
+  assert(block_scheduling_ == 0);
+  yield();
 }
 
 void Scheduler::yield()
@@ -132,12 +247,22 @@ void Scheduler::cleanupDeadThreads()
     Thread* tmp = threads_[i];
     if (tmp->getState() == ToBeDestroyed)
     {
+      bool interrupts_enabled = run_queue_lock_.acquire();
+      if (run_queue_.isQueued(tmp))
+        run_queue_.remove(tmp);
+      run_queue_lock_.release(interrupts_enabled);
+      interrupts_enabled = timer_wheel_lock_.acquire();
+      timer_wheel_.remove(tmp);
+      timer_wheel_lock_.release(interrupts_enabled);
       destroy_list[thread_count++] = tmp;
       threads_.erase(threads_.begin() + i); // Note: erase will not realloc!
       --i;
     }
     if (thread_count >= thread_count_max)
+    {
+      dead_threads_pending_ = true; // there might be more, come back right after deleting these
       break;
+    }
   }
   unlockScheduling();
   if (thread_count > 0)
@@ -150,13 +275,32 @@ void Scheduler::cleanupDeadThreads()
   }
 }
 
+void Scheduler::waitForDeadThreads()
+{
+  dead_threads_.prepareToWait();
+  if (dead_threads_pending_)
+    dead_threads_.finishWait();
+  else
+    dead_threads_.sleep();
+  dead_threads_pending_ = false;
+}
+
+void Scheduler::wakeCleanupThread()
+{
+  dead_threads_pending_ = true;
+  dead_threads_.wakeOne();
+}
+
 void Scheduler::printThreadList()
 {
   lockScheduling();
-  debug(SCHEDULER, "Scheduler::printThreadList: %zd Threads in List\n", threads_.size());
+  size_t runnable = run_queue_.size();
+  debug(SCHEDULER, "Scheduler::printThreadList: %zd Threads in List, %zd runnable, %zd sleeping on a timer\n",
+        threads_.size(), runnable, timer_wheel_.size());
   for (size_t c = 0; c < threads_.size(); ++c)
-    debug(SCHEDULER, "Scheduler::printThreadList: threads_[%zd]: %p  %zd:%s     [%s]\n", c, threads_[c],
-          threads_[c]->getTID(), threads_[c]->getName(), Thread::threadStatePrintable[threads_[c]->state_]);
+    debug(SCHEDULER, "Scheduler::printThreadList: threads_[%zd]: %p  %zd:%s     [%s] [%s/%zd]\n", c, threads_[c],
+          threads_[c]->getTID(), threads_[c]->getName(), Thread::threadStatePrintable[threads_[c]->state_],
+          Thread::schedulingClassPrintable[threads_[c]->scheduling_class_], threads_[c]->priority_);
   unlockScheduling();
 }
 
@@ -168,7 +312,7 @@ void Scheduler::lockScheduling() //not as severe as stopping Interrupts
 
 void Scheduler::unlockScheduling()
 {
-  block_scheduling_ = 0;
+  __atomic_store_n(&block_scheduling_, 0, __ATOMIC_RELEASE);
 }
 
 bool Scheduler::isSchedulingEnabled()
@@ -194,6 +338,13 @@ void Scheduler::incTicks()
   ++ticks_;
 }
 
+void Scheduler::enableTickless()
+{
+  assert(!ArchInterrupts::testIFSet());
+  tickless_ = ArchInterrupts::enableOneShotTimer();
+  debug(SCHEDULER, "enableTickless: %s\n", tickless_ ? "one-shot timer enabled" : "no one-shot timer, staying periodic");
+}
+
 void Scheduler::printStackTraces()
 {
   lockScheduling();
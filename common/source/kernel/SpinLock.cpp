@@ -67,9 +67,7 @@ void SpinLock::acquire(pointer called_by)
     doChecksBeforeWaiting();
 
     currentThread->lock_waiting_on_ = this;
-    lockWaitersList();
-    pushFrontCurrentThreadToWaitersList();
-    unlockWaitersList();
+    waiters_.add(currentThread);
 
     // here comes the basic spinlock
     while(ArchThreads::testSetLock(lock_, 1))
@@ -78,9 +76,7 @@ void SpinLock::acquire(pointer called_by)
       Scheduler::instance()->yield();
     }
     // Now we managed to acquire the spinlock. Remove the current thread from the waiters list.
-    lockWaitersList();
-    removeCurrentThreadFromWaitersList();
-    unlockWaitersList();
+    waiters_.remove(currentThread);
     currentThread->lock_waiting_on_ = 0;
   }
   // The current thread is now holding the spinlock
@@ -116,6 +112,7 @@ void SpinLock::release(pointer called_by)
   removeFromCurrentThreadHoldingList();
   last_accessed_at_ = called_by;
   held_by_ = 0;
-  lock_ = 0;
+  // release semantics, so whatever was written while holding the lock is visible to the next holder on any cpu
+  __atomic_store_n(&lock_, 0, __ATOMIC_RELEASE);
 }
 
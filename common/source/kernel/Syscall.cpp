@@ -7,6 +7,9 @@
 #include "UserProcess.h"
 #include "ProcessRegistry.h"
 #include "File.h"
+#include "ArchCommon.h"
+#include "Loader.h"
+#include "PageManager.h"
 
 size_t Syscall::syscallException(size_t syscall_number, size_t arg1, size_t arg2, size_t arg3, size_t arg4, size_t arg5)
 {
@@ -24,11 +27,14 @@ size_t Syscall::syscallException(size_t syscall_number, size_t arg1, size_t arg2
       Scheduler::instance()->yield();
       break;
     case sc_createprocess:
-      return_value = createprocess(arg1, arg2);
+      return_value = createprocess(arg1, arg2, arg3);
       break;
     case sc_exit:
       exit(arg1);
       break;
+    case sc_fork:
+      return_value = fork();
+      break;
     case sc_write:
       return_value = write(arg1, arg2, arg3);
       break;
@@ -41,12 +47,27 @@ size_t Syscall::syscallException(size_t syscall_number, size_t arg1, size_t arg2
     case sc_close:
       return_value = close(arg1);
       break;
+    case sc_unlink:
+      return_value = unlink(arg1);
+      break;
     case sc_outline:
       outline(arg1, arg2);
       break;
     case sc_trace:
       trace();
       break;
+    case sc_sched_setclass:
+      return_value = sched_setclass(arg1, arg2);
+      break;
+    case sc_nanosleep:
+      return_value = nanosleep(arg1, arg2);
+      break;
+    case sc_clock_gettime:
+      return_value = clock_gettime(arg1, arg2);
+      break;
+    case sc_brk:
+      return_value = brk(arg1);
+      break;
     case sc_pseudols:
       VfsSyscall::readdir((const char*) arg1);
       break;
@@ -121,6 +142,15 @@ size_t Syscall::open(size_t path, size_t flags)
   return VfsSyscall::open((char*) path, flags);
 }
 
+size_t Syscall::unlink(size_t path)
+{
+  if (path >= USER_BREAK)
+  {
+    return -1U;
+  }
+  return VfsSyscall::rm((char*) path);
+}
+
 void Syscall::outline(size_t port, pointer text)
 {
   //WARNING: this might fail if Kernel PageFaults are not handled
@@ -134,17 +164,17 @@ void Syscall::outline(size_t port, pointer text)
   }
 }
 
-size_t Syscall::createprocess(size_t path, size_t sleep)
+size_t Syscall::createprocess(size_t path, size_t sleep, size_t load_mode)
 {
   // THIS METHOD IS FOR TESTING PURPOSES ONLY!
   // AVOID USING IT AS SOON AS YOU HAVE AN ALTERNATIVE!
 
   // parameter check begin
-  if (path >= USER_BREAK)
+  if (path >= USER_BREAK || load_mode > PrefaultLoad)
   {
     return -1U;
   }
-  debug(SYSCALL, "Syscall::createprocess: path:%s sleep:%zd\n", (char*) path, sleep);
+  debug(SYSCALL, "Syscall::createprocess: path:%s sleep:%zd load mode:%zd\n", (char*) path, sleep, load_mode);
   ssize_t fd = VfsSyscall::open((const char*) path, O_RDONLY);
   if (fd == -1)
   {
@@ -154,7 +184,7 @@ size_t Syscall::createprocess(size_t path, size_t sleep)
   // parameter check end
 
   size_t process_count = ProcessRegistry::instance()->processCount();
-  ProcessRegistry::instance()->createProcess((const char*) path);
+  ProcessRegistry::instance()->createProcess((const char*) path, (LoadMode) load_mode);
   if (sleep)
   {
     while (ProcessRegistry::instance()->processCount() > process_count) // please note that this will fail ;)
@@ -165,8 +195,97 @@ size_t Syscall::createprocess(size_t path, size_t sleep)
   return 0;
 }
 
+size_t Syscall::fork()
+{
+  // every thread with a loader is a user process
+  assert(currentThread->loader_);
+  UserProcess* child = new UserProcess(*(UserProcess*) currentThread);
+  if (!child->loader_)
+  {
+    debug(SYSCALL, "Syscall::fork: %s could not be forked\n", currentThread->getName());
+    Scheduler::instance()->addDeadThread(child);
+    return -1U;
+  }
+  size_t child_tid = child->getTID();
+  Scheduler::instance()->addNewThread(child);
+  debug(SYSCALL, "Syscall::fork: %s forked, child %zd, %zu pages copied on write so far\n", currentThread->getName(),
+        child_tid, PageManager::instance()->getNumCopiedFrames());
+  return child_tid;
+}
+
 void Syscall::trace()
 {
   currentThread->printBacktrace();
 }
 
+
+size_t Syscall::sched_setclass(size_t sched_class, size_t priority)
+{
+  if ((sched_class > IdleClass) || (priority >= Scheduler::PRIORITY_LEVELS))
+    return -1U;
+  if (sched_class == RealtimeClass)
+  {
+    // a busy realtime thread would starve every normal kernel thread (kprintf flushing, cleanup, ...)
+    debug(SYSCALL, "Syscall::sched_setclass: the realtime class is reserved for kernel threads\n");
+    return -1U;
+  }
+  debug(SYSCALL, "Syscall::sched_setclass: thread %s now in class %s with priority %zd\n", currentThread->getName(),
+        Thread::schedulingClassPrintable[sched_class], priority);
+  Scheduler::instance()->setScheduling(currentThread, (SchedulingClass) sched_class, priority);
+  return 0;
+}
+
+size_t Syscall::nanosleep(size_t request, size_t remaining)
+{
+  if (!request || (request >= USER_BREAK) || (request + sizeof(UserTimespec) > USER_BREAK) ||
+      (remaining >= USER_BREAK) || (remaining + sizeof(UserTimespec) > USER_BREAK))
+  {
+    return -1U;
+  }
+  UserTimespec* req = (UserTimespec*) request;
+  if ((req->tv_sec < 0) || (req->tv_nsec < 0) || (req->tv_nsec >= 1000000000L))
+    return -1U;
+
+  uint64 now = ArchCommon::getMonotonicTimeNs();
+  // a deadline beyond the range of the clock would wrap into the past, sleep as long as possible instead
+  uint64 wakeup_ns = -1ULL;
+  if ((uint64)req->tv_sec < (-1ULL - now) / 1000000000ULL)
+    wakeup_ns = now + (uint64)req->tv_sec * 1000000000ULL + req->tv_nsec;
+  Scheduler::instance()->sleepUntil(wakeup_ns);
+
+  if (remaining)
+  {
+    // nothing can interrupt the sleep, so there is never any time left
+    UserTimespec* rem = (UserTimespec*) remaining;
+    rem->tv_sec = 0;
+    rem->tv_nsec = 0;
+  }
+  return 0;
+}
+
+size_t Syscall::brk(size_t end_data_segment)
+{
+  // like the linux system call this returns the resulting break, the libc builds brk and sbrk on top of it
+  if (end_data_segment >= USER_BREAK)
+    end_data_segment = 0;
+  return currentThread->loader_->setBreak(end_data_segment);
+}
+
+size_t Syscall::clock_gettime(size_t clock_id, size_t time)
+{
+  if ((time >= USER_BREAK) || (time + sizeof(UserTimespec) > USER_BREAK))
+    return -1U;
+
+  uint64 ns;
+  if (clock_id == CLOCK_MONOTONIC)
+    ns = ArchCommon::getMonotonicTimeNs();
+  else if (clock_id == CLOCK_THREAD_CPUTIME_ID)
+    ns = currentThread->getCpuTimeNs();
+  else
+    return -1U;
+
+  UserTimespec* tp = (UserTimespec*) time;
+  tp->tv_sec = ns / 1000000000ULL;
+  tp->tv_nsec = ns % 1000000000ULL;
+  return 0;
+}
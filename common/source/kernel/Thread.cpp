@@ -9,17 +9,45 @@
 #include "Terminal.h"
 #include "backtrace.h"
 #include "KernelMemoryManager.h"
+#include "KmemCache.h"
 #include "Stabs2DebugInfo.h"
+#include "RunQueue.h"
+#include "TimerWheel.h"
 
 #define BACKTRACE_MAX_FRAMES 20
 
 
 
+/**
+ * big enough for the kernel threads and UserProcess, larger subclasses use the kernel heap
+ */
+static KmemCache thread_cache("Thread", sizeof(Thread) + 256);
+
+void* Thread::operator new(size_t size)
+{
+  if (size <= thread_cache.objectSize())
+    return thread_cache.allocate(size);
+  return ::operator new(size);
+}
+
+void Thread::operator delete(void* address, size_t size)
+{
+  if (size <= thread_cache.objectSize())
+    thread_cache.free(address);
+  else
+    ::operator delete(address);
+}
+
 const char* Thread::threadStatePrintable[3] =
 {
 "Running", "Sleeping", "ToBeDestroyed"
 };
 
+const char* Thread::schedulingClassPrintable[3] =
+{
+"Realtime", "Normal", "Idle"
+};
+
 extern "C" void threadStartHack()
 {
   currentThread->setTerminal(main_console->getActiveTerminal());
@@ -29,11 +57,20 @@ extern "C" void threadStartHack()
   while(1);
 }
 
+/**
+ * the number of threads created so far, the TIDs start at 1 so fork never returns 0 to the parent
+ */
+static int64 threads_created = 0;
+
 Thread::Thread(FileSystemInfo *working_dir, ustl::string name, Thread::TYPE type) :
     kernel_registers_(0), user_registers_(0), switch_to_userspace_(type == Thread::USER_THREAD ? 1 : 0), loader_(0),
-    next_thread_in_lock_waiters_list_(0), lock_waiting_on_(0), holding_lock_list_(0), state_(Running), tid_(0),
+    next_thread_in_wait_queue_(0), lock_waiting_on_(0), holding_lock_list_(0), next_in_run_queue_(0),
+    prev_in_run_queue_(0), run_queue_level_(RunQueue::NOT_QUEUED), scheduling_class_(NormalClass),
+    priority_(Scheduler::DEFAULT_PRIORITY), next_in_timer_wheel_(0), prev_in_timer_wheel_(0),
+    timer_wheel_slot_(TimerWheel::NOT_QUEUED), timer_wheel_expiry_(0), cpu_time_ns_(0), state_(Running), tid_(0),
     my_terminal_(0), working_dir_(working_dir), name_(name)
 {
+  tid_ = ArchThreads::atomic_add(threads_created, 1) + 1;
   debug(THREAD, "Thread ctor, this is %p, stack is %p, fs_info ptr: %p\n", this, kernel_stack_, working_dir_);
   ArchThreads::createKernelRegisters(kernel_registers_, (void*) (type == Thread::USER_THREAD ? 0 : threadStartHack), getKernelStackStartPointer());
   kernel_stack_[2047] = STACK_CANARY;
@@ -120,6 +157,16 @@ void Thread::setWorkingDirInfo(FileSystemInfo* working_dir)
   working_dir_ = working_dir;
 }
 
+FileDescriptorTable* Thread::getFdTable()
+{
+  return &fd_table_;
+}
+
+FileDescriptorTable* getFdTable()
+{
+  return currentThread->getFdTable();
+}
+
 extern Stabs2DebugInfo const *kernel_debug_info;
 
 void Thread::printBacktrace(bool use_stored_registers)
@@ -183,10 +230,31 @@ ThreadState Thread::getState() const
   return state_;
 }
 
+SchedulingClass Thread::getSchedulingClass() const
+{
+  return scheduling_class_;
+}
+
+size_t Thread::getPriority() const
+{
+  return priority_;
+}
+
+uint64 Thread::getCpuTimeNs() const
+{
+  return cpu_time_ns_;
+}
+
 void Thread::setState(ThreadState new_state)
 {
   assert(!((state_ == ToBeDestroyed) && (new_state != ToBeDestroyed)) && "Tried to change thread state when thread was already set to be destroyed");
   assert(!((new_state == Sleeping) && (currentThread != this)) && "Setting other threads to sleep is not thread-safe");
 
+  ThreadState old_state = state_;
   state_ = new_state;
+
+  if ((new_state == Running) && (old_state != Running))
+    Scheduler::instance()->makeRunnable(this);
+  else if ((new_state == ToBeDestroyed) && (old_state != ToBeDestroyed))
+    Scheduler::instance()->wakeCleanupThread();
 }
@@ -0,0 +1,186 @@
+#include "TimerWheel.h"
+#include "Thread.h"
+#include "assert.h"
+#include "bitops.h"
+
+const size_t TimerWheel::RESOLUTION_SHIFT;
+const size_t TimerWheel::SLOT_BITS;
+const size_t TimerWheel::SLOTS;
+const size_t TimerWheel::LEVELS;
+const size_t TimerWheel::NOT_QUEUED;
+
+TimerWheel::TimerWheel() : current_tick_(0), size_(0)
+{
+  for (size_t level = 0; level < LEVELS; ++level)
+  {
+    non_empty_slots_[level] = 0;
+    for (size_t slot = 0; slot < SLOTS; ++slot)
+      slots_[level][slot] = 0;
+  }
+}
+
+void TimerWheel::add(Thread* thread, uint64 expiry_ns)
+{
+  assert(thread && !isQueued(thread) && "Thread is already in the timer wheel");
+  uint64 expiry = nsToTicks(expiry_ns + ticksToNs(1) - 1); // never wake up too early
+  if (expiry < current_tick_)
+    expiry = current_tick_;
+  thread->timer_wheel_expiry_ = expiry;
+  insert(thread);
+  ++size_;
+}
+
+void TimerWheel::insert(Thread* thread)
+{
+  uint64 delta = thread->timer_wheel_expiry_ - current_tick_;
+  size_t level = 0;
+  while (level < LEVELS - 1 && delta >= (1ULL << (SLOT_BITS * (level + 1))))
+    ++level;
+
+  uint64 expiry = thread->timer_wheel_expiry_;
+  if (delta >= (1ULL << (SLOT_BITS * LEVELS)))
+    expiry = current_tick_ + (1ULL << (SLOT_BITS * LEVELS)) - 1; // out of range, gets reinserted once cascaded
+
+  size_t slot = (expiry >> (SLOT_BITS * level)) & (SLOTS - 1);
+  Thread*& head = slots_[level][slot];
+  thread->timer_wheel_slot_ = level * SLOTS + slot;
+  thread->prev_in_timer_wheel_ = 0;
+  thread->next_in_timer_wheel_ = head;
+  if (head)
+    head->prev_in_timer_wheel_ = thread;
+  head = thread;
+  non_empty_slots_[level] |= (1ULL << slot);
+}
+
+void TimerWheel::remove(Thread* thread)
+{
+  if (!isQueued(thread))
+    return;
+  size_t level = thread->timer_wheel_slot_ / SLOTS;
+  size_t slot = thread->timer_wheel_slot_ % SLOTS;
+
+  if (thread->prev_in_timer_wheel_)
+    thread->prev_in_timer_wheel_->next_in_timer_wheel_ = thread->next_in_timer_wheel_;
+  else
+    slots_[level][slot] = thread->next_in_timer_wheel_;
+  if (thread->next_in_timer_wheel_)
+    thread->next_in_timer_wheel_->prev_in_timer_wheel_ = thread->prev_in_timer_wheel_;
+  if (!slots_[level][slot])
+    non_empty_slots_[level] &= ~(1ULL << slot);
+
+  thread->next_in_timer_wheel_ = 0;
+  thread->prev_in_timer_wheel_ = 0;
+  thread->timer_wheel_slot_ = NOT_QUEUED;
+  --size_;
+}
+
+size_t TimerWheel::advanceTo(uint64 now_ns)
+{
+  uint64 now = nsToTicks(now_ns);
+  size_t woken = 0;
+  while (current_tick_ <= now)
+  {
+    // jump straight to the next non-empty slot of any level, the slots in between are empty
+    // and do not have to be cascaded, so a long idle period costs no more than a short one
+    uint64 next = nextEventTick();
+    if (next > now)
+    {
+      current_tick_ = now + 1;
+      break;
+    }
+    current_tick_ = next;
+
+    size_t index = current_tick_ & (SLOTS - 1);
+    if (index == 0)
+      cascade(1);
+    if (non_empty_slots_[0] & (1ULL << index))
+      woken += expire(index);
+    ++current_tick_;
+  }
+  return woken;
+}
+
+void TimerWheel::cascade(size_t level)
+{
+  size_t slot = (current_tick_ >> (SLOT_BITS * level)) & (SLOTS - 1);
+  if (slot == 0 && level + 1 < LEVELS)
+    cascade(level + 1);
+
+  Thread* thread = slots_[level][slot];
+  slots_[level][slot] = 0;
+  non_empty_slots_[level] &= ~(1ULL << slot);
+  while (thread)
+  {
+    Thread* next = thread->next_in_timer_wheel_;
+    insert(thread);
+    thread = next;
+  }
+}
+
+size_t TimerWheel::expire(size_t slot)
+{
+  Thread* thread = slots_[0][slot];
+  slots_[0][slot] = 0;
+  non_empty_slots_[0] &= ~(1ULL << slot);
+  size_t woken = 0;
+  while (thread)
+  {
+    Thread* next = thread->next_in_timer_wheel_;
+    thread->next_in_timer_wheel_ = 0;
+    thread->prev_in_timer_wheel_ = 0;
+    thread->timer_wheel_slot_ = NOT_QUEUED;
+    --size_;
+    if (thread->getState() == Sleeping)
+    {
+      thread->setState(Running);
+      ++woken;
+    }
+    thread = next;
+  }
+  return woken;
+}
+
+uint64 TimerWheel::nextEventNs() const
+{
+  uint64 next = nextEventTick();
+  return next == -1ULL ? next : ticksToNs(next);
+}
+
+uint64 TimerWheel::nextEventTick() const
+{
+  if (!size_)
+    return -1ULL;
+  uint64 next = -1ULL;
+  for (size_t level = 0; level < LEVELS; ++level)
+  {
+    if (!non_empty_slots_[level])
+      continue;
+    size_t shift = SLOT_BITS * level;
+    uint64 base = current_tick_ >> shift;
+    size_t index = base & (SLOTS - 1);
+    // the slot of the current tick still has to be processed if we are right at its start
+    bool current_pending = (current_tick_ & ((1ULL << shift) - 1)) == 0;
+    size_t distance = current_pending ? distanceToNextSlot(non_empty_slots_[level], index) :
+        1 + distanceToNextSlot(non_empty_slots_[level], (index + 1) & (SLOTS - 1));
+    uint64 tick = (base + distance) << shift;
+    if (tick < next)
+      next = tick;
+  }
+  return next;
+}
+
+size_t TimerWheel::distanceToNextSlot(uint64 mask, size_t from)
+{
+  uint64 rotated = from ? ((mask >> from) | (mask << (SLOTS - from))) : mask;
+  return rotated ? ctz64(rotated) : SLOTS;
+}
+
+bool TimerWheel::isQueued(Thread* thread) const
+{
+  return thread->timer_wheel_slot_ != NOT_QUEUED;
+}
+
+size_t TimerWheel::size() const
+{
+  return size_;
+}
@@ -5,18 +5,19 @@
 #include "Loader.h"
 #include "VfsSyscall.h"
 #include "File.h"
+#include "FileDescriptor.h"
 #include "ArchMemory.h"
 #include "PageManager.h"
 #include "ArchThreads.h"
 #include "offsets.h"
 
-UserProcess::UserProcess(ustl::string filename, FileSystemInfo *fs_info, uint32 terminal_number) :
-    Thread(fs_info, filename, Thread::USER_THREAD), fd_(VfsSyscall::open(filename, O_RDONLY))
+UserProcess::UserProcess(ustl::string filename, FileSystemInfo *fs_info, uint32 terminal_number, LoadMode load_mode) :
+    Thread(fs_info, filename, Thread::USER_THREAD), binary_(openBinary(filename.c_str()))
 {
   ProcessRegistry::instance()->processStart(); //should also be called if you fork a process
 
-  if (fd_ >= 0)
-    loader_ = new Loader(fd_);
+  if (binary_)
+    loader_ = new Loader(binary_->getFile(), load_mode);
 
   if (!loader_ || !loader_->loadExecutableAndInitProcess())
   {
@@ -43,14 +44,45 @@ UserProcess::UserProcess(ustl::string filename, FileSystemInfo *fs_info, uint32
   switch_to_userspace_ = 1;
 }
 
+UserProcess::UserProcess(UserProcess& parent) :
+    Thread(new FileSystemInfo(*parent.getWorkingDirInfo()), parent.getName(), Thread::USER_THREAD),
+    binary_(openBinary(parent.getName()))
+{
+  assert(&parent == currentThread && "only the current thread can fork");
+  ProcessRegistry::instance()->processStart();
+
+  // the child shares the open files of the parent
+  fd_table_.copyFrom(parent.fd_table_);
+
+  if (!binary_)
+  {
+    debug(USERPROCESS, "Error: reopening %s for the fork failed!\n", parent.getName());
+    kill();
+    return;
+  }
+
+  loader_ = new Loader(*parent.loader_, binary_->getFile());
+
+  ArchThreads::createForkedUserRegisters(user_registers_, parent.user_registers_, getKernelStackStartPointer());
+
+  ArchThreads::setAddressSpace(this, loader_->arch_memory_);
+
+  debug(USERPROCESS, "ctor: Forked %s\n", parent.getName());
+
+  setTerminal(parent.getTerminal());
+
+  switch_to_userspace_ = 1;
+}
+
 UserProcess::~UserProcess()
 {
   assert(Scheduler::instance()->isCurrentlyCleaningUp());
   delete loader_;
   loader_ = 0;
 
-  if (fd_ > 0)
-    VfsSyscall::close(fd_);
+  // fd_table_ closes the files the program left open
+  if (binary_)
+    FileDescriptorTable::release(binary_);
 
   delete working_dir_;
   working_dir_ = 0;
@@ -58,6 +90,12 @@ UserProcess::~UserProcess()
   ProcessRegistry::instance()->processExit();
 }
 
+FileDescriptor* UserProcess::openBinary(const char* path)
+{
+  int32 fd = VfsSyscall::open(path, O_RDONLY);
+  return fd < 0 ? 0 : currentThread->getFdTable()->remove(fd);
+}
+
 void UserProcess::Run()
 {
   debug(USERPROCESS, "Run: Fail-safe kernel panic - you probably have forgotten to set switch_to_userspace_ = 1\n");
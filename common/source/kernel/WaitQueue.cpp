@@ -0,0 +1,126 @@
+#include "WaitQueue.h"
+#include "Thread.h"
+#include "Scheduler.h"
+#include "ArchInterrupts.h"
+#include "assert.h"
+
+WaitQueue::WaitQueue() : head_(0), tail_(0)
+{
+}
+
+void WaitQueue::prepareToWait()
+{
+  assert(currentThread);
+  assert(ArchInterrupts::testIFSet() && "WaitQueue::prepareToWait: interrupts have to be enabled");
+  lock_.acquire();
+  // a waker takes the lock before looking at the queue, so it either does not see us yet
+  // or sees us Sleeping and sets us Running again
+  currentThread->setState(Sleeping);
+  append(currentThread);
+  lock_.release(false);
+}
+
+void WaitQueue::sleep()
+{
+  assert(!ArchInterrupts::testIFSet() && "WaitQueue::sleep: prepareToWait has to be called first");
+  // a wake up may already have happened (e.g. from an interrupt handler), in that case
+  // we are Running again and the yield just gives up the rest of the time slice
+  ArchInterrupts::enableInterrupts();
+  Scheduler::instance()->yield();
+}
+
+void WaitQueue::sleepUntil(uint64 wakeup_ns)
+{
+  assert(!ArchInterrupts::testIFSet() && "WaitQueue::sleepUntil: prepareToWait has to be called first");
+  Scheduler::instance()->yieldUntil(wakeup_ns);
+  // the timer woke us up, nobody took us out of the queue
+  remove(currentThread);
+}
+
+void WaitQueue::finishWait()
+{
+  assert(!ArchInterrupts::testIFSet() && "WaitQueue::finishWait: prepareToWait has to be called first");
+  lock_.acquire();
+  unlink(currentThread);
+  if (currentThread->getState() == Sleeping)
+    currentThread->setState(Running);
+  lock_.release(true);
+}
+
+Thread* WaitQueue::wakeOne()
+{
+  bool interrupts_enabled = lock_.acquire();
+  Thread* thread = popFront();
+  if (thread)
+    thread->setState(Running);
+  lock_.release(interrupts_enabled);
+  return thread;
+}
+
+size_t WaitQueue::wakeAll()
+{
+  bool interrupts_enabled = lock_.acquire();
+  size_t count = 0;
+  while (Thread* thread = popFront())
+  {
+    thread->setState(Running);
+    ++count;
+  }
+  lock_.release(interrupts_enabled);
+  return count;
+}
+
+void WaitQueue::add(Thread* thread)
+{
+  bool interrupts_enabled = lock_.acquire();
+  append(thread);
+  lock_.release(interrupts_enabled);
+}
+
+void WaitQueue::remove(Thread* thread)
+{
+  bool interrupts_enabled = lock_.acquire();
+  unlink(thread);
+  lock_.release(interrupts_enabled);
+}
+
+void WaitQueue::unlink(Thread* thread)
+{
+  Thread* previous = 0;
+  for (Thread* t = head_; t != 0; previous = t, t = t->next_thread_in_wait_queue_)
+  {
+    if (t != thread)
+      continue;
+    if (previous)
+      previous->next_thread_in_wait_queue_ = thread->next_thread_in_wait_queue_;
+    else
+      head_ = thread->next_thread_in_wait_queue_;
+    if (tail_ == thread)
+      tail_ = previous;
+    thread->next_thread_in_wait_queue_ = 0;
+    break;
+  }
+}
+
+void WaitQueue::append(Thread* thread)
+{
+  assert(thread->next_thread_in_wait_queue_ == 0 && tail_ != thread && "Thread is already waiting in a queue");
+  if (tail_)
+    tail_->next_thread_in_wait_queue_ = thread;
+  else
+    head_ = thread;
+  tail_ = thread;
+}
+
+Thread* WaitQueue::popFront()
+{
+  Thread* thread = head_;
+  if (thread)
+  {
+    head_ = thread->next_thread_in_wait_queue_;
+    if (!head_)
+      tail_ = 0;
+    thread->next_thread_in_wait_queue_ = 0;
+  }
+  return thread;
+}
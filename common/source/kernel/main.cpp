@@ -7,6 +7,7 @@
 #include "KernelMemoryManager.h"
 #include "ArchInterrupts.h"
 #include "ArchThreads.h"
+#include "ArchMulticore.h"
 #include "kprintf.h"
 #include "Thread.h"
 #include "Scheduler.h"
@@ -29,6 +30,7 @@
 #include "Terminal.h"
 #include "outerrstream.h"
 #include "user_progs.h"
+#include "KernelBenchmarkThread.h"
 
 extern void* kernel_end_address;
 extern Console* main_console;
@@ -49,11 +51,14 @@ extern "C" void startup()
   while(!cont);
 #endif
 
+  ArchMulticore::initialise();
+
   writeLine2Bochs("Removing Boot Time Ident Mapping...\n");
   removeBootTimeIdentMapping();
   system_state = BOOTING;
 
   PageManager::instance();
+  PageManager::instance()->selfCheck();
   writeLine2Bochs("PageManager and KernelMemoryManager created \n");
 
   main_console = ArchCommon::createConsole(1);
@@ -80,6 +85,9 @@ extern "C" void startup()
 
   ArchInterrupts::setTimerFrequency(IRQ0_TIMER_FREQUENCY);
 
+  debug(MAIN, "Starting the other cpus\n");
+  ArchMulticore::startOtherCpus();
+
   ArchCommon::initDebug();
 
   vfs.initialize();
@@ -97,12 +105,6 @@ extern "C" void startup()
     debug(MAIN, "Detected Device: %s :: %d\n", bdvd->getName(), bdvd->getDeviceNumber());
   }
 
-  // initialise global and static objects
-  extern ustl::list<FileDescriptor*> global_fd;
-  new (&global_fd) ustl::list<FileDescriptor*>();
-  extern Mutex global_fd_lock;
-  new (&global_fd_lock) Mutex("global_fd_lock");
-
   debug(MAIN, "make a deep copy of FsWorkingDir\n");
   main_console->setWorkingDirInfo(new FileSystemInfo(*default_working_dir));
   debug(MAIN, "main_console->setWorkingDirInfo done\n");
@@ -118,13 +120,20 @@ extern "C" void startup()
 
   debug(MAIN, "Timer enable\n");
   ArchInterrupts::enableTimer();
+  Scheduler::instance()->enableTickless();
 
   KeyboardManager::instance();
   ArchInterrupts::enableKBD();
 
   debug(MAIN, "Adding Kernel threads\n");
+  // the console only runs when a key has been pressed, it should never have to wait for a busy user program
+  Scheduler::instance()->setScheduling(main_console, RealtimeClass, 0);
   Scheduler::instance()->addNewThread(main_console);
-  Scheduler::instance()->addNewThread(new ProcessRegistry(new FileSystemInfo(*default_working_dir), user_progs /*see user_progs.h*/));
+  Thread* process_registry = new ProcessRegistry(new FileSystemInfo(*default_working_dir), user_progs /*see user_progs.h*/);
+  if (KERNEL_BENCHMARKS)
+    Scheduler::instance()->addNewThread(new KernelBenchmarkThread(process_registry)); // starts it when done
+  else
+    Scheduler::instance()->addNewThread(process_registry);
   Scheduler::instance()->printThreadList();
 
   kprintf("Now enabling Interrupts...\n");
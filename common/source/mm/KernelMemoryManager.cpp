@@ -8,6 +8,7 @@
 #include "ArchInterrupts.h"
 #include "ArchMemory.h"
 #include "PageManager.h"
+#include "KmemCache.h"
 #include "kstring.h"
 #include "Stabs2DebugInfo.h"
 #include "backtrace.h"
@@ -18,6 +19,13 @@ KernelMemoryManager kmm;
 KernelMemoryManager * KernelMemoryManager::instance_;
 size_t KernelMemoryManager::pm_ready_;
 
+const size_t KernelMemoryManager::GRANULE_SHIFT;
+const size_t KernelMemoryManager::SL_BITS;
+const size_t KernelMemoryManager::SL_COUNT;
+const size_t KernelMemoryManager::FL_SHIFT;
+const size_t KernelMemoryManager::SMALL_LIMIT;
+const size_t KernelMemoryManager::FL_COUNT;
+
 KernelMemoryManager* KernelMemoryManager::instance()
 {
   if (unlikely(!instance_))
@@ -28,10 +36,17 @@ KernelMemoryManager* KernelMemoryManager::instance()
 }
 
 KernelMemoryManager::KernelMemoryManager(size_t min_heap_pages, size_t max_heap_pages) :
-        tracing_(false), lock_("KMM::lock_"), segments_used_(0), segments_free_(0), approx_memory_free_(0)
+        tracing_(false), fl_bitmap_(0), lock_("KMM::lock_"), segments_used_(0), segments_free_(0),
+        approx_memory_free_(0)
 {
   assert(instance_ == 0);
   instance_ = this;
+  for (size_t fl = 0; fl < FL_COUNT; ++fl)
+  {
+    sl_bitmap_[fl] = 0;
+    for (size_t sl = 0; sl < SL_COUNT; ++sl)
+      free_lists_[fl][sl] = 0;
+  }
   pointer start_address = ArchCommon::getFreeKernelMemoryStart();
   assert(((start_address) % PAGE_SIZE) == 0);
   base_break_ = start_address;
@@ -43,6 +58,7 @@ KernelMemoryManager::KernelMemoryManager(size_t min_heap_pages, size_t max_heap_
   first_ = (MallocSegment*)start_address;
   new ((void*)start_address) MallocSegment(0, 0, min_heap_pages * PAGE_SIZE - sizeof(MallocSegment), false);
   last_ = first_;
+  insertFreeSegment(first_);
   debug(KMM, "KernelMemoryManager::ctor, Heap starts at %zx and initially ends at %zx\n", start_address, start_address + min_heap_pages * PAGE_SIZE);
 }
 
@@ -84,6 +100,9 @@ pointer KernelMemoryManager::private_AllocateMemory(size_t requested_size, point
   new_pointer->alloc_at_ = tracing_ ? called_by : 0;
   new_pointer->alloc_by_ = (pointer)currentThread;
 
+  if (KMM_DEBUG_CHECKS)
+    checkHeap();
+
   return ((pointer) new_pointer) + sizeof(MallocSegment);
 }
 
@@ -136,7 +155,9 @@ pointer KernelMemoryManager::reallocateMemory(pointer virtual_address, size_t ne
 
   if (new_size < m_segment->getSize())
   {
-    fillSegment(m_segment, new_size, 0);
+    // the cut off part becomes free memory, which is always zeroed
+    memset((void*) (virtual_address + new_size), 0, m_segment->getSize() - new_size);
+    fillSegment(m_segment, new_size);
     unlockKMM();
     return virtual_address;
   }
@@ -147,7 +168,7 @@ pointer KernelMemoryManager::reallocateMemory(pointer virtual_address, size_t ne
       if (m_segment->next_->getUsed() == false && m_segment->next_->getSize() + m_segment->getSize() >= new_size)
       {
         mergeWithFollowingFreeSegment(m_segment);
-        fillSegment(m_segment, new_size, 0);
+        fillSegment(m_segment, new_size);
         unlockKMM();
         return virtual_address;
       }
@@ -191,17 +212,29 @@ MallocSegment *KernelMemoryManager::findFreeSegment(size_t requested_size)
 {
   debug(KMM, "findFreeSegment: seeking memory block of bytes: %zd \n", requested_size + sizeof(MallocSegment));
 
-  MallocSegment *current = first_;
-  while (current != 0)
+  size_t fl, sl;
+  if (mappingSearch(requested_size, fl, sl))
   {
-    debug(KMM, "findFreeSegment: current: %p size: %zd used: %d \n", current, current->getSize() + sizeof(MallocSegment),
-          current->getUsed());
-    assert(current->markerOk() && "memory corruption - probably 'write after delete'");
-    if ((current->getSize() >= requested_size) && (current->getUsed() == false))
+    uint32 sl_map = sl_bitmap_[fl] & (~0U << sl);
+    if (!sl_map)
+    {
+      uint32 fl_map = fl_bitmap_ & (~0U << (fl + 1));
+      if (fl_map)
+      {
+        fl = __builtin_ctz(fl_map);
+        sl_map = sl_bitmap_[fl];
+      }
+    }
+    if (sl_map)
+    {
+      MallocSegment *current = free_lists_[fl][__builtin_ctz(sl_map)];
+      assert(current->markerOk() && "memory corruption - probably 'write after delete'");
+      assert(current->getSize() >= requested_size && current->getUsed() == false && "KMM free lists corrupted");
+      removeFreeSegment(current);
       return current;
-
-    current = current->next_;
+    }
   }
+
   // No free segment found, could we allocate more memory?
   if(last_->getUsed())
   {
@@ -213,6 +246,7 @@ MallocSegment *KernelMemoryManager::findFreeSegment(size_t requested_size)
   else
   {
     // else we just increase the size of the last segment
+    removeFreeSegment(last_);
     size_t needed_size = requested_size - last_->getSize();
     ksbrk(needed_size);
     last_->setSize(requested_size);
@@ -221,32 +255,132 @@ MallocSegment *KernelMemoryManager::findFreeSegment(size_t requested_size)
   return last_;
 }
 
-void KernelMemoryManager::fillSegment(MallocSegment *this_one, size_t requested_size, uint32 zero_check)
+void KernelMemoryManager::mappingInsert(size_t size, size_t& fl, size_t& sl)
+{
+  if (size < SMALL_LIMIT)
+  {
+    fl = 0;
+    sl = size >> GRANULE_SHIFT;
+  }
+  else
+  {
+    size_t high_bit = 31 - __builtin_clz((uint32)size);
+    fl = high_bit - FL_SHIFT + 1;
+    sl = (size >> (high_bit - SL_BITS)) & (SL_COUNT - 1);
+  }
+}
+
+bool KernelMemoryManager::mappingSearch(size_t size, size_t& fl, size_t& sl)
+{
+  // round up to the next class boundary, then every segment of the class fits
+  if (size >= SMALL_LIMIT)
+    size += (1ULL << (31 - __builtin_clz((uint32)size) - SL_BITS)) - 1;
+  if (size >> 31)
+    return false;
+  mappingInsert(size, fl, sl);
+  return true;
+}
+
+void KernelMemoryManager::insertFreeSegment(MallocSegment *this_one)
+{
+  assert(this_one->getUsed() == false && "inserting a used segment into the free lists");
+  size_t fl, sl;
+  mappingInsert(this_one->getSize(), fl, sl);
+  MallocSegment*& head = free_lists_[fl][sl];
+  this_one->prev_free_ = 0;
+  this_one->next_free_ = head;
+  if (head)
+    head->prev_free_ = this_one;
+  head = this_one;
+  fl_bitmap_ |= (1U << fl);
+  sl_bitmap_[fl] |= (1U << sl);
+}
+
+void KernelMemoryManager::removeFreeSegment(MallocSegment *this_one)
+{
+  size_t fl, sl;
+  mappingInsert(this_one->getSize(), fl, sl);
+  if (this_one->prev_free_)
+    this_one->prev_free_->next_free_ = this_one->next_free_;
+  else
+  {
+    assert(free_lists_[fl][sl] == this_one && "segment is not in its free list");
+    free_lists_[fl][sl] = this_one->next_free_;
+    if (!free_lists_[fl][sl])
+    {
+      sl_bitmap_[fl] &= ~(1U << sl);
+      if (!sl_bitmap_[fl])
+        fl_bitmap_ &= ~(1U << fl);
+    }
+  }
+  if (this_one->next_free_)
+    this_one->next_free_->prev_free_ = this_one->prev_free_;
+  this_one->next_free_ = 0;
+  this_one->prev_free_ = 0;
+}
+
+void KernelMemoryManager::checkHeap()
+{
+  size_t free_segments = 0;
+  for (MallocSegment *current = first_; current != 0; current = current->next_)
+  {
+    debug(KMM, "checkHeap: current: %p prev: %p next: %p size: %zd used: %d\n", current, current->prev_,
+          current->next_, current->getSize() + sizeof(MallocSegment), current->getUsed());
+    assert(current->markerOk() && "memory corruption - probably 'write after delete'");
+    assert((current->next_ == 0 || current->next_->prev_ == current) && "KMM segment list corrupted");
+    assert((current->next_ != 0 || current == last_) && "KMM segment list corrupted");
+    if (!current->getUsed())
+    {
+      ++free_segments;
+      uint32* mem = (uint32*) (current + 1);
+      for (size_t i = 0; i < current->getSize() / 4; ++i)
+        assert(mem[i] == 0 && "free memory not zero - probably 'write after delete'");
+    }
+  }
+
+  size_t binned_segments = 0;
+  for (size_t fl = 0; fl < FL_COUNT; ++fl)
+  {
+    assert(((fl_bitmap_ >> fl) & 1) == (sl_bitmap_[fl] != 0) && "KMM free list bitmaps corrupted");
+    for (size_t sl = 0; sl < SL_COUNT; ++sl)
+    {
+      assert(((sl_bitmap_[fl] >> sl) & 1) == (free_lists_[fl][sl] != 0) && "KMM free list bitmaps corrupted");
+      for (MallocSegment *current = free_lists_[fl][sl]; current != 0; current = current->next_free_)
+      {
+        assert(current->markerOk() && "memory corruption - probably 'write after delete'");
+        assert(current->getUsed() == false && "used segment in the KMM free lists");
+        size_t current_fl, current_sl;
+        mappingInsert(current->getSize(), current_fl, current_sl);
+        assert(current_fl == fl && current_sl == sl && "segment in the wrong KMM free list");
+        ++binned_segments;
+      }
+    }
+  }
+  assert(binned_segments == free_segments && "KMM free lists out of sync with the segments");
+}
+
+void KernelMemoryManager::fillSegment(MallocSegment *this_one, size_t requested_size)
 {
   assert(this_one != 0 && "trying to access a nullpointer");
   assert(this_one->markerOk() && "memory corruption - probably 'write after delete'");
   assert(this_one->getSize() >= requested_size && "segment is too small for requested size");
   assert((requested_size & 0xF) == 0 && "Attempt to fill segment with unaligned size");
 
-  uint32* mem = (uint32*) (this_one + 1);
-  if (zero_check)
+  // free memory is zeroed when it is freed, writes to it afterwards are use after free bugs
+  if (KMM_DEBUG_CHECKS && !this_one->getUsed())
   {
-    for (uint32 i = 0; i < requested_size / 4; ++i)
+    uint32* mem = (uint32*) (this_one + 1);
+    for (size_t i = 0; i < requested_size / 4; ++i)
     {
       if(unlikely(mem[i] != 0))
       {
-
         kprintfd("KernelMemoryManager::fillSegment: WARNING: Memory not zero at %p (value=%x)\n", mem + i, mem[i]);
-        if(this_one->freed_at_)
+        if(this_one->freed_at_ && kernel_debug_info)
         {
-          if(kernel_debug_info)
-          {
-            kprintfd("KernelMemoryManager::freeSegment: The chunk may previously be freed at: ");
-            kernel_debug_info->printCallInformation(this_one->freed_at_);
-          }
-          assert(false);
+          kprintfd("KernelMemoryManager::freeSegment: The chunk may previously be freed at: ");
+          kernel_debug_info->printCallInformation(this_one->freed_at_);
         }
-        mem[i] = 0;
+        assert(false && "write after delete");
       }
     }
   }
@@ -276,6 +410,9 @@ void KernelMemoryManager::fillSegment(MallocSegment *this_one, size_t requested_
 
     if (new_segment->next_ == 0)
       last_ = new_segment;
+
+    mergeWithFollowingFreeSegment(new_segment);
+    insertFreeSegment(new_segment);
   }
   debug(KMM, "fillSegment: filled memory block of bytes: %zd \n", this_one->getSize() + sizeof(MallocSegment));
 }
@@ -304,6 +441,8 @@ void KernelMemoryManager::freeSegment(MallocSegment *this_one)
   debug(KMM, "fillSegment: freeing block: %p of bytes: %zd \n", this_one, this_one->getSize() + sizeof(MallocSegment));
 
   this_one->setUsed(false);
+  // free segments are always kept zeroed, so allocating them needs neither clearing nor checking
+  memset((void*) (this_one + 1), 0, this_one->getSize());
 
   if (this_one->prev_ != 0)
   {
@@ -315,6 +454,7 @@ void KernelMemoryManager::freeSegment(MallocSegment *this_one)
                                    ((pointer) this_one->next_) - ((pointer) this_one));
 
       MallocSegment *previous_one = this_one->prev_;
+      removeFreeSegment(previous_one);
 
       previous_one->setSize(my_true_size + previous_one->getSize());
       previous_one->next_ = this_one->next_;
@@ -335,14 +475,13 @@ void KernelMemoryManager::freeSegment(MallocSegment *this_one)
       debug(KMM, "freeSegment: this_one: %p size: %zd used: %d\n", this_one, this_one->getSize() + sizeof(MallocSegment),
             this_one->getUsed());
 
+      memset((void*) this_one, 0, sizeof(MallocSegment)); // now part of the zeroed memory of previous_one
       this_one = previous_one;
     }
   }
 
   mergeWithFollowingFreeSegment(this_one);
 
-  memset((void*) ((size_t) this_one + sizeof(MallocSegment)), 0, this_one->getSize()); // ease debugging
-
   // Change break if this is the last segment
   if(this_one == last_)
   {
@@ -358,7 +497,12 @@ void KernelMemoryManager::freeSegment(MallocSegment *this_one)
         assert(this_one && this_one->prev_ && this_one->prev_->markerOk() && "memory corruption - probably 'write after delete'");
         this_one->prev_->next_ = 0;
         last_ = this_one->prev_;
-        ksbrk(-(this_one->getSize() + sizeof(MallocSegment)));
+        size_t segment_size = this_one->getSize() + sizeof(MallocSegment);
+        memset((void*) this_one, 0, sizeof(MallocSegment)); // the rest of its page stays mapped
+        ksbrk(-segment_size);
+        if (KMM_DEBUG_CHECKS)
+          checkHeap();
+        return;
       }
       else if((size_t)this_one + sizeof(MallocSegment) + this_one->getSize() <= base_break_ + reserved_min_)
       {
@@ -386,17 +530,10 @@ void KernelMemoryManager::freeSegment(MallocSegment *this_one)
     }
   }
 
-  {
-    MallocSegment *current = first_;
-    while (current != 0)
-    {
-      debug(KMM, "freeSegment: current: %p prev: %p next: %p size: %zd used: %d\n", current, current->prev_,
-            current->next_, current->getSize() + sizeof(MallocSegment), current->getUsed());
-      assert(current->markerOk() && "memory corruption - probably 'write after delete'");
-      current = current->next_;
-    }
+  insertFreeSegment(this_one);
 
-  }
+  if (KMM_DEBUG_CHECKS)
+    checkHeap();
 }
 
 bool KernelMemoryManager::mergeWithFollowingFreeSegment(MallocSegment *this_one)
@@ -410,6 +547,7 @@ bool KernelMemoryManager::mergeWithFollowingFreeSegment(MallocSegment *this_one)
     if (this_one->next_->getUsed() == false)
     {
       MallocSegment *next_one = this_one->next_;
+      removeFreeSegment(next_one);
       size_t true_next_size = (
           (next_one->next_ == 0) ? kernel_break_ - ((pointer) next_one) :
                                    ((pointer) next_one->next_) - ((pointer) next_one));
@@ -533,6 +671,11 @@ size_t KernelMemoryManager::getUsedKernelMemory(bool show_allocs = false) {
       current = current->next_;
     }
     if(show_allocs) kprintfd("\n%zu bytes in %zu blocks are in use (%zu%%)\n", size, blocks, 100 * size / (size + unused));
+    if(show_allocs)
+    {
+      kprintfd("\nObject caches, %zu bytes in slabs\n", KmemCache::getUsedSlabMemory());
+      KmemCache::printStatistics();
+    }
     return size;
 }
 
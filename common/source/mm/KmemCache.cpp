@@ -0,0 +1,190 @@
+#include "KmemCache.h"
+#include "PageManager.h"
+#include "ArchMemory.h"
+#include "assert.h"
+#include "kprintf.h"
+#include "debug.h"
+
+const size_t KmemCache::OBJECT_ALIGNMENT;
+const size_t KmemCache::MIN_OBJECTS_PER_SLAB;
+const size_t KmemCache::MAX_SLAB_ORDER;
+
+KmemCache* KmemCache::caches_ = 0;
+IrqSafeSpinLock KmemCache::caches_lock_;
+
+void* KmemCache::allocate(size_t size)
+{
+  assert(size <= object_size_ && "object does not fit into this cache");
+
+  if (unlikely(!__atomic_load_n(&registered_, __ATOMIC_ACQUIRE)))
+    registerCache();
+
+  bool interrupts_enabled = lock_.acquire();
+  if (!partial_slabs_)
+  {
+    if (empty_slab_)
+    {
+      listInsert(partial_slabs_, empty_slab_);
+      empty_slab_ = 0;
+    }
+    else
+    {
+      // the PageManager may block, so the new slab is prepared without holding the lock
+      lock_.release(interrupts_enabled);
+      Slab* slab = createSlab();
+      interrupts_enabled = lock_.acquire();
+      listInsert(partial_slabs_, slab);
+      ++num_slabs_;
+    }
+  }
+
+  Slab* slab = partial_slabs_;
+  void* object = slab->free_objects;
+  assert(object && "full slab in the partial list");
+  slab->free_objects = *(void**)object;
+  if (++slab->objects_in_use == objects_per_slab_)
+  {
+    listRemove(partial_slabs_, slab);
+    listInsert(full_slabs_, slab);
+  }
+  ++objects_in_use_;
+  ++allocations_;
+  lock_.release(interrupts_enabled);
+
+  debug(KMM, "KmemCache(%s)::allocate: %p\n", name_, object);
+  return object;
+}
+
+void KmemCache::free(void* object)
+{
+  if (!object)
+    return;
+
+  Slab* slab = (Slab*)((pointer)object & ~(slabSize() - 1));
+  assert(slab->cache == this && "object was not allocated from this cache");
+  assert(((pointer)object - (pointer)slab - firstObjectOffset()) % object_size_ == 0 &&
+         "pointer into the middle of a cached object");
+  debug(KMM, "KmemCache(%s)::free: %p\n", name_, object);
+
+  size_t ppn_to_release = 0;
+  bool interrupts_enabled = lock_.acquire();
+  assert(slab->objects_in_use > 0 && "double free of a cached object");
+  if (slab->objects_in_use-- == objects_per_slab_)
+  {
+    listRemove(full_slabs_, slab);
+    listInsert(partial_slabs_, slab);
+  }
+  *(void**)object = slab->free_objects;
+  slab->free_objects = object;
+  if (slab->objects_in_use == 0)
+  {
+    listRemove(partial_slabs_, slab);
+    if (!empty_slab_)
+      empty_slab_ = slab;
+    else
+    {
+      ppn_to_release = slab->ppn;
+      --num_slabs_;
+    }
+  }
+  --objects_in_use_;
+  ++frees_;
+  lock_.release(interrupts_enabled);
+
+  if (ppn_to_release)
+    PageManager::instance()->freePPN(ppn_to_release, slabSize());
+}
+
+void KmemCache::registerCache()
+{
+  size_t order = 0;
+  while (order < MAX_SLAB_ORDER &&
+         ((PAGE_SIZE << order) - firstObjectOffset()) / object_size_ < MIN_OBJECTS_PER_SLAB)
+    ++order;
+
+  bool interrupts_enabled = caches_lock_.acquire();
+  if (!registered_)
+  {
+    slab_order_ = order;
+    objects_per_slab_ = (slabSize() - firstObjectOffset()) / object_size_;
+    assert(objects_per_slab_ > 0 && "object too large for a slab");
+    next_cache_ = caches_;
+    caches_ = this;
+    __atomic_store_n(&registered_, true, __ATOMIC_RELEASE);
+  }
+  caches_lock_.release(interrupts_enabled);
+}
+
+KmemCache::Slab* KmemCache::createSlab()
+{
+  size_t ppn = PageManager::instance()->allocPPN(slabSize());
+  Slab* slab = (Slab*)ArchMemory::getIdentAddressOfPPN(ppn);
+  assert(((pointer)slab & (slabSize() - 1)) == 0 && "slab is not aligned to its size");
+  slab->cache = this;
+  slab->next = 0;
+  slab->prev = 0;
+  slab->objects_in_use = 0;
+  slab->ppn = ppn;
+
+  // link the objects in address order, the first allocations then touch the slab front to back
+  slab->free_objects = 0;
+  pointer first_object = (pointer)slab + firstObjectOffset();
+  for (size_t i = objects_per_slab_; i-- > 0;)
+  {
+    void* object = (void*)(first_object + i * object_size_);
+    *(void**)object = slab->free_objects;
+    slab->free_objects = object;
+  }
+  debug(KMM, "KmemCache(%s)::createSlab: %zu objects at %p\n", name_, objects_per_slab_, slab);
+  return slab;
+}
+
+size_t KmemCache::slabSize() const
+{
+  return PAGE_SIZE << slab_order_;
+}
+
+size_t KmemCache::firstObjectOffset() const
+{
+  return (sizeof(Slab) + OBJECT_ALIGNMENT - 1) & ~(OBJECT_ALIGNMENT - 1);
+}
+
+void KmemCache::listInsert(Slab*& head, Slab* slab)
+{
+  slab->prev = 0;
+  slab->next = head;
+  if (head)
+    head->prev = slab;
+  head = slab;
+}
+
+void KmemCache::listRemove(Slab*& head, Slab* slab)
+{
+  if (slab->prev)
+    slab->prev->next = slab->next;
+  else
+    head = slab->next;
+  if (slab->next)
+    slab->next->prev = slab->prev;
+  slab->next = 0;
+  slab->prev = 0;
+}
+
+void KmemCache::printStatistics()
+{
+  kprintfd("%-20s %8s %8s %6s %6s %10s %10s\n", "cache", "in use", "total", "size", "slabs", "allocs", "frees");
+  for (KmemCache* cache = __atomic_load_n(&caches_, __ATOMIC_ACQUIRE); cache; cache = cache->next_cache_)
+  {
+    kprintfd("%-20s %8zu %8zu %6zu %6zu %10zu %10zu\n", cache->name_, cache->objects_in_use_,
+             cache->num_slabs_ * cache->objects_per_slab_, cache->object_size_, cache->num_slabs_,
+             cache->allocations_, cache->frees_);
+  }
+}
+
+size_t KmemCache::getUsedSlabMemory()
+{
+  size_t size = 0;
+  for (KmemCache* cache = __atomic_load_n(&caches_, __ATOMIC_ACQUIRE); cache; cache = cache->next_cache_)
+    size += cache->num_slabs_ * cache->slabSize();
+  return size;
+}
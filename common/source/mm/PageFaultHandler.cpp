@@ -12,7 +12,7 @@ extern "C" void arch_contextSwitch();
 const size_t PageFaultHandler::null_reference_check_border_ = PAGE_SIZE;
 
 inline bool PageFaultHandler::checkPageFaultIsValid(size_t address, bool user,
-                                                    bool present, bool switch_to_us)
+                                                    bool present, bool writing, bool switch_to_us)
 {
   assert((user == switch_to_us) && "Thread is in user mode even though is should not be.");
   assert(!(address < USER_BREAK && currentThread->loader_ == 0) && "Thread accesses the user space, but has no loader.");
@@ -30,10 +30,14 @@ inline bool PageFaultHandler::checkPageFaultIsValid(size_t address, bool user,
   {
     debug(PAGEFAULT, "You are accessing a kernel address in user-mode.\n");
   }
-  else if(present)
+  else if(present && !writing)
   {
     debug(PAGEFAULT, "You got a pagefault even though the address is mapped.\n");
   }
+  else if(present && !currentThread->loader_->arch_memory_.copyOnWrite(address / PAGE_SIZE))
+  {
+    debug(PAGEFAULT, "You are writing to a read only page.\n");
+  }
   else
   {
     // everything seems to be okay
@@ -59,9 +63,11 @@ inline void PageFaultHandler::handlePageFault(size_t address, bool user,
   //Uncomment the line below if you want to have detailed information about the thread registers.
   //ArchThreads::printThreadRegisters(currentThread, false);
 
-  if (checkPageFaultIsValid(address, user, present, switch_to_us))
+  if (checkPageFaultIsValid(address, user, present, writing, switch_to_us))
   {
-    currentThread->loader_->loadPage(address);
+    // a write fault on a mapped page has already been resolved by copying the page
+    if (!present)
+      currentThread->loader_->loadPage(address);
   }
   else
   {
@@ -85,7 +91,7 @@ void PageFaultHandler::enterPageFault(size_t address, bool user,
   uint32 saved_switch_to_userspace = currentThread->switch_to_userspace_;
 
   currentThread->switch_to_userspace_ = 0;
-  currentThreadRegisters = currentThread->kernel_registers_;
+  ArchMulticore::setCurrentThreadRegisters(currentThread->kernel_registers_);
   ArchInterrupts::enableInterrupts();
 
   handlePageFault(address, user, present, writing, fetch, saved_switch_to_userspace);
@@ -93,5 +99,5 @@ void PageFaultHandler::enterPageFault(size_t address, bool user,
   ArchInterrupts::disableInterrupts();
   currentThread->switch_to_userspace_ = saved_switch_to_userspace;
   if (currentThread->switch_to_userspace_)
-    currentThreadRegisters = currentThread->user_registers_;
+    ArchMulticore::setCurrentThreadRegisters(currentThread->user_registers_);
 }
@@ -16,6 +16,11 @@ PageManager pm;
 
 PageManager* PageManager::instance_ = 0;
 
+const size_t PageManager::MAX_ORDER;
+const size_t PageManager::ZERO_POOL_SIZE;
+const size_t PageManager::MAGAZINE_SIZE;
+const size_t PageManager::MAGAZINE_BATCH;
+
 PageManager* PageManager::instance()
 {
   if (unlikely(!instance_))
@@ -29,7 +34,20 @@ PageManager::PageManager() : lock_("PageManager::lock_")
   instance_ = this;
   assert(KernelMemoryManager::instance_ == 0);
   number_of_pages_ = 0;
-  lowest_unreserved_page_ = 0;
+  num_free_pages_ = 0;
+  zero_pool_count_ = 0;
+  zero_pool_hits_ = 0;
+  zero_pool_misses_ = 0;
+  lock_acquisitions_ = 0;
+  share_counts_ = 0;
+  num_copied_frames_ = 0;
+  for (size_t cpu = 0; cpu < ArchMulticore::MAX_CPUS; ++cpu)
+    magazines_[cpu].count = 0;
+  for (size_t order = 0; order <= MAX_ORDER; ++order)
+  {
+    free_lists_[order] = 0;
+    num_free_blocks_[order] = 0;
+  }
 
   size_t num_mmaps = ArchCommon::getNumUseableMemoryRegions();
 
@@ -65,7 +83,7 @@ PageManager::PageManager() : lock_("PageManager::lock_")
     size_t end_page = end_address / PAGE_SIZE;
     debug(PM, "Ctor: usable memory region: start_page: %zx, end_page: %zx, type: %zd\n", start_page, end_page, type);
 
-    for (size_t k = Max(start_page, lowest_unreserved_page_); k < Min(end_page, number_of_pages_); ++k)
+    for (size_t k = start_page; k < Min(end_page, number_of_pages_); ++k)
     {
       Bitmap::unsetBit(page_usage_table, used_pages, k);
     }
@@ -123,8 +141,9 @@ PageManager::PageManager() : lock_("PageManager::lock_")
   for (num_reserved_heap_pages = 0; num_reserved_heap_pages < num_pages_for_bitmap || temp_page_size != 0 ||
                                     num_reserved_heap_pages < ((DYNAMIC_KMM || (number_of_pages_ < 512)) ? 0 : HEAP_PAGES); ++num_reserved_heap_pages)
   {
-    while (!Bitmap::setBit(page_usage_table, used_pages, free_page))
-      free_page++;
+    free_page = Bitmap::findFirstClear(page_usage_table, boot_bitmap_size, free_page);
+    assert(free_page < boot_bitmap_size && "No space for kernel heap!");
+    Bitmap::setBit(page_usage_table, used_pages, free_page);
     if ((temp_page_size = ArchMemory::get_PPN_Of_VPN_In_KernelMapping(start_vpn,0,0)) == 0)
       ArchMemory::mapKernelPage(start_vpn,free_page++);
     start_vpn++;
@@ -132,26 +151,24 @@ PageManager::PageManager() : lock_("PageManager::lock_")
 
   extern KernelMemoryManager kmm;
   new (&kmm) KernelMemoryManager(num_reserved_heap_pages,HEAP_PAGES);
-  page_usage_table_ = new Bitmap(number_of_pages_);
-
-  for (size_t i = 0; i < boot_bitmap_size; ++i)
-  {
-    if (Bitmap::getBit(page_usage_table,i))
-      page_usage_table_->setBit(i);
-  }
+  free_block_heads_ = new Bitmap(number_of_pages_);
+  share_counts_ = new uint16[number_of_pages_];
+  memset(share_counts_, 0, number_of_pages_ * sizeof(uint16));
 
-  debug(PM, "Ctor: find lowest unreserved page\n");
-  for (size_t p = 0; p < number_of_pages_; ++p)
+  debug(PM, "Ctor: building the buddy free lists\n");
+  // page 0 is never handed out, allocPPN uses 0 to report running out of memory
+  size_t run_start = Bitmap::findFirstClear(page_usage_table, boot_bitmap_size, 1);
+  while (run_start < boot_bitmap_size)
   {
-    if (!page_usage_table_->getBit(p))
-    {
-      lowest_unreserved_page_ = p;
-      break;
-    }
+    size_t run_end = Bitmap::findNextSet(page_usage_table, boot_bitmap_size, run_start);
+    freeRange(run_start, run_end);
+    run_start = Bitmap::findFirstClear(page_usage_table, boot_bitmap_size, run_end);
   }
-  debug(PM, "Ctor: Physical pages - free: %zu used: %zu total: %u\n", page_usage_table_->getNumFreeBits(),
-        page_usage_table_->getNumBitsSet(), number_of_pages_);
-  assert(lowest_unreserved_page_ < number_of_pages_);
+  // the boot bitmap does not cover the pages above it, they are all free
+  freeRange(Max(boot_bitmap_size, (size_t)1), number_of_pages_);
+  debug(PM, "Ctor: Physical pages - free: %zu used: %zu total: %u\n", num_free_pages_,
+        number_of_pages_ - num_free_pages_, number_of_pages_);
+  assert(num_free_pages_ > 0);
   KernelMemoryManager::pm_ready_ = 1;
 }
 
@@ -162,63 +179,432 @@ uint32 PageManager::getTotalNumPages() const
 
 size_t PageManager::getNumFreePages() const
 {
-  return page_usage_table_->getNumFreeBits();
+  size_t num_free_pages = num_free_pages_ + zero_pool_count_;
+  for (size_t cpu = 0; cpu < ArchMulticore::MAX_CPUS; ++cpu)
+    num_free_pages += magazines_[cpu].count;
+  return num_free_pages;
 }
 
-bool PageManager::reservePages(uint32 ppn, uint32 num)
+uint32 PageManager::allocPPN(uint32 page_size, uint32 flags)
 {
-  assert(lock_.heldBy() == currentThread);
-  if (ppn < number_of_pages_ && !page_usage_table_->getBit(ppn))
+  size_t order = pageSizeToOrder(page_size);
+  bool zero = !(flags & ALLOC_NO_ZERO);
+
+  size_t ppn = 0;
+  if (order == 0)
+    ppn = allocPage(zero);
+  else
   {
-    if (num == 1 || reservePages(ppn + 1, num - 1))
-    {
-      page_usage_table_->setBit(ppn);
-      return true;
-    }
+    acquireLock();
+    ppn = allocBlock(order);
+    lock_.release();
+    if (zero && ppn)
+      memset((void*)ArchMemory::getIdentAddressOfPPN(ppn), 0, page_size);
+  }
+
+  if (!ppn && !(flags & ALLOC_MAY_FAIL))
+  {
+    // the free pages might only be scattered over the zero pool and the magazine
+    drainMagazine();
+    acquireLock();
+    drainZeroPool();
+    ppn = allocBlock(order);
+    lock_.release();
+    if (zero && ppn)
+      memset((void*)ArchMemory::getIdentAddressOfPPN(ppn), 0, page_size);
+  }
+
+  if (!ppn)
+  {
+    assert((flags & ALLOC_MAY_FAIL) && "PageManager::allocPPN: Out of memory / No more free physical pages");
+    return 0;
   }
-  return false;
+  return ppn;
 }
 
-uint32 PageManager::allocPPN(uint32 page_size)
+size_t PageManager::allocPage(bool zero)
 {
-  assert((page_size % PAGE_SIZE) == 0);
-  while (1)
+  bool interrupts_enabled = ArchInterrupts::disableInterrupts();
+  if (!magazines_[ArchMulticore::cpuId()].count)
   {
-    lock_.acquire();
-    uint32 p;
-    uint32 found = 0;
-    for (p = lowest_unreserved_page_; !found && p < number_of_pages_; ++p)
-    {
-      if ((p % (page_size / PAGE_SIZE)) != 0)
-        continue;
-      if (reservePages(p, page_size / PAGE_SIZE))
-        found = p;
-    }
-    while (lowest_unreserved_page_ < number_of_pages_ && page_usage_table_->getBit(lowest_unreserved_page_))
-      ++lowest_unreserved_page_;
+    if (interrupts_enabled)
+      ArchInterrupts::enableInterrupts();
+    refillMagazine();
+    interrupts_enabled = ArchInterrupts::disableInterrupts();
+  }
+
+  PageMagazine& magazine = magazines_[ArchMulticore::cpuId()];
+  size_t ppn = 0;
+  bool zeroed = false;
+  if (magazine.count)
+  {
+    --magazine.count;
+    ppn = magazine.ppns[magazine.count];
+    zeroed = magazine.zeroed[magazine.count];
+    if (zero)
+      ++(zeroed ? zero_pool_hits_ : zero_pool_misses_);
+  }
+  if (interrupts_enabled)
+    ArchInterrupts::enableInterrupts();
+
+  if (ppn && zero && !zeroed)
+    memset((void*)ArchMemory::getIdentAddressOfPPN(ppn), 0, PAGE_SIZE);
+  return ppn;
+}
+
+void PageManager::freePage(size_t ppn)
+{
+  size_t drained[MAGAZINE_BATCH];
+  size_t num_drained = 0;
+
+  bool interrupts_enabled = ArchInterrupts::disableInterrupts();
+  PageMagazine& magazine = magazines_[ArchMulticore::cpuId()];
+  // freeBlock only sees the pages which leave the magazine, catch double frees here already
+  assert(!free_block_heads_->getBit(ppn) && "Double free PPN");
+  for (size_t i = 0; i < magazine.count; ++i)
+    assert(magazine.ppns[i] != ppn && "Double free PPN");
+  if (magazine.count == MAGAZINE_SIZE)
+  {
+    while (num_drained < MAGAZINE_BATCH)
+      drained[num_drained++] = magazine.ppns[--magazine.count];
+  }
+  magazine.ppns[magazine.count] = ppn;
+  magazine.zeroed[magazine.count] = false;
+  ++magazine.count;
+  if (interrupts_enabled)
+    ArchInterrupts::enableInterrupts();
+
+  if (num_drained)
+  {
+    acquireLock();
+    for (size_t i = 0; i < num_drained; ++i)
+      freeBlock(drained[i], 0);
     lock_.release();
+  }
+}
 
-    if (found == 0)
-    {
-      assert(false && "PageManager::allocPPN: Out of memory / No more free physical pages");
-    }
-    memset((void*)ArchMemory::getIdentAddressOfPPN(found), 0, page_size);
-    return found;
+void PageManager::refillMagazine()
+{
+  size_t ppns[MAGAZINE_BATCH];
+  bool zeroed[MAGAZINE_BATCH];
+  size_t count = 0;
+
+  acquireLock();
+  while (count < MAGAZINE_BATCH)
+  {
+    zeroed[count] = zero_pool_count_ > 0;
+    ppns[count] = zeroed[count] ? zero_pool_[--zero_pool_count_] : allocBlock(0);
+    if (!ppns[count])
+      break;
+    ++count;
+  }
+  lock_.release();
+
+  bool interrupts_enabled = ArchInterrupts::disableInterrupts();
+  PageMagazine& magazine = magazines_[ArchMulticore::cpuId()];
+  while (count && magazine.count < MAGAZINE_SIZE)
+  {
+    --count;
+    magazine.ppns[magazine.count] = ppns[count];
+    magazine.zeroed[magazine.count] = zeroed[count];
+    ++magazine.count;
   }
-  return 0;
+  if (interrupts_enabled)
+    ArchInterrupts::enableInterrupts();
+
+  // an interrupt handler filled the magazine in the meantime
+  if (count)
+  {
+    acquireLock();
+    while (count)
+      freeBlock(ppns[--count], 0);
+    lock_.release();
+  }
+}
+
+void PageManager::drainMagazine()
+{
+  size_t ppns[MAGAZINE_SIZE];
+  size_t count = 0;
+
+  bool interrupts_enabled = ArchInterrupts::disableInterrupts();
+  PageMagazine& magazine = magazines_[ArchMulticore::cpuId()];
+  while (magazine.count)
+    ppns[count++] = magazine.ppns[--magazine.count];
+  if (interrupts_enabled)
+    ArchInterrupts::enableInterrupts();
+
+  if (count)
+  {
+    acquireLock();
+    while (count)
+      freeBlock(ppns[--count], 0);
+    lock_.release();
+  }
+}
+
+size_t PageManager::allocBlock(size_t order)
+{
+  size_t block_order = order;
+  while (block_order <= MAX_ORDER && !free_lists_[block_order])
+    ++block_order;
+  if (block_order > MAX_ORDER)
+    return 0;
+
+  size_t ppn = free_lists_[block_order]->ppn;
+  removeFreeBlock(free_lists_[block_order]);
+  // split the block, the upper halves go back to the free lists
+  while (block_order > order)
+  {
+    --block_order;
+    insertFreeBlock(ppn + (1 << block_order), block_order);
+  }
+  return ppn;
+}
+
+bool PageManager::refillZeroPool()
+{
+  acquireLock();
+  size_t ppn = 0;
+  if (zero_pool_count_ < ZERO_POOL_SIZE)
+    ppn = allocBlock(0);
+  lock_.release();
+  if (!ppn)
+    return true;
+
+  memset((void*)ArchMemory::getIdentAddressOfPPN(ppn), 0, PAGE_SIZE);
+
+  acquireLock();
+  bool full = zero_pool_count_ == ZERO_POOL_SIZE;
+  if (full)
+    freeBlock(ppn, 0);
+  else
+    zero_pool_[zero_pool_count_++] = ppn;
+  full = full || zero_pool_count_ == ZERO_POOL_SIZE;
+  lock_.release();
+  return full;
+}
+
+void PageManager::drainZeroPool()
+{
+  while (zero_pool_count_)
+    freeBlock(zero_pool_[--zero_pool_count_], 0);
+}
+
+size_t PageManager::getZeroPoolHits() const
+{
+  return zero_pool_hits_;
+}
+
+size_t PageManager::getZeroPoolMisses() const
+{
+  return zero_pool_misses_;
+}
+
+size_t PageManager::getLockAcquisitions() const
+{
+  return lock_acquisitions_;
 }
 
 void PageManager::freePPN(uint32 page_number, uint32 page_size)
 {
-  assert((page_size % PAGE_SIZE) == 0);
-  lock_.acquire();
-  if (page_number < lowest_unreserved_page_)
-    lowest_unreserved_page_ = page_number;
-  for (uint32 p = page_number; p < (page_number + page_size / PAGE_SIZE); ++p)
+  size_t order = pageSizeToOrder(page_size);
+  assert(page_number != 0 && page_number + (1 << order) <= number_of_pages_ && "freeing an invalid PPN");
+  assert((page_number & ((1 << order) - 1)) == 0 && "PPN is not aligned to the page size");
+  if (order == 0)
   {
-    assert(page_usage_table_->getBit(p) && "Double free PPN");
-    page_usage_table_->unsetBit(p);
+    if (!releaseSharedFrame(page_number))
+      freePage(page_number);
+    return;
   }
+  acquireLock();
+  freeBlock(page_number, order);
   lock_.release();
 }
 
+void PageManager::shareFrame(size_t ppn)
+{
+  assert(ppn != 0 && ppn < number_of_pages_ && "sharing an invalid PPN");
+  uint16 users = __atomic_add_fetch(&share_counts_[ppn], 1, __ATOMIC_RELAXED);
+  assert(users != 0 && "too many users of a shared page");
+}
+
+bool PageManager::releaseSharedFrame(size_t ppn)
+{
+  uint16 users = __atomic_load_n(&share_counts_[ppn], __ATOMIC_RELAXED);
+  do
+  {
+    if (users == 0)
+      return false;
+  } while (!__atomic_compare_exchange_n(&share_counts_[ppn], &users, users - 1, true, __ATOMIC_ACQ_REL,
+                                        __ATOMIC_RELAXED));
+  return true;
+}
+
+size_t PageManager::copySharedFrame(size_t ppn)
+{
+  if (!__atomic_load_n(&share_counts_[ppn], __ATOMIC_ACQUIRE))
+    return ppn;
+
+  // all mappings of the page are read only, so its content cannot change while it is copied
+  size_t copy = allocPPN(PAGE_SIZE, ALLOC_NO_ZERO);
+  memcpy((void*)ArchMemory::getIdentAddressOfPPN(copy), (void*)ArchMemory::getIdentAddressOfPPN(ppn), PAGE_SIZE);
+  if (!releaseSharedFrame(ppn))
+  {
+    // the other users have copied or freed the page meanwhile, it is ours alone
+    freePPN(copy);
+    return ppn;
+  }
+  __atomic_add_fetch(&num_copied_frames_, 1, __ATOMIC_RELAXED);
+  return copy;
+}
+
+size_t PageManager::getShareCount(size_t ppn) const
+{
+  return __atomic_load_n(&share_counts_[ppn], __ATOMIC_ACQUIRE);
+}
+
+size_t PageManager::getNumCopiedFrames() const
+{
+  return num_copied_frames_;
+}
+
+void PageManager::freeBlock(size_t ppn, size_t order)
+{
+  assert(!free_block_heads_->getBit(ppn) && "Double free PPN");
+  while (order < MAX_ORDER)
+  {
+    // a free buddy always starts a free block, otherwise that block would also contain this one
+    size_t buddy = ppn ^ (1 << order);
+    if (buddy + (1 << order) > number_of_pages_ || !free_block_heads_->getBit(buddy))
+      break;
+    FreeBlock* buddy_block = (FreeBlock*)ArchMemory::getIdentAddressOfPPN(buddy);
+    if (buddy_block->order != order)
+      break;
+    removeFreeBlock(buddy_block);
+    ppn &= ~(1 << order);
+    ++order;
+  }
+  insertFreeBlock(ppn, order);
+}
+
+void PageManager::freeRange(size_t start, size_t end)
+{
+  while (start < end)
+  {
+    // the largest block which is aligned to its size and still fits into the range
+    size_t order = 0;
+    while (order < MAX_ORDER && (start & ((2 << order) - 1)) == 0 && start + (2 << order) <= end)
+      ++order;
+    freeBlock(start, order);
+    start += 1 << order;
+  }
+}
+
+void PageManager::insertFreeBlock(size_t ppn, size_t order)
+{
+  FreeBlock* block = (FreeBlock*)ArchMemory::getIdentAddressOfPPN(ppn);
+  block->ppn = ppn;
+  block->order = order;
+  block->prev = 0;
+  block->next = free_lists_[order];
+  if (block->next)
+    block->next->prev = block;
+  free_lists_[order] = block;
+  free_block_heads_->setBit(ppn);
+  ++num_free_blocks_[order];
+  num_free_pages_ += 1 << order;
+}
+
+void PageManager::removeFreeBlock(FreeBlock* block)
+{
+  if (block->prev)
+    block->prev->next = block->next;
+  else
+    free_lists_[block->order] = block->next;
+  if (block->next)
+    block->next->prev = block->prev;
+  free_block_heads_->unsetBit(block->ppn);
+  --num_free_blocks_[block->order];
+  num_free_pages_ -= 1 << block->order;
+}
+
+size_t PageManager::pageSizeToOrder(size_t page_size)
+{
+  assert((page_size % PAGE_SIZE) == 0);
+  size_t num_pages = page_size / PAGE_SIZE;
+  assert(num_pages && (num_pages & (num_pages - 1)) == 0 && "page size has to be a power of two");
+  size_t order = __builtin_ctzl(num_pages);
+  assert(order <= MAX_ORDER && "page size too large for the buddy allocator");
+  return order;
+}
+
+void PageManager::printUsage()
+{
+  kprintfd("PageManager: %zu of %u pages free\n", getNumFreePages(), number_of_pages_);
+  for (size_t order = 0; order <= MAX_ORDER; ++order)
+    kprintfd("  order %2zu (%5zu KiB): %6zu free blocks\n", order, (size_t)(PAGE_SIZE << order) / 1024,
+             num_free_blocks_[order]);
+  kprintfd("  zero pool: %zu of %zu pages, %zu hits, %zu misses\n", zero_pool_count_, ZERO_POOL_SIZE,
+           zero_pool_hits_, zero_pool_misses_);
+  for (size_t cpu = 0; cpu < ArchMulticore::numCpus(); ++cpu)
+    kprintfd("  magazine of cpu %zu: %zu pages\n", cpu, magazines_[cpu].count);
+  kprintfd("  lock taken %zu times\n", lock_acquisitions_);
+  kprintfd("  %zu shared pages copied on write\n", num_copied_frames_);
+}
+
+void PageManager::selfCheck()
+{
+  size_t ppns[MAX_ORDER + 1][2];
+  size_t free_before = getNumFreePages();
+  size_t max_order = 0;
+  while (max_order < MAX_ORDER && (8U << (max_order + 1)) <= free_before)
+    ++max_order;
+
+  for (size_t order = 0; order <= max_order; ++order)
+  {
+    for (size_t i = 0; i < 2; ++i)
+    {
+      size_t ppn = allocPPN(PAGE_SIZE << order);
+      assert((ppn & ((1U << order) - 1)) == 0 && "PageManager::selfCheck: block is not aligned to its size");
+      for (size_t p = 0; p < (1U << order); ++p)
+      {
+        size_t* page = (size_t*)ArchMemory::getIdentAddressOfPPN(ppn + p);
+        assert(*page == 0 && page[PAGE_SIZE / sizeof(size_t) - 1] == 0 && "PageManager::selfCheck: block is not zeroed");
+        *page = ppn;
+      }
+      ppns[order][i] = ppn;
+    }
+  }
+
+  // a block overlapping another one has overwritten some of its tags
+  for (size_t order = 0; order <= max_order; ++order)
+  {
+    for (size_t i = 0; i < 2; ++i)
+    {
+      for (size_t p = 0; p < (1U << order); ++p)
+        assert(*(size_t*)ArchMemory::getIdentAddressOfPPN(ppns[order][i] + p) == ppns[order][i] &&
+               "PageManager::selfCheck: blocks overlap");
+    }
+  }
+
+  for (size_t order = 0; order <= max_order; ++order)
+  {
+    freePPN(ppns[order][0], PAGE_SIZE << order);
+    // the second block is freed in two halves, they have to be merged again
+    if (order)
+    {
+      freePPN(ppns[order][1] + (1U << (order - 1)), PAGE_SIZE << (order - 1));
+      freePPN(ppns[order][1], PAGE_SIZE << (order - 1));
+    }
+    else
+      freePPN(ppns[order][1]);
+  }
+  assert(getNumFreePages() == free_before && "PageManager::selfCheck: pages got lost");
+
+  // the halves of the largest blocks have been merged again, so that order is available once more
+  size_t ppn = allocPPN(PAGE_SIZE << max_order, ALLOC_NO_ZERO | ALLOC_MAY_FAIL);
+  assert(ppn && "PageManager::selfCheck: freed blocks have not been merged");
+  freePPN(ppn, PAGE_SIZE << max_order);
+  debug(PM, "selfCheck: blocks up to order %zu passed\n", max_order);
+}
@@ -0,0 +1,141 @@
+#include "TextPageCache.h"
+#include "PageManager.h"
+#include "Thread.h"
+#include "Inode.h"
+#include "kprintf.h"
+#include "assert.h"
+#include "debug.h"
+
+const size_t TextPageCache::MAX_PAGES;
+const size_t TextPageCache::NUM_BUCKETS;
+
+TextPageCache* TextPageCache::instance_ = 0;
+
+TextPageCache* TextPageCache::instance()
+{
+  if (unlikely(!instance_))
+    instance_ = new TextPageCache();
+  return instance_;
+}
+
+TextPageCache::TextPageCache() : num_pages_(0), hits_(0), misses_(0), lock_("TextPageCache::lock_")
+{
+  for (size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+    buckets_[bucket] = 0;
+}
+
+size_t TextPageCache::bucketOf(Inode* inode, size_t virtual_page)
+{
+  return (((size_t)inode / sizeof(size_t)) ^ (virtual_page * 2654435761U)) % NUM_BUCKETS;
+}
+
+size_t TextPageCache::acquire(Inode* inode, size_t virtual_page)
+{
+  MutexLock lock(lock_);
+  for (Entry* entry = buckets_[bucketOf(inode, virtual_page)]; entry; entry = entry->next)
+  {
+    if (entry->inode == inode && entry->virtual_page == virtual_page)
+    {
+      // sharing it while holding the lock keeps the page from being evicted meanwhile
+      PageManager::instance()->shareFrame(entry->ppn);
+      ++hits_;
+      return entry->ppn;
+    }
+  }
+  ++misses_;
+  return 0;
+}
+
+size_t TextPageCache::insert(Inode* inode, size_t virtual_page, size_t ppn)
+{
+  MutexLock lock(lock_);
+  Entry*& bucket = buckets_[bucketOf(inode, virtual_page)];
+  for (Entry* entry = bucket; entry; entry = entry->next)
+  {
+    if (entry->inode == inode && entry->virtual_page == virtual_page)
+    {
+      debug(LOADER, "TextPageCache::insert: page %zx has been loaded concurrently\n", virtual_page);
+      PageManager::instance()->shareFrame(entry->ppn);
+      PageManager::instance()->freePPN(ppn);
+      return entry->ppn;
+    }
+  }
+
+  if (num_pages_ >= MAX_PAGES)
+    evictUnused();
+  if (num_pages_ >= MAX_PAGES)
+    return ppn; // every cached page is still mapped somewhere, this one stays private
+
+  bucket = new Entry{bucket, inode, virtual_page, ppn};
+  ++inode->i_text_pages_;
+  ++num_pages_;
+  PageManager::instance()->shareFrame(ppn);
+  return ppn;
+}
+
+void TextPageCache::dropInode(Inode* inode)
+{
+  MutexLock lock(lock_);
+  // most inodes written to or destroyed never were a binary
+  for (size_t bucket = 0; bucket < NUM_BUCKETS && inode->i_text_pages_; ++bucket)
+  {
+    Entry** link = &buckets_[bucket];
+    while (*link)
+    {
+      Entry* entry = *link;
+      if (entry->inode != inode)
+      {
+        link = &entry->next;
+        continue;
+      }
+      *link = entry->next;
+      PageManager::instance()->freePPN(entry->ppn);
+      delete entry;
+      --inode->i_text_pages_;
+      --num_pages_;
+    }
+  }
+}
+
+void TextPageCache::evictUnused()
+{
+  assert(lock_.isHeldBy(currentThread));
+  size_t evicted = 0;
+  for (size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+  {
+    Entry** link = &buckets_[bucket];
+    while (*link)
+    {
+      Entry* entry = *link;
+      // new users only come through acquire, which needs the lock, so the page stays unused
+      if (PageManager::instance()->getShareCount(entry->ppn))
+      {
+        link = &entry->next;
+        continue;
+      }
+      *link = entry->next;
+      PageManager::instance()->freePPN(entry->ppn);
+      --entry->inode->i_text_pages_;
+      delete entry;
+      --num_pages_;
+      ++evicted;
+    }
+  }
+  debug(LOADER, "TextPageCache::evictUnused: evicted %zu pages, %zu left\n", evicted, num_pages_);
+}
+
+size_t TextPageCache::getHits() const
+{
+  return hits_;
+}
+
+size_t TextPageCache::getMisses() const
+{
+  return misses_;
+}
+
+void TextPageCache::printStatistics()
+{
+  kprintfd("TextPageCache: %zu of %zu pages cached, %zu hits, %zu misses\n", num_pages_, MAX_PAGES, hits_,
+           misses_);
+}
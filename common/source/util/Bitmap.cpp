@@ -1,6 +1,7 @@
 #include "Bitmap.h"
 #include "kprintf.h"
 #include "assert.h"
+#include "bitops.h"
 
 uint8 const Bitmap::bits_per_bitmap_atom_ = 8;
 
@@ -15,16 +16,23 @@ static const uint8 BIT_COUNT[] =
 4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8
 };
 
-Bitmap::Bitmap(size_t number_of_bits) :
+#define BITS_PER_WORD 64
+#define NUM_WORDS(number_of_bits) ((number_of_bits + BITS_PER_WORD - 1) / BITS_PER_WORD)
+
+Bitmap::Bitmap(size_t number_of_bits, bool with_summary) :
         size_(number_of_bits),
-        num_bits_set_(0)
+        num_bits_set_(0),
+        summary_(0)
 {
   bitmap_ = new uint8[BITMAP_BYTE_COUNT(number_of_bits)]{};
+  if (with_summary)
+    summary_ = new uint8[BITMAP_BYTE_COUNT(NUM_WORDS(number_of_bits))]{};
 }
 
 Bitmap::~Bitmap()
 {
   delete[] bitmap_;
+  delete[] summary_;
 }
 
 #define BYTE (b[bit_number / bits_per_bitmap_atom_])
@@ -33,7 +41,10 @@ Bitmap::~Bitmap()
 bool Bitmap::setBit(size_t bit_number)
 {
   assert(bit_number < size_);
-  return setBit(bitmap_, num_bits_set_, bit_number);
+  bool changed = setBit(bitmap_, num_bits_set_, bit_number);
+  if (changed && summary_)
+    updateSummary(bit_number);
+  return changed;
 }
 
 bool Bitmap::setBit(uint8* b, size_t& num_bits_set, size_t bit_number)
@@ -62,7 +73,13 @@ bool Bitmap::getBit(uint8* b, size_t bit_number)
 bool Bitmap::unsetBit(size_t bit_number)
 {
   assert(bit_number < size_);
-  return unsetBit(bitmap_, num_bits_set_, bit_number);
+  bool changed = unsetBit(bitmap_, num_bits_set_, bit_number);
+  if (changed && summary_)
+  {
+    size_t unused;
+    unsetBit(summary_, unused, bit_number / BITS_PER_WORD);
+  }
+  return changed;
 }
 
 bool Bitmap::unsetBit(uint8* b, size_t& num_bits_set, size_t bit_number)
@@ -84,6 +101,8 @@ void Bitmap::setByte(size_t byte_number, uint8 byte)
   num_bits_set_ -= BIT_COUNT[b];
   num_bits_set_ += BIT_COUNT[byte];
   b = byte;
+  if (summary_)
+    updateSummary(byte_number * bits_per_bitmap_atom_);
 }
 
 uint8 Bitmap::getByte(size_t byte_number)
@@ -114,6 +133,92 @@ void Bitmap::bmprint(uint8* b, size_t n, size_t num_bits_set)
   kprintfd("\n----------------------------------Bitmap:end----------------------------------\n");
 }
 
+uint64 Bitmap::getWord(const uint8* b, size_t num_bits, size_t word_number)
+{
+  size_t first_byte = word_number * (BITS_PER_WORD / 8);
+  size_t num_bytes = BITMAP_BYTE_COUNT(num_bits) - first_byte;
+  uint64 word = 0;
+  if (num_bytes >= BITS_PER_WORD / 8)
+    __builtin_memcpy(&word, b + first_byte, sizeof(word)); // all architectures are little endian
+  else
+  {
+    for (size_t i = 0; i < num_bytes; ++i)
+      word |= (uint64)b[first_byte + i] << (8 * i);
+  }
+  size_t valid_bits = num_bits - word_number * BITS_PER_WORD;
+  if (valid_bits < BITS_PER_WORD)
+    word &= (1ULL << valid_bits) - 1;
+  return word;
+}
+
+size_t Bitmap::findFirstClear(const uint8* b, size_t num_bits, size_t start)
+{
+  if (start >= num_bits)
+    return num_bits;
+  size_t word_number = start / BITS_PER_WORD;
+  uint64 clear_bits = ~getWord(b, num_bits, word_number) & (~0ULL << (start % BITS_PER_WORD));
+  while (!clear_bits)
+  {
+    if (++word_number >= NUM_WORDS(num_bits))
+      return num_bits;
+    clear_bits = ~getWord(b, num_bits, word_number);
+  }
+  // the bits beyond num_bits read as clear
+  size_t bit_number = word_number * BITS_PER_WORD + ctz64(clear_bits);
+  return bit_number < num_bits ? bit_number : num_bits;
+}
+
+size_t Bitmap::findFirstClear(size_t start)
+{
+  if (!summary_ || start >= size_)
+    return findFirstClear(bitmap_, size_, start);
+
+  size_t word_number = start / BITS_PER_WORD;
+  uint64 clear_bits = ~getWord(bitmap_, size_, word_number) & (~0ULL << (start % BITS_PER_WORD));
+  if (!clear_bits)
+  {
+    // the first word which is not full according to the summary has a clear bit
+    word_number = findFirstClear(summary_, NUM_WORDS(size_), word_number + 1);
+    if (word_number >= NUM_WORDS(size_))
+      return size_;
+    clear_bits = ~getWord(bitmap_, size_, word_number);
+  }
+  size_t bit_number = word_number * BITS_PER_WORD + ctz64(clear_bits);
+  return bit_number < size_ ? bit_number : size_;
+}
+
+size_t Bitmap::findNextSet(const uint8* b, size_t num_bits, size_t start)
+{
+  if (start >= num_bits)
+    return num_bits;
+  size_t word_number = start / BITS_PER_WORD;
+  uint64 set_bits = getWord(b, num_bits, word_number) & (~0ULL << (start % BITS_PER_WORD));
+  while (!set_bits)
+  {
+    if (++word_number >= NUM_WORDS(num_bits))
+      return num_bits;
+    set_bits = getWord(b, num_bits, word_number);
+  }
+  return word_number * BITS_PER_WORD + ctz64(set_bits);
+}
+
+size_t Bitmap::findNextSet(size_t start)
+{
+  return findNextSet(bitmap_, size_, start);
+}
+
+void Bitmap::updateSummary(size_t bit_number)
+{
+  size_t word_number = bit_number / BITS_PER_WORD;
+  size_t valid_bits = size_ - word_number * BITS_PER_WORD;
+  uint64 full = valid_bits >= BITS_PER_WORD ? ~0ULL : (1ULL << valid_bits) - 1;
+  size_t unused;
+  if (getWord(bitmap_, size_, word_number) == full)
+    setBit(summary_, unused, word_number);
+  else
+    unsetBit(summary_, unused, word_number);
+}
+
 size_t Bitmap::getSize()
 {
   return size_;
@@ -16,6 +16,40 @@ extern "C" {
  */ 
 extern int createprocess(const char* path, int sleep);
 
+#define LOAD_MODE_FAULT_AROUND 0
+#define LOAD_MODE_SINGLE_PAGE 1
+#define LOAD_MODE_PREFAULT 2
+
+/**
+ * Creates a new process like createprocess, which loads its binary in the given mode.
+ * A page fault in the binary loads the pages of the same segment around the faulting one,
+ * only the faulting page, or the whole segment if it is small.
+ *
+ * @param path the path to the binary to open
+ * @param sleep whether the calling process should sleep until the other process terminated
+ * @param load_mode one of the LOAD_MODE_* values
+ * @return -1 if the path did not lead to an executable or the mode is invalid, 0 otherwise
+ *
+ */
+extern int createprocessmode(const char* path, int sleep, int load_mode);
+
+#define SCHED_CLASS_REALTIME 0
+#define SCHED_CLASS_NORMAL 1
+#define SCHED_CLASS_IDLE 2
+#define SCHED_PRIORITY_LEVELS 8
+
+/**
+ * Changes the scheduling class and priority of the calling thread.
+ * Normal threads share the cpu weighted by their priority, idle threads only run if
+ * nothing else is runnable. SCHED_CLASS_REALTIME is reserved for kernel threads.
+ *
+ * @param sched_class SCHED_CLASS_NORMAL or SCHED_CLASS_IDLE
+ * @param priority priority within the class, 0 (most important) to SCHED_PRIORITY_LEVELS - 1
+ * @return 0 on success, -1 if the class or priority is invalid
+ *
+ */
+extern int sched_setclass(int sched_class, int priority);
+
 #ifdef __cplusplus
 }
 #endif
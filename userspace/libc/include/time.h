@@ -6,13 +6,71 @@ extern "C" {
 
 #define CLOCKS_PER_SEC 1000000
 
+/**
+ * clocks for clock_gettime, keep in sync with the kernel's Syscall.h
+ */
+#define CLOCK_MONOTONIC 1
+#define CLOCK_THREAD_CPUTIME_ID 3
+
 #ifndef CLOCK_T_DEFINED
 #define CLOCK_T_DEFINED
 typedef unsigned int clock_t;
 #endif // CLOCK_T_DEFINED
 
+#ifndef TIME_T_DEFINED
+#define TIME_T_DEFINED
+typedef long time_t;
+#endif // TIME_T_DEFINED
+
+typedef int clockid_t;
+
+struct timespec
+{
+  time_t tv_sec;
+  long tv_nsec;
+};
+
+/**
+ * Returns the processor time used by the calling thread.
+ *
+ * @return the time in CLOCKS_PER_SEC units, -1 on error
+ *
+ */
 extern clock_t clock(void);
 
+/**
+ * Suspends the calling thread for at least the given time. The thread does
+ * not consume any processor time meanwhile.
+ *
+ * @param req the time to sleep, tv_nsec has to be in the range 0 to 999999999
+ * @param rem if not NULL, receives the remaining time in case of an interruption (always 0 in SWEB)
+ * @return 0 on success, -1 if req is invalid
+ *
+ */
+extern int nanosleep(const struct timespec *req, struct timespec *rem);
+
+/**
+ * Retrieves the time of the given clock.
+ * CLOCK_MONOTONIC counts from boot and never goes backwards,
+ * CLOCK_THREAD_CPUTIME_ID is the processor time used by the calling thread.
+ *
+ * @param clk_id the clock to read
+ * @param tp receives the time
+ * @return 0 on success, -1 if the clock is not supported
+ *
+ */
+extern int clock_gettime(clockid_t clk_id, struct timespec *tp);
+
+/**
+ * Non standard helper for measurements, e.g. between two calls of clock_gettime.
+ *
+ * @param start the earlier point in time
+ * @param end the later point in time
+ * @return the time from start to end in microseconds
+ *
+ */
+extern long timespec_elapsed_us(const struct timespec *start, const struct timespec *end);
+
 #ifdef __cplusplus
 }
 #endif
@@ -32,7 +32,7 @@ int link(const char *old_path, const char *new_path)
  */
 int unlink(const char *path)
 {
-  return -1;
+  return __syscall(sc_unlink, (long) path, 0x00, 0x00, 0x00, 0x00);
 }
 
 
@@ -8,6 +8,16 @@ int createprocess(const char* path, int sleep)
   return __syscall(sc_createprocess, (long) path, sleep, 0x00, 0x00, 0x00);
 }
 
+int createprocessmode(const char* path, int sleep, int load_mode)
+{
+  return __syscall(sc_createprocess, (long) path, sleep, load_mode, 0x00, 0x00);
+}
+
+int sched_setclass(int sched_class, int priority)
+{
+  return __syscall(sc_sched_setclass, sched_class, priority, 0x00, 0x00, 0x00);
+}
+
 extern int main();
 
 void _start()
@@ -1,12 +1,157 @@
 #include "stdlib.h"
+#include "string.h"
+#include "unistd.h"
+#include "assert.h"
 
-void *malloc(size_t size)
+/**
+ * Every chunk starts with a header which keeps its usable size. Chunks of up to
+ * MAX_CLASS_SIZE bytes are rounded up to a size class and recycled through one free list
+ * per class, so malloc and free do not have to search for them. The classes are finely
+ * graded up to 4 KiB and powers of two above. Even larger chunks are kept in a first fit
+ * list. New chunks are carved from the top of the heap, which grows with sbrk and shrinks
+ * again once a lot is free at its end.
+ * There are no threads in userspace yet, so nothing is locked.
+ */
+
+#define ALIGNMENT 16
+#define ALIGN_UP(size) (((size) + ALIGNMENT - 1) & ~((size_t) ALIGNMENT - 1))
+
+#define MAX_CLASS_SIZE (1024 * 1024)
+#define NUM_SIZE_CLASSES 24
+#define HEAP_GROWTH (64 * 1024)
+#define HEAP_TRIM_THRESHOLD (4 * HEAP_GROWTH)
+
+#define CHUNK_USED 0x5EB0A110
+#define CHUNK_FREE 0x5EB0F4EE
+
+typedef struct chunk
+{
+  size_t size;
+  size_t magic;
+  struct chunk* next_free;
+} __attribute__((aligned(ALIGNMENT))) chunk_t;
+
+// the free list pointer is only used while the chunk is free, so it overlaps the user data
+#define CHUNK_HEADER_SIZE ALIGN_UP(2 * sizeof(size_t))
+#define CHUNK_DATA(chunk) ((void*) ((char*) (chunk) + CHUNK_HEADER_SIZE))
+#define DATA_CHUNK(data) ((chunk_t*) ((char*) (data) - CHUNK_HEADER_SIZE))
+
+static const size_t size_classes[NUM_SIZE_CLASSES] =
 {
+  16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096,
+  8192, 16384, 32768, 65536, 131072, 262144, 524288, 1048576
+};
+
+static chunk_t* class_free_lists[NUM_SIZE_CLASSES];
+static chunk_t* large_free_list;
+
+/**
+ * the part of the heap which has not been handed out yet
+ */
+static char* heap_top;
+static char* heap_end;
+
+static size_t sizeClass(size_t size)
+{
+  size_t size_class = 0;
+  while (size_classes[size_class] < size)
+    ++size_class;
+  return size_class;
+}
+
+static int growHeap(size_t needed)
+{
+  size_t increment = (needed + ALIGNMENT + HEAP_GROWTH - 1) & ~((size_t) HEAP_GROWTH - 1);
+  char* old_break = sbrk(increment);
+  if (old_break == (char*) -1)
+    return -1;
+  // somebody else moved the break, the rest of the old top is lost
+  if (old_break != heap_end)
+    heap_top = (char*) ALIGN_UP((size_t) old_break);
+  heap_end = old_break + increment;
   return 0;
 }
 
+static chunk_t* carveChunk(size_t size)
+{
+  size_t total = CHUNK_HEADER_SIZE + size;
+  if ((size_t) (heap_end - heap_top) < total && growHeap(total) != 0)
+    return 0;
+  chunk_t* chunk = (chunk_t*) heap_top;
+  heap_top += total;
+  chunk->size = size;
+  return chunk;
+}
+
+static chunk_t* takeLargeChunk(size_t size)
+{
+  chunk_t** link = &large_free_list;
+  while (*link && (*link)->size < size)
+    link = &(*link)->next_free;
+  chunk_t* chunk = *link;
+  if (chunk)
+    *link = chunk->next_free;
+  return chunk;
+}
+
+static void trimHeap()
+{
+  char* new_end = (char*) (((size_t) heap_top + HEAP_GROWTH - 1) & ~((size_t) HEAP_GROWTH - 1));
+  if (heap_end - new_end >= HEAP_TRIM_THRESHOLD && brk(new_end) == 0)
+    heap_end = new_end;
+}
+
+void *malloc(size_t size)
+{
+  chunk_t* chunk;
+  if (size <= MAX_CLASS_SIZE)
+  {
+    size_t size_class = sizeClass(size);
+    chunk = class_free_lists[size_class];
+    if (chunk)
+      class_free_lists[size_class] = chunk->next_free;
+    else
+      chunk = carveChunk(size_classes[size_class]);
+  }
+  else
+  {
+    if (size > (size_t) -1 / 2)
+      return 0;
+    size = ALIGN_UP(size);
+    chunk = takeLargeChunk(size);
+    if (!chunk)
+      chunk = carveChunk(size);
+  }
+  if (!chunk)
+    return 0;
+  chunk->magic = CHUNK_USED;
+  return CHUNK_DATA(chunk);
+}
+
 void free(void *ptr)
 {
+  if (!ptr)
+    return;
+  chunk_t* chunk = DATA_CHUNK(ptr);
+  assert(chunk->magic == CHUNK_USED && "free of a pointer which was not returned by malloc or is already free");
+  chunk->magic = CHUNK_FREE;
+
+  if (chunk->size <= MAX_CLASS_SIZE)
+  {
+    size_t size_class = sizeClass(chunk->size);
+    chunk->next_free = class_free_lists[size_class];
+    class_free_lists[size_class] = chunk;
+  }
+  else if ((char*) CHUNK_DATA(chunk) + chunk->size == heap_top)
+  {
+    heap_top = (char*) chunk;
+    trimHeap();
+  }
+  else
+  {
+    chunk->next_free = large_free_list;
+    large_free_list = chunk;
+  }
 }
 
 int atexit(void (*function)(void))
@@ -16,10 +161,31 @@ int atexit(void (*function)(void))
 
 void *calloc(size_t nmemb, size_t size)
 {
-  return 0;
+  if (size && nmemb > (size_t) -1 / size)
+    return 0;
+  void* ptr = malloc(nmemb * size);
+  if (ptr)
+    memset(ptr, 0, nmemb * size);
+  return ptr;
 }
 
 void *realloc(void *ptr, size_t size)
 {
-  return 0;
+  if (!ptr)
+    return malloc(size);
+  if (size == 0)
+  {
+    free(ptr);
+    return 0;
+  }
+  chunk_t* chunk = DATA_CHUNK(ptr);
+  assert(chunk->magic == CHUNK_USED && "realloc of a pointer which was not returned by malloc or is already free");
+  if (size <= chunk->size)
+    return ptr;
+  void* new_ptr = malloc(size);
+  if (!new_ptr)
+    return 0;
+  memcpy(new_ptr, ptr, chunk->size);
+  free(ptr);
+  return new_ptr;
 }
@@ -1,11 +1,36 @@
 #include "time.h"
+#include "sys/syscall.h"
+#include "../../../common/include/kernel/syscall-definitions.h"
 
 
 /**
- * function stub
  * posix compatible signature - do not change the signature!
  */
 clock_t clock(void)
 {
-  return (clock_t) -1U;
+  struct timespec tp;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &tp) != 0)
+    return (clock_t) -1U;
+  return (clock_t) (tp.tv_sec * CLOCKS_PER_SEC + tp.tv_nsec / (1000000000 / CLOCKS_PER_SEC));
+}
+
+/**
+ * posix compatible signature - do not change the signature!
+ */
+int nanosleep(const struct timespec *req, struct timespec *rem)
+{
+  return __syscall(sc_nanosleep, (long) req, (long) rem, 0x00, 0x00, 0x00);
+}
+
+/**
+ * posix compatible signature - do not change the signature!
+ */
+int clock_gettime(clockid_t clk_id, struct timespec *tp)
+{
+  return __syscall(sc_clock_gettime, clk_id, (long) tp, 0x00, 0x00, 0x00);
+}
+
+long timespec_elapsed_us(const struct timespec *start, const struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000000L + (end->tv_nsec - start->tv_nsec) / 1000;
 }
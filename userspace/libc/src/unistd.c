@@ -1,32 +1,42 @@
 #include "unistd.h"
+#include "time.h"
+#include "sys/syscall.h"
 
 
 /**
- * function stub
  * posix compatible signature - do not change the signature!
  */
 int brk(void *end_data_segment)
 {
-  return -1;
+  // the kernel returns the resulting break, it stays unchanged if the request was invalid
+  if (__syscall(sc_brk, (size_t) end_data_segment, 0x00, 0x00, 0x00, 0x00) != (size_t) end_data_segment)
+    return -1;
+  return 0;
 }
 
 /**
- * function stub
  * posix compatible signature - do not change the signature!
  */
 void* sbrk(intptr_t increment)
 {
-  return (void*) -1;
+  size_t old_break = __syscall(sc_brk, 0x00, 0x00, 0x00, 0x00, 0x00);
+  if (increment == 0)
+    return (void*) old_break;
+  if (brk((void*) (old_break + increment)) != 0)
+    return (void*) -1;
+  return (void*) old_break;
 }
 
 
 /**
- * function stub
  * posix compatible signature - do not change the signature!
  */
 unsigned int sleep(unsigned int seconds)
 {
-  return -1U;
+  struct timespec duration = { seconds, 0 };
+  if (nanosleep(&duration, 0) != 0)
+    return seconds;
+  return 0;
 }
 
 
@@ -0,0 +1,108 @@
+#include "stdio.h"
+#include "fcntl.h"
+#include "string.h"
+#include "time.h"
+#include "unistd.h"
+
+#define FILES 10000
+#define PREFIX "/dentries"
+
+static void fileName(char* path, int number)
+{
+  char digits[12];
+  int length = 0;
+  do
+  {
+    digits[length++] = '0' + number % 10;
+    number /= 10;
+  } while (number);
+
+  memcpy(path, PREFIX, sizeof(PREFIX) - 1);
+  path += sizeof(PREFIX) - 1;
+  while (length)
+    *path++ = digits[--length];
+  *path = 0;
+}
+
+/**
+ * creates a lot of files in one directory and opens each of them again. Every create and
+ * every open looks the name up in the children of the directory, these should not take
+ * longer the more files the directory holds. F9 shows the hits of the dentry cache.
+ * The files are removed again at the end, so the test can be run repeatedly.
+ */
+int main()
+{
+  char path[32];
+  struct timespec start, end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < FILES; ++i)
+  {
+    fileName(path, i);
+    int fd = open(path, O_CREAT | O_RDWR);
+    if (fd < 0)
+    {
+      printf("dentries: could not create %s\n", path);
+      return -1;
+    }
+    close(fd);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  long us = timespec_elapsed_us(&start, &end);
+  printf("dentries: creating %d files took %ld us, %ld us per file\n", FILES, us, us / FILES);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = FILES - 1; i >= 0; --i)
+  {
+    fileName(path, i);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+      printf("dentries: FAILED, %s not found\n", path);
+      return -1;
+    }
+    close(fd);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  us = timespec_elapsed_us(&start, &end);
+  printf("dentries: looking them up took %ld us, %ld ns per file\n", us, us * 1000 / FILES);
+
+  // the first miss asks the file system, the others should be answered by the dentry cache
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < FILES; ++i)
+  {
+    if (open(PREFIX, O_RDONLY) >= 0)
+    {
+      printf("dentries: FAILED, found a file which was never created\n");
+      return -1;
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  us = timespec_elapsed_us(&start, &end);
+  printf("dentries: looking up a missing file %d times took %ld us, %ld ns per lookup\n", FILES, us,
+         us * 1000 / FILES);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < FILES; ++i)
+  {
+    fileName(path, i);
+    if (unlink(path))
+    {
+      printf("dentries: FAILED, could not remove %s\n", path);
+      return -1;
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  us = timespec_elapsed_us(&start, &end);
+  printf("dentries: removing them took %ld us, %ld us per file\n", us, us / FILES);
+
+  // removing a file drops its cached dentry, it must not be found afterwards
+  fileName(path, FILES / 2);
+  if (open(path, O_RDONLY) >= 0)
+  {
+    printf("dentries: FAILED, found %s after removing it\n", path);
+    return -1;
+  }
+  printf("dentries: all files found and removed\n");
+  return 0;
+}
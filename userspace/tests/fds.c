@@ -0,0 +1,67 @@
+#include "stdio.h"
+#include "fcntl.h"
+#include "string.h"
+#include "time.h"
+#include "unistd.h"
+
+#define FILES 64
+#define READS 100000
+#define PREFIX "/fds"
+
+static void fileName(char* path, int number)
+{
+  memcpy(path, PREFIX, sizeof(PREFIX) - 1);
+  path += sizeof(PREFIX) - 1;
+  *path++ = '0' + number / 10;
+  *path++ = '0' + number % 10;
+  *path = 0;
+}
+
+/**
+ * every process numbers its open files itself, a new file gets the lowest free fd. Reading
+ * from one of many open files should take as long as reading from the only one.
+ */
+int main()
+{
+  char path[16];
+  int fds[FILES];
+  char buffer[1];
+  struct timespec start, end;
+
+  for (int i = 0; i < FILES; ++i)
+  {
+    fileName(path, i);
+    fds[i] = open(path, O_CREAT | O_RDWR);
+    if (fds[i] != i + 3)
+    {
+      printf("fds: FAILED, %s got fd %d instead of %d\n", path, fds[i], i + 3);
+      return -1;
+    }
+  }
+
+  close(fds[FILES / 2]);
+  int fd = open(PREFIX "00", O_RDONLY);
+  if (fd != fds[FILES / 2])
+  {
+    printf("fds: FAILED, got fd %d instead of the closed %d\n", fd, fds[FILES / 2]);
+    return -1;
+  }
+  fds[FILES / 2] = fd;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < READS; ++i)
+    read(fds[FILES - 1], buffer, sizeof(buffer));
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  long us = timespec_elapsed_us(&start, &end);
+  printf("fds: %d reads with %d open files took %ld us, %ld ns per read\n", READS, FILES, us, us * 1000 / READS);
+
+  for (int i = 0; i < FILES; ++i)
+    close(fds[i]);
+  if (close(fds[0]) == 0)
+  {
+    printf("fds: FAILED, closed fd %d twice\n", fds[0]);
+    return -1;
+  }
+  printf("fds: fds are numbered per process\n");
+  return 0;
+}
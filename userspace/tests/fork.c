@@ -0,0 +1,86 @@
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "time.h"
+#include "unistd.h"
+
+#define HEAP_SIZE (8 * 1024 * 1024)
+#define PAGE_SIZE 4096
+#define ROUNDS 4
+
+static int checkHeap(char* heap, char value)
+{
+  for (size_t offset = 0; offset < HEAP_SIZE; offset += PAGE_SIZE)
+  {
+    if (heap[offset] != value)
+      return -1;
+  }
+  return 0;
+}
+
+/**
+ * writes one byte to every page, with copy-on-write each of these writes copies a page
+ */
+static long writeHeap(char* heap, char value)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (size_t offset = 0; offset < HEAP_SIZE; offset += PAGE_SIZE)
+    heap[offset] = value;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return timespec_elapsed_us(&start, &end);
+}
+
+int main()
+{
+  struct timespec start, end;
+  struct timespec child_runtime = {0, 200 * 1000 * 1000};
+
+  char* heap = malloc(HEAP_SIZE);
+  if (!heap)
+  {
+    printf("fork: out of memory\n");
+    return -1;
+  }
+  memset(heap, 1, HEAP_SIZE);
+
+  int failed = 0;
+  for (int round = 0; round < ROUNDS; ++round)
+  {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      if (checkHeap(heap, 1 + round))
+      {
+        printf("fork: the child does not see the heap of its parent\n");
+        exit(-1);
+      }
+      long write_us = writeHeap(heap, 100 + round);
+      printf("fork: child wrote %d pages in %ld us\n", HEAP_SIZE / PAGE_SIZE, write_us);
+      exit(0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (pid < 0)
+    {
+      printf("fork: fork failed\n");
+      return -1;
+    }
+    printf("fork: forked a process with a %d KiB heap in %ld us\n", HEAP_SIZE / 1024,
+           timespec_elapsed_us(&start, &end));
+
+    // let the child copy its pages and exit, the parent is the last user of its pages afterwards
+    nanosleep(&child_runtime, 0);
+    if (checkHeap(heap, 1 + round))
+    {
+      printf("fork: the writes of the child changed the heap of its parent\n");
+      failed = -1;
+    }
+    long write_us = writeHeap(heap, 2 + round);
+    printf("fork: parent wrote %d pages in %ld us\n", HEAP_SIZE / PAGE_SIZE, write_us);
+  }
+
+  free(heap);
+  printf("fork: %s\n", failed ? "FAILED" : "all heaps intact");
+  return failed;
+}
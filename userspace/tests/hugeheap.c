@@ -0,0 +1,64 @@
+#include "stdio.h"
+#include "stdlib.h"
+#include "time.h"
+#include "unistd.h"
+
+#define HEAP_SIZE (32 * 1024 * 1024)
+#define PAGE_SIZE 4096
+#define PASSES 16
+
+static long touchHeap(char* heap, char value)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (size_t offset = 0; offset < HEAP_SIZE; offset += PAGE_SIZE)
+    heap[offset] = value;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return timespec_elapsed_us(&start, &end);
+}
+
+/**
+ * a large heap is mapped with huge pages where it covers them completely. The first pass
+ * shows the page faults, the later ones the TLB misses. The child of a fork and shrinking
+ * the heap split the huge pages again, the contents have to survive that.
+ */
+int main()
+{
+  struct timespec child_runtime = {0, 500 * 1000 * 1000};
+  char* heap = malloc(HEAP_SIZE);
+  if (!heap)
+  {
+    printf("hugeheap: out of memory\n");
+    return -1;
+  }
+
+  printf("hugeheap: first touch of %d pages took %ld us\n", HEAP_SIZE / PAGE_SIZE, touchHeap(heap, 1));
+  long us = 0;
+  for (int pass = 0; pass < PASSES; ++pass)
+    us += touchHeap(heap, 2);
+  printf("hugeheap: touching them again took %ld us per pass\n", us / PASSES);
+
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    touchHeap(heap, 3);
+    exit(0);
+  }
+  if (pid < 0)
+  {
+    printf("hugeheap: fork failed\n");
+    return -1;
+  }
+  // there is no waitpid yet, let the child write its copy and exit
+  nanosleep(&child_runtime, 0);
+
+  int failed = 0;
+  for (size_t offset = 0; offset < HEAP_SIZE; offset += PAGE_SIZE)
+  {
+    if (heap[offset] != 2)
+      failed = -1;
+  }
+  free(heap);
+  printf("hugeheap: %s\n", failed ? "FAILED, the child changed the heap" : "heap intact");
+  return failed;
+}
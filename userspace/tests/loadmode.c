@@ -0,0 +1,30 @@
+#include "stdio.h"
+#include "time.h"
+#include "nonstd.h"
+
+#define BINARY "/usr/mult.sweb"
+
+/**
+ * runs the same binary in every load mode, the kernel log shows the page faults of each run
+ * (see ~Loader), the times here include loading, running and destroying the process
+ */
+int main()
+{
+  const char* mode_names[] = { "fault-around", "single page", "prefault" };
+  int modes[] = { LOAD_MODE_SINGLE_PAGE, LOAD_MODE_FAULT_AROUND, LOAD_MODE_PREFAULT };
+  struct timespec start, end;
+
+  for (int i = 0; i < 3; ++i)
+  {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (createprocessmode(BINARY, 1, modes[i]))
+    {
+      printf("loadmode: could not run %s\n", BINARY);
+      return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("loadmode: %s with %s loading took %ld us\n", BINARY, mode_names[modes[i]],
+           timespec_elapsed_us(&start, &end));
+  }
+  return 0;
+}
@@ -0,0 +1,119 @@
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "time.h"
+
+#define LIVE_OBJECTS 2000
+#define ROUNDS 50000
+#define MAX_OBJECT_SIZE 512
+#define LARGE_OBJECTS 16
+#define LARGE_OBJECT_SIZE (64 * 1024)
+
+static char* objects[LIVE_OBJECTS];
+static size_t sizes[LIVE_OBJECTS];
+static char* large_objects[LARGE_OBJECTS];
+static unsigned long random_state = 12345;
+
+static unsigned long nextRandom()
+{
+  random_state = random_state * 1103515245 + 12345;
+  return (random_state >> 16) & 0x7FFF;
+}
+
+static int allocObject(size_t i, size_t size)
+{
+  objects[i] = malloc(size);
+  if (!objects[i])
+    return -1;
+  sizes[i] = size;
+  memset(objects[i], (char) i, size);
+  return 0;
+}
+
+static int checkObject(size_t i)
+{
+  for (size_t j = 0; j < sizes[i]; ++j)
+  {
+    if (objects[i][j] != (char) i)
+    {
+      printf("malloc: object %lu is corrupted at byte %lu\n", i, j);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int main()
+{
+  struct timespec start, end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (size_t i = 0; i < LIVE_OBJECTS; ++i)
+  {
+    if (allocObject(i, 1 + nextRandom() % MAX_OBJECT_SIZE))
+    {
+      printf("malloc: out of memory while filling the heap\n");
+      return -1;
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  printf("malloc: %d allocations in %ld us\n", LIVE_OBJECTS, timespec_elapsed_us(&start, &end));
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (size_t round = 0; round < ROUNDS; ++round)
+  {
+    size_t victim = nextRandom() % LIVE_OBJECTS;
+    if (round % 8 == 0)
+    {
+      // grow or shrink the object, realloc has to keep its content
+      size_t size = 1 + nextRandom() % MAX_OBJECT_SIZE;
+      char* object = realloc(objects[victim], size);
+      if (!object)
+      {
+        printf("malloc: realloc failed\n");
+        return -1;
+      }
+      objects[victim] = object;
+      if (size > sizes[victim])
+        memset(object + sizes[victim], (char) victim, size - sizes[victim]);
+      sizes[victim] = size;
+    }
+    else
+    {
+      free(objects[victim]);
+      if (allocObject(victim, 1 + nextRandom() % MAX_OBJECT_SIZE))
+      {
+        printf("malloc: out of memory while replacing objects\n");
+        return -1;
+      }
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  printf("malloc: %d free+malloc or realloc rounds in %ld us\n", ROUNDS, timespec_elapsed_us(&start, &end));
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (size_t i = 0; i < LARGE_OBJECTS; ++i)
+  {
+    large_objects[i] = malloc(LARGE_OBJECT_SIZE);
+    if (!large_objects[i])
+    {
+      printf("malloc: out of memory for large objects\n");
+      return -1;
+    }
+    memset(large_objects[i], 0xAB, LARGE_OBJECT_SIZE);
+  }
+  for (size_t i = 0; i < LARGE_OBJECTS; ++i)
+    free(large_objects[LARGE_OBJECTS - 1 - i]);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  printf("malloc: %d large objects of %d bytes allocated, touched and freed in %ld us\n", LARGE_OBJECTS,
+         LARGE_OBJECT_SIZE, timespec_elapsed_us(&start, &end));
+
+  int corrupted = 0;
+  for (size_t i = 0; i < LIVE_OBJECTS; ++i)
+  {
+    corrupted |= checkObject(i);
+    free(objects[i]);
+  }
+  printf("malloc: %s\n", corrupted ? "FAILED" : "all objects intact");
+  return corrupted;
+}
@@ -0,0 +1,40 @@
+#include "stdio.h"
+#include "time.h"
+
+#define ROUNDS 10
+
+static long elapsedNs(struct timespec* start, struct timespec* end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000000000L + (end->tv_nsec - start->tv_nsec);
+}
+
+int main()
+{
+  const long durations[] = { 100000, 500000, 1000000, 10000000, 100000000 };
+  struct timespec start, end;
+
+  for (unsigned int i = 0; i < sizeof(durations) / sizeof(durations[0]); ++i)
+  {
+    struct timespec duration = { 0, durations[i] };
+    long min = -1, max = 0, sum = 0;
+    for (int round = 0; round < ROUNDS; ++round)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      nanosleep(&duration, 0);
+      clock_gettime(CLOCK_MONOTONIC, &end);
+      long slept = elapsedNs(&start, &end);
+      if (slept < durations[i])
+        printf("sleep: woke up too early, %ld ns instead of %ld ns\n", slept, durations[i]);
+      if (min < 0 || slept < min)
+        min = slept;
+      if (slept > max)
+        max = slept;
+      sum += slept;
+    }
+    printf("sleep: %9ld ns requested, slept min %9ld avg %9ld max %9ld ns\n", durations[i], min, sum / ROUNDS, max);
+  }
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+  printf("sleep: used %ld us of cpu time\n", end.tv_sec * 1000000L + end.tv_nsec / 1000);
+  return 0;
+}
@@ -0,0 +1,47 @@
+#include "stdio.h"
+#include "stdlib.h"
+#include "time.h"
+#include "unistd.h"
+#include "sched.h"
+
+#define YIELDS 20000
+#define TOUCHED_PAGES 64
+#define PAGE_SIZE 4096
+
+/**
+ * two processes yield to each other, so nearly every yield switches the address space.
+ * Both touch a few pages in between, the switches are cheaper if their TLB entries survive.
+ */
+int main()
+{
+  char* pages = malloc(TOUCHED_PAGES * PAGE_SIZE);
+  if (!pages)
+  {
+    printf("yield: out of memory\n");
+    return -1;
+  }
+  for (size_t offset = 0; offset < TOUCHED_PAGES * PAGE_SIZE; offset += PAGE_SIZE)
+    pages[offset] = 1;
+
+  pid_t pid = fork();
+  if (pid < 0)
+  {
+    printf("yield: fork failed\n");
+    return -1;
+  }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < YIELDS; ++i)
+  {
+    sched_yield();
+    for (size_t offset = 0; offset < TOUCHED_PAGES * PAGE_SIZE; offset += PAGE_SIZE)
+      pages[offset] += pages[offset + PAGE_SIZE / 2];
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  long us = timespec_elapsed_us(&start, &end);
+  printf("yield: %s did %d yields in %ld us, %ld ns per yield\n", pid ? "parent" : "child", YIELDS, us,
+         us * 1000 / YIELDS);
+  free(pages);
+  return 0;
+}
@@ -8,6 +8,7 @@
 
 #include "Dentry.h"
 #include "FileSystemInfo.h"
+#include "FileDescriptorTable.h"
 #include "Superblock.h"
 #include "MinixFSSuperblock.h"
 #include "VfsSyscall.h"
@@ -19,6 +20,9 @@ VfsMount vfs_dummy_;
 
 FileSystemInfo* getcwd() { return default_working_dir; }
 
+FileDescriptorTable fd_table;
+FileDescriptorTable* getFdTable() { return &fd_table; }
+
 // obviously NOT atomic, we need this for compatability in single threaded host code
 size_t atomic_add(size_t& x,size_t y)
 {